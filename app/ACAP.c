@@ -750,7 +750,8 @@ cJSON* ACAP_STATUS(void) {
     return status_container;
 }
 
-cJSON* ACAP_STATUS_Group(const char* name) {
+/* Internal helper: get or create a group, status_mutex held */
+static cJSON* status_group(const char* name) {
     if (!name || !status_container)
         return NULL;
 
@@ -766,20 +767,27 @@ cJSON* ACAP_STATUS_Group(const char* name) {
     return group;
 }
 
+cJSON* ACAP_STATUS_Group(const char* name) {
+    pthread_mutex_lock(&status_mutex);
+    cJSON* group = status_group(name);
+    pthread_mutex_unlock(&status_mutex);
+    return group;
+}
+
 /* Internal helper: set a value in a status group (thread-safe) */
 static void status_set_item(const char* group, const char* name, cJSON* value) {
     if (!group || !name || !value) {
         cJSON_Delete(value);
         return;
     }
-    cJSON* groupObj = ACAP_STATUS_Group(group);
-    if (!groupObj) {
+    pthread_mutex_lock(&status_mutex);
+    cJSON* groupObj = status_group(group);
+    if (groupObj) {
+        cJSON_DeleteItemFromObject(groupObj, name);
+        cJSON_AddItemToObject(groupObj, name, value);
+    } else {
         cJSON_Delete(value);
-        return;
     }
-    pthread_mutex_lock(&status_mutex);
-    cJSON_DeleteItemFromObject(groupObj, name);
-    cJSON_AddItemToObject(groupObj, name, value);
     pthread_mutex_unlock(&status_mutex);
 }
 
@@ -805,29 +813,58 @@ void ACAP_STATUS_SetNull(const char* group, const char* name) {
     status_set_item(group, name, cJSON_CreateNull());
 }
 
+void ACAP_STATUS_Append(const char* group, const char* name, cJSON* item, int max) {
+    if (!group || !name || !item) {
+        cJSON_Delete(item);
+        return;
+    }
+    pthread_mutex_lock(&status_mutex);
+    cJSON* groupObj = status_group(group);
+    cJSON* list = groupObj ? cJSON_GetObjectItem(groupObj, name) : NULL;
+    if (groupObj && !cJSON_IsArray(list)) {
+        cJSON_DeleteItemFromObject(groupObj, name);
+        list = cJSON_CreateArray();
+        cJSON_AddItemToObject(groupObj, name, list);
+    }
+    if (list) {
+        cJSON_AddItemToArray(list, item);
+        while (max > 0 && cJSON_GetArraySize(list) > max)
+            cJSON_DeleteItemFromArray(list, 0);
+    } else {
+        cJSON_Delete(item);
+    }
+    pthread_mutex_unlock(&status_mutex);
+}
+
 /*-----------------------------------------------------
  * Status Getters
  *-----------------------------------------------------*/
 
 int ACAP_STATUS_Bool(const char* group, const char* name) {
-    cJSON* groupObj = ACAP_STATUS_Group(group);
-    if (!groupObj) return 0;
-    cJSON* item = cJSON_GetObjectItem(groupObj, name);
-    return (item && item->type == cJSON_True) ? 1 : 0;
+    pthread_mutex_lock(&status_mutex);
+    cJSON* groupObj = status_group(group);
+    cJSON* item = groupObj ? cJSON_GetObjectItem(groupObj, name) : NULL;
+    int value = (item && item->type == cJSON_True) ? 1 : 0;
+    pthread_mutex_unlock(&status_mutex);
+    return value;
 }
 
 int ACAP_STATUS_Int(const char* group, const char* name) {
-    cJSON* groupObj = ACAP_STATUS_Group(group);
-    if (!groupObj) return 0;
-    cJSON* item = cJSON_GetObjectItem(groupObj, name);
-    return (item && cJSON_IsNumber(item)) ? item->valueint : 0;
+    pthread_mutex_lock(&status_mutex);
+    cJSON* groupObj = status_group(group);
+    cJSON* item = groupObj ? cJSON_GetObjectItem(groupObj, name) : NULL;
+    int value = (item && cJSON_IsNumber(item)) ? item->valueint : 0;
+    pthread_mutex_unlock(&status_mutex);
+    return value;
 }
 
 double ACAP_STATUS_Double(const char* group, const char* name) {
-    cJSON* groupObj = ACAP_STATUS_Group(group);
-    if (!groupObj) return 0.0;
-    cJSON* item = cJSON_GetObjectItem(groupObj, name);
-    return (item && cJSON_IsNumber(item)) ? item->valuedouble : 0.0;
+    pthread_mutex_lock(&status_mutex);
+    cJSON* groupObj = status_group(group);
+    cJSON* item = groupObj ? cJSON_GetObjectItem(groupObj, name) : NULL;
+    double value = (item && cJSON_IsNumber(item)) ? item->valuedouble : 0.0;
+    pthread_mutex_unlock(&status_mutex);
+    return value;
 }
 
 char* ACAP_STATUS_String(const char* group, const char* name) {
@@ -646,6 +646,7 @@ double ACAP_DEVICE_Network_Average(void);
 
 /**
  * @brief Get or create a status group.
+ * Points into the status tree; use from the main loop only.
  * @param name Group name
  * @return cJSON object for the group (internally managed, do NOT delete)
  */
@@ -677,6 +678,7 @@ double ACAP_STATUS_Double(const char* group, const char* name);
 
 /**
  * @brief Get a string status value.
+ * Points into the status tree; use from the main loop only.
  * @param group Group name
  * @param name Property name
  * @return String value (internally managed, do NOT free), or NULL
@@ -685,6 +687,7 @@ char* ACAP_STATUS_String(const char* group, const char* name);
 
 /**
  * @brief Get a cJSON object status value.
+ * Points into the status tree; use from the main loop only.
  * @param group Group name
  * @param name Property name
  * @return cJSON object (internally managed, do NOT delete), or NULL
@@ -732,6 +735,15 @@ void ACAP_STATUS_SetObject(const char* group, const char* name, cJSON* data);
  */
 void ACAP_STATUS_SetNull(const char* group, const char* name);
 
+/**
+ * @brief Append to a status array, dropping the oldest items beyond max.
+ * @param group Group name
+ * @param name Property name (replaced by an array if it holds anything else)
+ * @param item Item to append (ownership is taken)
+ * @param max Maximum array size, 0 for no limit
+ */
+void ACAP_STATUS_Append(const char* group, const char* name, cJSON* item, int max);
+
 /*=====================================================
  * VAPIX API
  *
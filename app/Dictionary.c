@@ -0,0 +1,236 @@
+/*------------------------------------------------------------------
+ *  Dictionary.c
+ *  Fred Juhlin (2025)
+ *------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <syslog.h>
+#include <glib.h>
+#include "Dictionary.h"
+#include "IdMap.h"
+
+#define LOG(fmt, args...) { syslog(LOG_INFO, fmt, ## args); printf(fmt, ## args); }
+#define LOG_WARN(fmt, args...) { syslog(LOG_WARNING, fmt, ## args); printf(fmt, ## args); }
+//#define LOG_TRACE(fmt, args...) { syslog(LOG_INFO, fmt, ## args); printf(fmt, ## args); }
+#define LOG_TRACE(fmt, args...) {}
+
+typedef struct {
+    const char *key;
+    const char *value;
+} NameMapEntry;
+
+static const NameMapEntry name_map[] = {
+    { "car", "Car" },
+    { "truck", "Truck" },
+    { "motorcycle_bicycle", "Bike" },
+    { "bus", "Bus" },
+    { "truck","Truck" },
+    { "vehicle_other","Other" },
+    { "vehicle","Vehicle" },
+    { "license_plate", "LicensePlate" },
+    { "human", "Human" },
+    { "human_face", "Head" },
+    { "human_head", "Head" },
+    { "head", "Head" },
+    { "face", "Head" },
+    { "hat", "Hat" },
+    { "animal", "Animal" },
+    { "no_hat", "" },
+    { "hat_other", "Hat" },
+    { "hard_hat", "Helmet" },
+    { "bag", "Bag" },
+    { "bag_other", "Bag" },
+    { "backpack", "Bag" },
+    { "suitcase", "Bag" },
+    { "red", "Red" },
+    { "blue", "Blue" },
+    { "black", "Black" },
+    { "white", "White" },
+    { "green", "Green" },
+    { "beige", "Beige" },
+    { "yellow", "Yellow" },
+    { "gray", "Gray" },
+    { "trailer_experimental", "Trailer" },
+    { "trailer", "Trailer" },
+    { "unknown", "Unknown" }
+};
+
+#define NAME_MAP_SIZE (sizeof(name_map) / sizeof(name_map[0]))
+
+typedef struct {
+    char name[64];
+    const char *label;   // Points into name_map or at name
+} dict_name_t;
+
+// Append-only; an entry is complete before name_count covers it
+static dict_name_t names[DICT_MAX_NAMES];
+static gint name_count = 0;
+static GHashTable *name_index = NULL;   // name -> code
+static GMutex dict_mutex;
+
+// Detector id -> code. Rebuilt by Dictionary_Build.
+static idmap_t class_codes;
+static idmap_t attr_type_codes;
+static idmap_t attr_class_codes;   // (type_id << 16 | class_id) -> code
+
+static dict_code_t code_unknown = DICT_NONE;
+static dict_code_t code_unknown_type = DICT_NONE;
+static dict_code_t code_unknown_class = DICT_NONE;
+
+const char* NiceName(const char* input) {
+    if (!input) return NULL;
+    for (size_t i = 0; i < NAME_MAP_SIZE; ++i) {
+        if (strcmp(input, name_map[i].key) == 0) {
+            return name_map[i].value;
+        }
+    }
+    return input;
+}
+
+// Caller holds dict_mutex
+static dict_code_t intern_locked(const char *name) {
+    if (!name || !name[0]) return DICT_NONE;
+    if (!name_index) {
+        name_index = g_hash_table_new(g_str_hash, g_str_equal);
+        names[0].name[0] = '\0';
+        names[0].label = names[0].name;
+        g_atomic_int_set(&name_count, 1);
+    }
+    gpointer found = NULL;
+    if (g_hash_table_lookup_extended(name_index, name, NULL, &found))
+        return (dict_code_t)GPOINTER_TO_UINT(found);
+
+    int code = g_atomic_int_get(&name_count);
+    if (code >= DICT_MAX_NAMES) {
+        LOG_WARN("%s: Dictionary full, %s not interned\n", __func__, name);
+        return DICT_NONE;
+    }
+    dict_name_t *entry = &names[code];
+    strncpy(entry->name, name, sizeof(entry->name) - 1);
+    entry->name[sizeof(entry->name) - 1] = '\0';
+    entry->label = NiceName(entry->name);
+    g_hash_table_insert(name_index, entry->name, GUINT_TO_POINTER(code));
+    g_atomic_int_set(&name_count, code + 1);
+    return (dict_code_t)code;
+}
+
+dict_code_t Dictionary_Intern(const char *name) {
+    g_mutex_lock(&dict_mutex);
+    dict_code_t code = intern_locked(name);
+    g_mutex_unlock(&dict_mutex);
+    return code;
+}
+
+dict_code_t Dictionary_Lookup(const char *name) {
+    if (!name || !name[0]) return DICT_NONE;
+    dict_code_t code = DICT_NONE;
+    g_mutex_lock(&dict_mutex);
+    gpointer found = NULL;
+    if (name_index && g_hash_table_lookup_extended(name_index, name, NULL, &found))
+        code = (dict_code_t)GPOINTER_TO_UINT(found);
+    g_mutex_unlock(&dict_mutex);
+    return code;
+}
+
+int Dictionary_Count(void) {
+    return g_atomic_int_get(&name_count);
+}
+
+const char* Dictionary_Name(dict_code_t code) {
+    if (code >= (dict_code_t)g_atomic_int_get(&name_count)) return "";
+    return names[code].name;
+}
+
+const char* Dictionary_Label(dict_code_t code) {
+    if (code >= (dict_code_t)g_atomic_int_get(&name_count)) return "";
+    return names[code].label;
+}
+
+static void reset_lookups(void) {
+    IdMap_Free(&class_codes);
+    IdMap_Free(&attr_type_codes);
+    IdMap_Free(&attr_class_codes);
+}
+
+void Dictionary_Clear(void) {
+    g_mutex_lock(&dict_mutex);
+    reset_lookups();
+    g_mutex_unlock(&dict_mutex);
+}
+
+int Dictionary_Build(video_object_detection_subscriber_class_t **det_classes, int num_classes,
+                     const VOD__DetectorInformation *det_info) {
+    g_mutex_lock(&dict_mutex);
+    reset_lookups();
+    code_unknown = intern_locked("Unknown");
+    code_unknown_type = intern_locked("UnknownType");
+    code_unknown_class = intern_locked("UnknownClass");
+
+    int types = 0;
+    if (!IdMap_Init(&class_codes, num_classes > 0 ? num_classes : 1) ||
+        !IdMap_Init(&attr_type_codes, 16) ||
+        !IdMap_Init(&attr_class_codes, 64)) {
+        LOG_WARN("%s: Memory allocation failed\n", __func__);
+        reset_lookups();
+        g_mutex_unlock(&dict_mutex);
+        return -1;
+    }
+
+    for (int i = 0; det_classes && i < num_classes; ++i) {
+        int id = video_object_detection_subscriber_det_class_id(det_classes[i]);
+        const char *name = video_object_detection_subscriber_det_class_name(det_classes[i]);
+        if (id < 0 || !name || !name[0]) continue;
+        // First match wins, as with the previous linear scan
+        if (IdMap_Get(&class_codes, (uint32_t)id) != IDMAP_NONE) continue;
+        dict_code_t code = intern_locked(name);
+        if (code != DICT_NONE)
+            IdMap_Put(&class_codes, (uint32_t)id, code);
+    }
+
+    for (size_t t = 0; det_info && t < det_info->n_attribute_types; ++t) {
+        const VOD__AttributeType *type = det_info->attribute_types[t];
+        if (!type || IdMap_Get(&attr_type_codes, type->id) != IDMAP_NONE) continue;
+        types++;
+        dict_code_t type_code = (type->name && type->name[0]) ? intern_locked(type->name) : code_unknown_type;
+        IdMap_Put(&attr_type_codes, type->id, type_code);
+        if (type->id > 0xFFFF) {
+            LOG_WARN("%s: Attribute type id %u out of range\n", __func__, type->id);
+            continue;
+        }
+        for (size_t c = 0; c < type->n_classes; ++c) {
+            const VOD__AttributeClass *cls = type->classes[c];
+            if (!cls || cls->id > 0xFFFF) continue;
+            uint32_t key = (type->id << 16) | cls->id;
+            if (IdMap_Get(&attr_class_codes, key) != IDMAP_NONE) continue;
+            dict_code_t code = (cls->name && cls->name[0]) ? intern_locked(cls->name) : code_unknown_class;
+            IdMap_Put(&attr_class_codes, key, code);
+        }
+    }
+    int count = g_atomic_int_get(&name_count);
+    g_mutex_unlock(&dict_mutex);
+    LOG("Dictionary: %u classes, %d attribute types, %u attribute classes, %d names\n",
+        class_codes.count, types, attr_class_codes.count, count);
+    return count;
+}
+
+dict_code_t Dictionary_Class(uint32_t class_id) {
+    uint32_t code = IdMap_Get(&class_codes, class_id);
+    if (code == IDMAP_NONE) {
+        LOG_WARN("%s: Invalid class id %u\n", __func__, class_id);
+        return code_unknown;
+    }
+    return (dict_code_t)code;
+}
+
+dict_code_t Dictionary_Attribute_Type(uint32_t type_id) {
+    uint32_t code = IdMap_Get(&attr_type_codes, type_id);
+    return code == IDMAP_NONE ? code_unknown_type : (dict_code_t)code;
+}
+
+dict_code_t Dictionary_Attribute_Class(uint32_t type_id, uint32_t class_id) {
+    if (type_id > 0xFFFF || class_id > 0xFFFF) return code_unknown_class;
+    uint32_t code = IdMap_Get(&attr_class_codes, (type_id << 16) | class_id);
+    return code == IDMAP_NONE ? code_unknown_class : (dict_code_t)code;
+}
@@ -0,0 +1,64 @@
+/*------------------------------------------------------------------
+ *  Dictionary.h
+ *  Interned names for detector classes and attributes.
+ *
+ *  Every class, attribute type and attribute class name reported by the
+ *  detector is interned once into a small integer code together with its
+ *  display name (see NiceName). Codes are stable for the lifetime of the
+ *  application: a rebuild only refreshes the id -> code lookups, so codes
+ *  held by the pipeline never change meaning.
+ *  Fred Juhlin (2025)
+ *------------------------------------------------------------------*/
+
+#ifndef DICTIONARY_H
+#define DICTIONARY_H
+
+#include <stdint.h>
+#include "video_object_detection_subscriber.h"
+#include "video_object_detection.pb-c.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef uint16_t dict_code_t;
+
+#define DICT_NONE       0       // Empty name
+#define DICT_MAX_NAMES  1024
+
+/**
+ * Rebuild the class and attribute lookups from the detector information.
+ * Called by VOD with every channel lock held, so no lookup runs meanwhile.
+ * @return Number of interned names, or -1 on failure.
+ */
+int          Dictionary_Build(video_object_detection_subscriber_class_t **det_classes, int num_classes,
+                              const VOD__DetectorInformation *det_info);
+void         Dictionary_Clear(void);
+
+// Ingest lookups, called by the VOD processing threads with their channel
+// lock held; channels look up concurrently and the lookups only read.
+// Unknown ids map to "Unknown", "UnknownType" and "UnknownClass".
+dict_code_t  Dictionary_Class(uint32_t class_id);
+dict_code_t  Dictionary_Attribute_Type(uint32_t type_id);
+dict_code_t  Dictionary_Attribute_Class(uint32_t type_id, uint32_t class_id);
+
+/**
+ * Intern a name outside the detector vocabulary.
+ * @return Code, or DICT_NONE if the table is full.
+ */
+dict_code_t  Dictionary_Intern(const char *name);
+dict_code_t  Dictionary_Lookup(const char *name);
+
+// Codes in use; codes below it are valid and the count only grows
+int          Dictionary_Count(void);
+const char*  Dictionary_Name(dict_code_t code);     // Detector name, e.g. "motorcycle_bicycle"
+const char*  Dictionary_Label(dict_code_t code);    // Display name, e.g. "Bike"
+
+// Display name of an arbitrary string; returns input if it has no mapping
+const char*  NiceName(const char *input);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DICTIONARY_H
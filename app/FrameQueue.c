@@ -0,0 +1,224 @@
+/*------------------------------------------------------------------
+ *  FrameQueue.c
+ *  Fred Juhlin (2025)
+ *------------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include "FrameQueue.h"
+
+#define FRAME_NONE 0xFFFFFFFFu
+
+static guint pow2_at_least(guint n) {
+    guint size = 1;
+    while (size < n) size <<= 1;
+    return size;
+}
+
+static inline guint load(volatile gint *counter) {
+    return (guint)g_atomic_int_get(counter);
+}
+
+static inline void store(volatile gint *counter, guint value) {
+    g_atomic_int_set(counter, (gint)value);
+}
+
+int FrameQueue_Init(frame_queue_t *queue, guint depth, int policy) {
+    if (!queue) return 0;
+    memset(queue, 0, sizeof(*queue));
+    if (depth < FRAME_QUEUE_MIN_DEPTH) depth = FRAME_QUEUE_MIN_DEPTH;
+    if (depth > FRAME_QUEUE_MAX_DEPTH) depth = FRAME_QUEUE_MAX_DEPTH;
+    queue->policy = policy;
+    queue->depth = depth;
+    // Queued frames + one being processed + one being decoded
+    queue->pool_size = depth + 2;
+    queue->ring_mask = pow2_at_least(depth) - 1;
+    queue->free_mask = pow2_at_least(queue->pool_size) - 1;
+
+    queue->frames = calloc(queue->pool_size, sizeof(scene_frame_t));
+    queue->received = calloc(queue->pool_size, sizeof(gint64));
+    queue->ring = calloc(queue->ring_mask + 1, sizeof(gint));
+    queue->free_ring = calloc(queue->free_mask + 1, sizeof(guint));
+    if (!queue->frames || !queue->received || !queue->ring || !queue->free_ring) {
+        FrameQueue_Free(queue);
+        return 0;
+    }
+    for (guint i = 0; i < queue->pool_size; ++i) {
+        Scene_Frame_Init(&queue->frames[i]);
+        queue->free_ring[i] = i;
+    }
+    store(&queue->free_head, queue->pool_size);
+    Scene_Frame_Init(&queue->carry);
+    queue->spare = FRAME_NONE;
+    queue->active = FRAME_NONE;
+    sem_init(&queue->available, 0, 0);
+    return 1;
+}
+
+void FrameQueue_Free(frame_queue_t *queue) {
+    if (!queue) return;
+    if (queue->frames) {
+        for (guint i = 0; i < queue->pool_size; ++i)
+            Scene_Frame_Free(&queue->frames[i]);
+        sem_destroy(&queue->available);
+    }
+    Scene_Frame_Free(&queue->carry);
+    free(queue->frames);
+    free(queue->received);
+    free((gint *)queue->ring);
+    free(queue->free_ring);
+    memset(queue, 0, sizeof(*queue));
+}
+
+// Producer: take a released frame
+static guint free_pop(frame_queue_t *queue) {
+    guint tail = load(&queue->free_tail);
+    if (tail == load(&queue->free_head)) return FRAME_NONE;
+    guint index = queue->free_ring[tail & queue->free_mask];
+    store(&queue->free_tail, tail + 1);
+    return index;
+}
+
+// Consumer: hand a frame back to the producer
+static void free_push(frame_queue_t *queue, guint index) {
+    guint head = load(&queue->free_head);
+    queue->free_ring[head & queue->free_mask] = index;
+    store(&queue->free_head, head + 1);
+}
+
+// Claim the oldest queued frame. Both sides race for it with CAS on tail.
+static guint claim_oldest(frame_queue_t *queue) {
+    for (;;) {
+        guint tail = load(&queue->tail);
+        if (tail == load(&queue->head)) return FRAME_NONE;
+        // May read a slot the producer is refilling; the CAS then fails
+        guint index = load(&queue->ring[tail & queue->ring_mask]);
+        if (g_atomic_int_compare_and_exchange(&queue->tail, (gint)tail, (gint)(tail + 1)))
+            return index;
+    }
+}
+
+// Producer: drop the oldest queued frame, keeping its events
+static guint drop_oldest(frame_queue_t *queue) {
+    guint index = claim_oldest(queue);
+    if (index == FRAME_NONE) return FRAME_NONE;
+    Scene_Frame_Append_Events(&queue->carry, &queue->frames[index]);
+    g_atomic_int_inc(&queue->dropped);
+    return index;
+}
+
+scene_frame_t* FrameQueue_Acquire(frame_queue_t *queue) {
+    if (queue->spare == FRAME_NONE)
+        queue->spare = free_pop(queue);
+    if (queue->spare == FRAME_NONE)
+        queue->spare = drop_oldest(queue);
+    if (queue->spare == FRAME_NONE) {
+        g_atomic_int_inc(&queue->rejected);
+        return NULL;
+    }
+    return &queue->frames[queue->spare];
+}
+
+void FrameQueue_Push(frame_queue_t *queue, gint64 received_us) {
+    guint index = queue->spare;
+    if (index == FRAME_NONE) return;
+
+    guint next = FRAME_NONE;
+    if (load(&queue->head) - load(&queue->tail) >= queue->depth)
+        next = drop_oldest(queue);
+
+    scene_frame_t *frame = &queue->frames[index];
+    if (queue->carry.num_events) {
+        Scene_Frame_Append_Events(frame, &queue->carry);
+        queue->carry.num_events = 0;
+    }
+    queue->received[index] = received_us;
+
+    guint head = load(&queue->head);
+    store(&queue->ring[head & queue->ring_mask], index);
+    store(&queue->head, head + 1);
+    queue->spare = next;
+    g_atomic_int_inc(&queue->pushed);
+
+    guint queued = head + 1 - load(&queue->tail);
+    if (queued <= queue->depth && queued > load(&queue->high_water))
+        store(&queue->high_water, queued);
+    sem_post(&queue->available);
+}
+
+scene_frame_t* FrameQueue_Pop(frame_queue_t *queue) {
+    guint index = FRAME_NONE;
+    while (index == FRAME_NONE) {
+        if (g_atomic_int_get(&queue->stopped)) return NULL;
+        index = claim_oldest(queue);
+        if (index != FRAME_NONE) break;
+        if (g_atomic_int_get(&queue->woken)) return NULL;
+        while (sem_wait(&queue->available) != 0 && errno == EINTR);
+    }
+
+    if (queue->policy == FRAME_QUEUE_COALESCE) {
+        guint newer;
+        while ((newer = claim_oldest(queue)) != FRAME_NONE) {
+            // Older delete events still have to be applied
+            Scene_Frame_Append_Events(&queue->frames[newer], &queue->frames[index]);
+            free_push(queue, index);
+            g_atomic_int_inc(&queue->coalesced);
+            index = newer;
+        }
+    }
+
+    gint64 lag = g_get_monotonic_time() - queue->received[index];
+    guint lag_us = lag < 0 ? 0 : (lag > G_MAXINT ? G_MAXINT : (guint)lag);
+    store(&queue->lag_us, lag_us);
+    if (lag_us > load(&queue->max_lag_us))
+        store(&queue->max_lag_us, lag_us);
+    queue->active = index;
+    return &queue->frames[index];
+}
+
+void FrameQueue_Release(frame_queue_t *queue) {
+    if (queue->active == FRAME_NONE) return;
+    free_push(queue, queue->active);
+    queue->active = FRAME_NONE;
+    g_atomic_int_inc(&queue->processed);
+}
+
+int FrameQueue_Woken(frame_queue_t *queue) {
+    return g_atomic_int_compare_and_exchange(&queue->woken, 1, 0);
+}
+
+void FrameQueue_Wake(frame_queue_t *queue) {
+    if (g_atomic_int_compare_and_exchange(&queue->woken, 0, 1))
+        sem_post(&queue->available);
+}
+
+void FrameQueue_Stop(frame_queue_t *queue) {
+    g_atomic_int_set(&queue->stopped, 1);
+    sem_post(&queue->available);
+}
+
+void FrameQueue_Stats(frame_queue_t *queue, frame_queue_stats_t *stats) {
+    memset(stats, 0, sizeof(*stats));
+    if (!queue || !queue->frames) return;
+    stats->depth = queue->depth;
+    stats->queued = load(&queue->head) - load(&queue->tail);
+    stats->high_water = load(&queue->high_water);
+    stats->pushed = load(&queue->pushed);
+    stats->processed = load(&queue->processed);
+    stats->dropped = load(&queue->dropped);
+    stats->coalesced = load(&queue->coalesced);
+    stats->rejected = load(&queue->rejected);
+    stats->lag_us = load(&queue->lag_us);
+    stats->max_lag_us = load(&queue->max_lag_us);
+}
+
+void FrameQueue_Reset_Max_Lag(frame_queue_t *queue) {
+    store(&queue->max_lag_us, 0);
+}
+
+int FrameQueue_Policy(const char *name) {
+    if (name && strcmp(name, "coalesce") == 0)
+        return FRAME_QUEUE_COALESCE;
+    return FRAME_QUEUE_DROP_OLDEST;
+}
@@ -0,0 +1,129 @@
+/*------------------------------------------------------------------
+ *  FrameQueue.h
+ *  Single-producer/single-consumer queue of decoded scene frames.
+ *
+ *  The subscriber callback (producer) decodes into a frame it owns and
+ *  pushes it; the processing thread (consumer) pops, processes and
+ *  releases it. Frames move between a fixed pool, the ring and a free
+ *  list by index, so neither side copies frames or takes a lock.
+ *
+ *  When the ring is full the producer drops the oldest queued frame.
+ *  With FRAME_QUEUE_COALESCE the consumer also skips to the latest queued
+ *  frame. Delete events of dropped or skipped frames are carried over to
+ *  the next processed frame so no object death is lost.
+ *
+ *  FrameQueue_Wake lets another thread hand the consumer work of its own
+ *  (e.g. a timer sweep while no frames arrive) without sharing its state.
+ *  Fred Juhlin (2025)
+ *------------------------------------------------------------------*/
+
+#ifndef FRAMEQUEUE_H
+#define FRAMEQUEUE_H
+
+#include <stdint.h>
+#include <semaphore.h>
+#include <glib.h>
+#include "Scene.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FRAME_QUEUE_DROP_OLDEST  0
+#define FRAME_QUEUE_COALESCE     1
+
+#define FRAME_QUEUE_MIN_DEPTH    2
+#define FRAME_QUEUE_MAX_DEPTH    256
+#define FRAME_QUEUE_DEFAULT_DEPTH 8
+
+typedef struct {
+    guint depth;         // Configured ring depth
+    guint queued;        // Frames currently waiting
+    guint high_water;    // Most frames ever waiting
+    guint pushed;
+    guint processed;
+    guint dropped;       // Oldest frames dropped by the producer on overflow
+    guint coalesced;     // Frames skipped by the consumer
+    guint rejected;      // Incoming frames with no free frame to decode into
+    guint lag_us;        // Queue latency of the last popped frame
+    guint max_lag_us;    // Largest queue latency since FrameQueue_Reset_Max_Lag
+} frame_queue_stats_t;
+
+typedef struct {
+    int policy;
+    guint depth;
+    guint pool_size;
+    scene_frame_t *frames;      // Pool, depth + 2 frames
+    gint64 *received;           // Push time per pool frame
+
+    // Ring of pool indices. head is written by the producer, tail is
+    // advanced by whichever side claims the oldest entry (CAS).
+    // Counters run freely; slot = counter & mask.
+    volatile gint *ring;
+    guint ring_mask;
+    volatile gint head;
+    volatile gint tail;
+
+    // Released frames, consumer -> producer
+    guint *free_ring;
+    guint free_mask;
+    volatile gint free_head;
+    volatile gint free_tail;
+
+    // Producer state
+    guint spare;                // Frame being decoded into
+    scene_frame_t carry;        // Events of frames dropped by the producer
+
+    // Consumer state
+    guint active;               // Frame being processed
+
+    sem_t available;
+    volatile gint stopped;
+    volatile gint woken;
+
+    // Counters
+    volatile gint pushed;
+    volatile gint processed;
+    volatile gint dropped;
+    volatile gint coalesced;
+    volatile gint rejected;
+    volatile gint high_water;
+    volatile gint lag_us;
+    volatile gint max_lag_us;
+} frame_queue_t;
+
+/**
+ * @param depth   Ring depth, clamped to [FRAME_QUEUE_MIN_DEPTH..FRAME_QUEUE_MAX_DEPTH]
+ * @param policy  FRAME_QUEUE_DROP_OLDEST or FRAME_QUEUE_COALESCE
+ * @return 1 on success, 0 on allocation failure.
+ */
+int  FrameQueue_Init(frame_queue_t *queue, guint depth, int policy);
+void FrameQueue_Free(frame_queue_t *queue);
+
+// Producer
+scene_frame_t* FrameQueue_Acquire(frame_queue_t *queue);    // NULL if no frame is free
+void FrameQueue_Push(frame_queue_t *queue, gint64 received_us);
+
+// Consumer. Pop blocks until a frame is queued; NULL once stopped or
+// woken. Woken clears and returns the wake request.
+scene_frame_t* FrameQueue_Pop(frame_queue_t *queue);
+void FrameQueue_Release(frame_queue_t *queue);
+int  FrameQueue_Woken(frame_queue_t *queue);
+
+// Any thread. Requests coalesce until the consumer takes them.
+void FrameQueue_Wake(frame_queue_t *queue);
+void FrameQueue_Stop(frame_queue_t *queue);
+void FrameQueue_Stats(frame_queue_t *queue, frame_queue_stats_t *stats);
+void FrameQueue_Reset_Max_Lag(frame_queue_t *queue);
+
+/**
+ * Parse an overflow policy name ("drop-oldest" or "coalesce").
+ * @return Policy, FRAME_QUEUE_DROP_OLDEST for unknown names.
+ */
+int  FrameQueue_Policy(const char *name);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FRAMEQUEUE_H
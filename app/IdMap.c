@@ -0,0 +1,154 @@
+/*------------------------------------------------------------------
+ *  IdMap.c
+ *  Fred Juhlin (2025)
+ *------------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include <string.h>
+#include "IdMap.h"
+
+#define IDMAP_MIN_SLOTS 16
+
+// murmur3 finalizer; spreads sequential tracker ids over the low bits
+static inline uint32_t idmap_hash(uint32_t id) {
+    id ^= id >> 16;
+    id *= 0x85ebca6bu;
+    id ^= id >> 13;
+    id *= 0xc2b2ae35u;
+    id ^= id >> 16;
+    return id;
+}
+
+static int idmap_alloc(idmap_t *map, uint32_t slots) {
+    uint32_t *keys = malloc(slots * sizeof(uint32_t));
+    uint32_t *values = malloc(slots * sizeof(uint32_t));
+    if (!keys || !values) {
+        free(keys);
+        free(values);
+        return 0;
+    }
+    memset(values, 0xFF, slots * sizeof(uint32_t));
+    map->keys = keys;
+    map->values = values;
+    map->mask = slots - 1;
+    map->count = 0;
+    return 1;
+}
+
+int IdMap_Init(idmap_t *map, uint32_t capacity) {
+    if (!map) return 0;
+    memset(map, 0, sizeof(*map));
+    uint32_t slots = IDMAP_MIN_SLOTS;
+    while (slots < capacity * 2) slots <<= 1;
+    return idmap_alloc(map, slots);
+}
+
+void IdMap_Free(idmap_t *map) {
+    if (!map) return;
+    free(map->keys);
+    free(map->values);
+    map->keys = NULL;
+    map->values = NULL;
+    map->mask = 0;
+    map->count = 0;
+}
+
+void IdMap_Clear(idmap_t *map) {
+    if (!map || !map->values) return;
+    memset(map->values, 0xFF, (map->mask + 1) * sizeof(uint32_t));
+    map->count = 0;
+}
+
+static int idmap_grow(idmap_t *map) {
+    uint32_t *old_keys = map->keys;
+    uint32_t *old_values = map->values;
+    uint32_t old_slots = map->mask + 1;
+    if (!idmap_alloc(map, old_slots * 2)) {
+        map->keys = old_keys;
+        map->values = old_values;
+        return 0;
+    }
+    for (uint32_t i = 0; i < old_slots; ++i) {
+        if (old_values[i] == IDMAP_NONE) continue;
+        uint32_t slot = idmap_hash(old_keys[i]) & map->mask;
+        while (map->values[slot] != IDMAP_NONE)
+            slot = (slot + 1) & map->mask;
+        map->keys[slot] = old_keys[i];
+        map->values[slot] = old_values[i];
+        map->count++;
+    }
+    free(old_keys);
+    free(old_values);
+    map->grows++;
+    return 1;
+}
+
+uint32_t IdMap_Find(idmap_t *map, uint32_t id) {
+    if (!map || !map->values) return IDMAP_NONE;
+    map->lookups++;
+    uint32_t slot = idmap_hash(id) & map->mask;
+    while (map->values[slot] != IDMAP_NONE) {
+        map->probes++;
+        if (map->keys[slot] == id)
+            return map->values[slot];
+        slot = (slot + 1) & map->mask;
+    }
+    return IDMAP_NONE;
+}
+
+uint32_t IdMap_Get(const idmap_t *map, uint32_t id) {
+    if (!map || !map->values) return IDMAP_NONE;
+    uint32_t slot = idmap_hash(id) & map->mask;
+    while (map->values[slot] != IDMAP_NONE) {
+        if (map->keys[slot] == id)
+            return map->values[slot];
+        slot = (slot + 1) & map->mask;
+    }
+    return IDMAP_NONE;
+}
+
+int IdMap_Put(idmap_t *map, uint32_t id, uint32_t value) {
+    if (!map || !map->values || value == IDMAP_NONE) return 0;
+    if ((map->count + 1) * 2 > map->mask + 1 && !idmap_grow(map))
+        return 0;
+    uint32_t slot = idmap_hash(id) & map->mask;
+    while (map->values[slot] != IDMAP_NONE) {
+        if (map->keys[slot] == id) {
+            map->values[slot] = value;
+            return 1;
+        }
+        slot = (slot + 1) & map->mask;
+    }
+    map->keys[slot] = id;
+    map->values[slot] = value;
+    map->count++;
+    map->inserts++;
+    return 1;
+}
+
+int IdMap_Remove(idmap_t *map, uint32_t id) {
+    if (!map || !map->values) return 0;
+    uint32_t slot = idmap_hash(id) & map->mask;
+    while (map->values[slot] != IDMAP_NONE && map->keys[slot] != id)
+        slot = (slot + 1) & map->mask;
+    if (map->values[slot] == IDMAP_NONE)
+        return 0;
+
+    // Backward-shift: pull later members of the probe chain into the hole
+    // unless that would move them in front of their home slot.
+    uint32_t hole = slot;
+    uint32_t next = (hole + 1) & map->mask;
+    while (map->values[next] != IDMAP_NONE) {
+        uint32_t home = idmap_hash(map->keys[next]) & map->mask;
+        if (((next - home) & map->mask) >= ((next - hole) & map->mask)) {
+            map->keys[hole] = map->keys[next];
+            map->values[hole] = map->values[next];
+            hole = next;
+        }
+        next = (next + 1) & map->mask;
+    }
+    map->values[hole] = IDMAP_NONE;
+    map->count--;
+    map->removes++;
+    return 1;
+}
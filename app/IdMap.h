@@ -0,0 +1,65 @@
+/*------------------------------------------------------------------
+ *  IdMap.h
+ *  Open-addressing map from 32-bit object ids to dense array indices.
+ *  Linear probing with backward-shift removal (no tombstones).
+ *  Fred Juhlin (2025)
+ *------------------------------------------------------------------*/
+
+#ifndef IDMAP_H
+#define IDMAP_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define IDMAP_NONE 0xFFFFFFFFu
+
+typedef struct {
+    uint32_t *keys;      // Object id per slot
+    uint32_t *values;    // Dense index per slot, IDMAP_NONE when slot is free
+    uint32_t  mask;      // Slot count - 1 (slot count is a power of two)
+    uint32_t  count;     // Occupied slots
+    // Counters
+    uint64_t  lookups;
+    uint64_t  probes;
+    uint64_t  inserts;
+    uint64_t  removes;
+    uint32_t  grows;
+} idmap_t;
+
+/**
+ * Initialize a map able to hold at least `capacity` ids before growing.
+ * @return 1 on success, 0 on allocation failure.
+ */
+int      IdMap_Init(idmap_t *map, uint32_t capacity);
+void     IdMap_Free(idmap_t *map);
+void     IdMap_Clear(idmap_t *map);
+
+/**
+ * @return Dense index stored for id, or IDMAP_NONE.
+ */
+uint32_t IdMap_Find(idmap_t *map, uint32_t id);
+
+// IdMap_Find without the counters, for maps read by several threads at once
+uint32_t IdMap_Get(const idmap_t *map, uint32_t id);
+
+/**
+ * Insert or update id -> value. Grows the table when the load exceeds 50%.
+ * @return 1 on success, 0 on allocation failure.
+ */
+int      IdMap_Put(idmap_t *map, uint32_t id, uint32_t value);
+
+/**
+ * Remove id. Following entries of the probe chain are shifted back.
+ * @return 1 if id was present.
+ */
+int      IdMap_Remove(idmap_t *map, uint32_t id);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IDMAP_H
@@ -0,0 +1,330 @@
+/*------------------------------------------------------------------
+ *  JsonWriter.c
+ *  Fred Juhlin (2025)
+ *------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <locale.h>
+#include <math.h>
+#include <float.h>
+#include "JsonWriter.h"
+
+static __thread json_writer_t thread_writer;
+
+static bool reserve(json_writer_t *w, size_t extra) {
+    if (w->failed) return false;
+    size_t needed = w->length + extra + 1;
+    if (needed <= w->capacity) return true;
+    size_t capacity = w->capacity ? w->capacity : 1024;
+    while (capacity < needed) capacity *= 2;
+    char *data = realloc(w->data, capacity);
+    if (!data) {
+        w->failed = true;
+        return false;
+    }
+    w->data = data;
+    w->capacity = capacity;
+    return true;
+}
+
+static void append(json_writer_t *w, const char *text, size_t length) {
+    if (!reserve(w, length)) return;
+    memcpy(w->data + w->length, text, length);
+    w->length += length;
+    w->data[w->length] = 0;
+}
+
+static void append_char(json_writer_t *w, char c) {
+    if (!reserve(w, 1)) return;
+    w->data[w->length++] = c;
+    w->data[w->length] = 0;
+}
+
+// Separator before a value or key at the current level
+static void separate(json_writer_t *w) {
+    if (w->key) {
+        w->key = false;
+        return;
+    }
+    uint32_t bit = 1u << (w->depth < JSON_WRITER_MAX_DEPTH ? w->depth : JSON_WRITER_MAX_DEPTH - 1);
+    if (w->members & bit)
+        append_char(w, ',');
+    w->members |= bit;
+}
+
+json_writer_t* JsonWriter_Thread(void) {
+    JsonWriter_Reset(&thread_writer);
+    return &thread_writer;
+}
+
+void JsonWriter_Reset(json_writer_t *w) {
+    w->length = 0;
+    w->depth = 0;
+    w->members = 0;
+    w->key = false;
+    w->failed = false;
+    if (w->data) w->data[0] = 0;
+}
+
+void JsonWriter_Free(json_writer_t *w) {
+    free(w->data);
+    memset(w, 0, sizeof(*w));
+}
+
+static void begin(json_writer_t *w, char c) {
+    separate(w);
+    append_char(w, c);
+    w->depth++;
+    if (w->depth < JSON_WRITER_MAX_DEPTH)
+        w->members &= ~(1u << w->depth);
+}
+
+static void end(json_writer_t *w, char c) {
+    if (w->depth) w->depth--;
+    append_char(w, c);
+}
+
+void JsonWriter_Object_Begin(json_writer_t *w) { begin(w, '{'); }
+void JsonWriter_Object_End(json_writer_t *w)   { end(w, '}'); }
+void JsonWriter_Array_Begin(json_writer_t *w)  { begin(w, '['); }
+void JsonWriter_Array_End(json_writer_t *w)    { end(w, ']'); }
+
+// Escapes as cJSON print_string_ptr; returns the quoted length
+static size_t quote(char *out, const char *value) {
+    const unsigned char *in = (const unsigned char*)(value ? value : "");
+    char *p = out;
+    *p++ = '"';
+    for (; *in; ++in) {
+        unsigned char c = *in;
+        if (c > 31 && c != '"' && c != '\\') {
+            *p++ = (char)c;
+            continue;
+        }
+        *p++ = '\\';
+        switch (c) {
+            case '\\': *p++ = '\\'; break;
+            case '"':  *p++ = '"'; break;
+            case '\b': *p++ = 'b'; break;
+            case '\f': *p++ = 'f'; break;
+            case '\n': *p++ = 'n'; break;
+            case '\r': *p++ = 'r'; break;
+            case '\t': *p++ = 't'; break;
+            default:
+                sprintf(p, "u%04x", c);
+                p += 5;
+                break;
+        }
+    }
+    *p++ = '"';
+    return (size_t)(p - out);
+}
+
+static void append_string(json_writer_t *w, const char *value) {
+    size_t length = value ? strlen(value) : 0;
+    // Worst case every byte becomes \u00XX
+    if (!reserve(w, length * 6 + 2)) return;
+    w->length += quote(w->data + w->length, value);
+    w->data[w->length] = 0;
+}
+
+size_t JsonWriter_Quote(char *buffer, size_t size, const char *value) {
+    size_t length = value ? strlen(value) : 0;
+    if (!buffer || length * 6 + 3 > size) return 0;
+    size_t written = quote(buffer, value);
+    buffer[written] = 0;
+    return written;
+}
+
+void JsonWriter_Key(json_writer_t *w, const char *key) {
+    separate(w);
+    append_string(w, key);
+    append_char(w, ':');
+    w->key = true;
+}
+
+void JsonWriter_String(json_writer_t *w, const char *value) {
+    separate(w);
+    append_string(w, value);
+}
+
+static void append_int(json_writer_t *w, long long value) {
+    char digits[24];
+    char *p = digits + sizeof(digits);
+    unsigned long long v = value < 0 ? 0ULL - (unsigned long long)value : (unsigned long long)value;
+    do {
+        *--p = (char)('0' + v % 10);
+        v /= 10;
+    } while (v);
+    if (value < 0) *--p = '-';
+    append(w, p, (size_t)(digits + sizeof(digits) - p));
+}
+
+void JsonWriter_Int(json_writer_t *w, int value) {
+    separate(w);
+    append_int(w, value);
+}
+
+void JsonWriter_Bool(json_writer_t *w, bool value) {
+    separate(w);
+    if (value)
+        append(w, "true", 4);
+    else
+        append(w, "false", 5);
+}
+
+void JsonWriter_Null(json_writer_t *w) {
+    separate(w);
+    append(w, "null", 4);
+}
+
+// valueint as cJSON stores it for a number
+static int saturate(double value) {
+    if (value >= INT_MAX) return INT_MAX;
+    if (value <= (double)INT_MIN) return INT_MIN;
+    return (int)value;
+}
+
+static bool same_double(double a, double b) {
+    double max = fabs(a) > fabs(b) ? fabs(a) : fabs(b);
+    return fabs(a - b) <= max * DBL_EPSILON;
+}
+
+static void append_number(json_writer_t *w, double value, int valueint) {
+    char number[26];
+    int length;
+    if (isnan(value) || isinf(value)) {
+        append(w, "null", 4);
+        return;
+    }
+    if (value == (double)valueint) {
+        append_int(w, valueint);
+        return;
+    }
+    double test = 0;
+    length = snprintf(number, sizeof(number), "%1.15g", value);
+    if (sscanf(number, "%lg", &test) != 1 || !same_double(test, value))
+        length = snprintf(number, sizeof(number), "%1.17g", value);
+    if (length < 0 || length >= (int)sizeof(number)) {
+        w->failed = true;
+        return;
+    }
+    char point = localeconv()->decimal_point[0];
+    if (point != '.') {
+        for (int i = 0; i < length; ++i)
+            if (number[i] == point) number[i] = '.';
+    }
+    append(w, number, (size_t)length);
+}
+
+void JsonWriter_Number(json_writer_t *w, double value) {
+    separate(w);
+    append_number(w, value, saturate(value));
+}
+
+void JsonWriter_Fixed(json_writer_t *w, double value, int decimals) {
+    static const double scale[] = { 1, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6 };
+    double magnitude = fabs(value);
+    // %1.15g switches to exponent notation or drops digits outside this range
+    if (decimals < 0 || decimals > 6 || value != value ||
+        (magnitude != 0 && magnitude < 1e-4) || magnitude * scale[decimals] >= 1e15) {
+        JsonWriter_Number(w, value);
+        return;
+    }
+    separate(w);
+    long long scaled = llround(value * scale[decimals]);
+    if (scaled == 0) {
+        append_char(w, '0');
+        return;
+    }
+    unsigned long long v = scaled < 0 ? 0ULL - (unsigned long long)scaled : (unsigned long long)scaled;
+    unsigned long long unit = (unsigned long long)scale[decimals];
+    unsigned long long fraction = v % unit;
+    if (scaled < 0) append_char(w, '-');
+    append_int(w, (long long)(v / unit));
+    if (!fraction) return;
+    char digits[8];
+    int n = decimals;
+    while (fraction % 10 == 0) {
+        fraction /= 10;
+        n--;
+    }
+    digits[0] = '.';
+    for (int i = n; i > 0; --i) {
+        digits[i] = (char)('0' + fraction % 10);
+        fraction /= 10;
+    }
+    append(w, digits, (size_t)n + 1);
+}
+
+void JsonWriter_JSON(json_writer_t *w, const cJSON *value) {
+    if (!value) {
+        w->failed = true;
+        return;
+    }
+    switch (value->type & 0xFF) {
+        case cJSON_NULL:
+            JsonWriter_Null(w);
+            break;
+        case cJSON_False:
+            JsonWriter_Bool(w, false);
+            break;
+        case cJSON_True:
+            JsonWriter_Bool(w, true);
+            break;
+        case cJSON_Number:
+            separate(w);
+            append_number(w, value->valuedouble, value->valueint);
+            break;
+        case cJSON_Raw:
+            if (!value->valuestring) {
+                w->failed = true;
+                break;
+            }
+            JsonWriter_Raw(w, value->valuestring, strlen(value->valuestring));
+            break;
+        case cJSON_String:
+            JsonWriter_String(w, value->valuestring);
+            break;
+        case cJSON_Array:
+            JsonWriter_Array_Begin(w);
+            for (const cJSON *item = value->child; item; item = item->next)
+                JsonWriter_JSON(w, item);
+            JsonWriter_Array_End(w);
+            break;
+        case cJSON_Object:
+            JsonWriter_Object_Begin(w);
+            for (const cJSON *item = value->child; item; item = item->next) {
+                JsonWriter_Key(w, item->string);
+                JsonWriter_JSON(w, item);
+            }
+            JsonWriter_Object_End(w);
+            break;
+        default:
+            w->failed = true;
+            break;
+    }
+}
+
+void JsonWriter_Raw(json_writer_t *w, const char *text, size_t length) {
+    separate(w);
+    append(w, text, length);
+}
+
+void JsonWriter_Object_Extend(json_writer_t *w, const char *members, size_t length) {
+    if (!length || w->failed) return;
+    if (w->depth || w->length < 2 || w->data[w->length - 1] != '}') {
+        w->failed = true;
+        return;
+    }
+    // An empty object takes the members without the leading comma
+    if (w->data[w->length - 2] == '{') {
+        members++;
+        length--;
+    }
+    w->length--;
+    append(w, members, length);
+    append_char(w, '}');
+}
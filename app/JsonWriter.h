@@ -0,0 +1,90 @@
+/*------------------------------------------------------------------
+ *  JsonWriter.h
+ *  Streaming JSON writer for published payloads.
+ *
+ *  Values are written straight into a growable buffer instead of being
+ *  built as a cJSON tree and printed. The output is byte-compatible
+ *  with cJSON_PrintUnformatted: same escaping, same number formatting.
+ *  Every thread has its own writer (JsonWriter_Thread) that is reused
+ *  from message to message, so publishing does not allocate once the
+ *  buffer has grown to the largest payload.
+ *
+ *  Typed payloads are described by field tables (X-macros) that expand
+ *  to JSON_WRITE_<kind>(writer, key, value), e.g.
+ *
+ *    #define TRACKER_FIELDS(FIELD) \
+ *        FIELD(STRING, "class", label) \
+ *        FIELD(INT,    "x",     x)
+ *
+ *  Fred Juhlin (2025)
+ *------------------------------------------------------------------*/
+
+#ifndef JSONWRITER_H
+#define JSONWRITER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "cJSON.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define JSON_WRITER_MAX_DEPTH 32
+
+typedef struct {
+    char *data;          // NUL terminated output
+    size_t length;
+    size_t capacity;
+    uint32_t depth;
+    uint32_t members;    // Bit per depth: a value has been written at that level
+    bool key;            // A key was written and its value is pending
+    bool failed;         // Allocation failed; the output is incomplete
+} json_writer_t;
+
+// The calling thread's writer, emptied. Valid until the thread's next call.
+json_writer_t* JsonWriter_Thread(void);
+void         JsonWriter_Reset(json_writer_t *w);
+void         JsonWriter_Free(json_writer_t *w);
+
+void         JsonWriter_Object_Begin(json_writer_t *w);
+void         JsonWriter_Object_End(json_writer_t *w);
+void         JsonWriter_Array_Begin(json_writer_t *w);
+void         JsonWriter_Array_End(json_writer_t *w);
+void         JsonWriter_Key(json_writer_t *w, const char *key);
+
+void         JsonWriter_String(json_writer_t *w, const char *value);
+void         JsonWriter_Int(json_writer_t *w, int value);
+void         JsonWriter_Bool(json_writer_t *w, bool value);
+void         JsonWriter_Null(json_writer_t *w);
+// Any double, formatted as cJSON does
+void         JsonWriter_Number(json_writer_t *w, double value);
+// A double already rounded to the given number of decimals (e.g. age,
+// lat/lon); same output as JsonWriter_Number without going through printf
+void         JsonWriter_Fixed(json_writer_t *w, double value, int decimals);
+// A cJSON value and everything below it
+void         JsonWriter_JSON(json_writer_t *w, const cJSON *value);
+// Text that is already JSON, inserted as is
+void         JsonWriter_Raw(json_writer_t *w, const char *text, size_t length);
+
+// Add preformatted members (",\"key\":value..." with leading comma) to the
+// complete object in w, before its closing brace
+void         JsonWriter_Object_Extend(json_writer_t *w, const char *members, size_t length);
+
+// Escaped, quoted string into buffer; returns the length or 0 if it does not fit
+size_t       JsonWriter_Quote(char *buffer, size_t size, const char *value);
+
+// Field table kinds
+#define JSON_WRITE_STRING(w, key, value)  (JsonWriter_Key(w, key), JsonWriter_String(w, value))
+#define JSON_WRITE_INT(w, key, value)     (JsonWriter_Key(w, key), JsonWriter_Int(w, value))
+#define JSON_WRITE_BOOL(w, key, value)    (JsonWriter_Key(w, key), JsonWriter_Bool(w, value))
+#define JSON_WRITE_NUMBER(w, key, value)  (JsonWriter_Key(w, key), JsonWriter_Number(w, value))
+#define JSON_WRITE_FIXED1(w, key, value)  (JsonWriter_Key(w, key), JsonWriter_Fixed(w, value, 1))
+#define JSON_WRITE_FIXED6(w, key, value)  (JsonWriter_Key(w, key), JsonWriter_Fixed(w, value, 6))
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // JSONWRITER_H
@@ -21,6 +21,7 @@ typedef struct MQTTPersistence_afterRead MQTTPersistence_afterRead;
 #include "MQTT.h"
 #include "MQTTAsync.h"
 #include "CERTS.h"
+#include "JsonWriter.h"
 
 #define LOG(fmt, ...) syslog(LOG_INFO, fmt, ##__VA_ARGS__); printf(fmt, ##__VA_ARGS__)
 #define LOG_WARN(fmt, ...) syslog(LOG_WARNING, fmt, ##__VA_ARGS__); printf(fmt, ##__VA_ARGS__)
@@ -70,6 +71,13 @@ static char LastWillTopic[64];
 static char LastWillMessage[512];
 static pthread_mutex_t config_mutex = PTHREAD_MUTEX_INITIALIZER;
 
+// Members added to every JSON payload: ,"name":...,"location":...,"serial":...
+// Built once and again when the payload settings change.
+static char payload_suffix[1024];
+static size_t payload_suffix_length = 0;
+static int payload_suffix_valid = 0;
+static pthread_mutex_t suffix_mutex = PTHREAD_MUTEX_INITIALIZER;
+
 // Private function prototypes
 static int MQTT_SetupClient();
 static void connectionLost(void* context, char* cause);
@@ -363,55 +371,87 @@ MQTT_Publish(const char *topic, const char *payload, int qos, int retained) {
     return (rc == MQTTASYNC_SUCCESS);
 }
 
+static void
+invalidate_payload_suffix(void) {
+    pthread_mutex_lock(&suffix_mutex);
+    payload_suffix_valid = 0;
+    pthread_mutex_unlock(&suffix_mutex);
+}
+
+static void
+add_suffix_member(const char *key, const char *value) {
+    char quoted[512];
+    size_t length = JsonWriter_Quote(quoted, sizeof(quoted), value);
+    size_t key_length = strlen(key);
+    if (!length || payload_suffix_length + key_length + length + 4 >= sizeof(payload_suffix)) {
+        LOG_WARN("%s: %s too long for the payload\n", __func__, key);
+        return;
+    }
+    char *p = payload_suffix + payload_suffix_length;
+    p += sprintf(p, ",\"%s\":", key);
+    memcpy(p, quoted, length + 1);
+    payload_suffix_length = (size_t)(p - payload_suffix) + length;
+}
+
+// Called with suffix_mutex held
+static void
+build_payload_suffix(void) {
+    payload_suffix_length = 0;
+    payload_suffix[0] = 0;
+    cJSON* additional = cJSON_GetObjectItem(MQTTSettings, "payload");
+    if (additional) {
+        cJSON* name_item = cJSON_GetObjectItem(additional, "name");
+        cJSON* location_item = cJSON_GetObjectItem(additional, "location");
+        if (name_item && name_item->valuestring && strlen(name_item->valuestring))
+            add_suffix_member("name", name_item->valuestring);
+        if (location_item && location_item->valuestring && strlen(location_item->valuestring))
+            add_suffix_member("location", location_item->valuestring);
+    }
+    const char* serial = ACAP_DEVICE_Prop("serial");
+    if (serial)
+        add_suffix_member("serial", serial);
+    payload_suffix_valid = 1;
+}
+
 int
-MQTT_Publish_JSON(const char *topic, cJSON *payload, int qos, int retained) {
+MQTT_Publish_Writer(const char *topic, json_writer_t *payload, int qos, int retained) {
 
     if (!mqtt_client || !mqtt.isConnected(mqtt_client)) {
         return 0;
     }
-    
-    if (!payload) {
-        LOG_WARN("%s: %s NULL payload\n", __func__, topic);
+
+    if (!payload || payload->failed) {
+        LOG_WARN("%s: %s Invalid payload\n", __func__, topic);
         return 0;
     }
 
-    cJSON* publish = cJSON_Duplicate(payload, 1);
-    if (!publish) {
-        LOG_WARN("%s: Failed to duplicate JSON\n", __func__);
+    pthread_mutex_lock(&suffix_mutex);
+    if (!payload_suffix_valid)
+        build_payload_suffix();
+    JsonWriter_Object_Extend(payload, payload_suffix, payload_suffix_length);
+    pthread_mutex_unlock(&suffix_mutex);
+    if (payload->failed) {
+        LOG_WARN("%s: Failed to serialize JSON\n", __func__);
         return 0;
     }
-    
-    cJSON* additional = cJSON_GetObjectItem(MQTTSettings, "payload");
-    if(additional) {
-        // Fixed: Proper NULL checking
-        cJSON* name_item = cJSON_GetObjectItem(additional, "name");
-        cJSON* location_item = cJSON_GetObjectItem(additional, "location");
-        
-        if(name_item && name_item->valuestring && strlen(name_item->valuestring)) {
-            cJSON_AddStringToObject(publish, "name", name_item->valuestring);
-        }
-        if(location_item && location_item->valuestring && strlen(location_item->valuestring)) {
-            cJSON_AddStringToObject(publish, "location", location_item->valuestring);
-        }
-    }
-    
-    const char* serial = ACAP_DEVICE_Prop("serial");
-    if (serial) {
-        cJSON_AddStringToObject(publish, "serial", serial);
+    return MQTT_Publish(topic, payload->data, qos, retained);
+}
+
+int
+MQTT_Publish_JSON(const char *topic, cJSON *payload, int qos, int retained) {
+
+    if (!mqtt_client || !mqtt.isConnected(mqtt_client)) {
+        return 0;
     }
     
-    char* json = cJSON_PrintUnformatted(publish);
-    int result = 0;
-    
-    if (json) {
-        result = MQTT_Publish(topic, json, qos, retained);
-        free(json);
-    } else {
-        LOG_WARN("%s: Failed to serialize JSON\n", __func__);
+    if (!payload) {
+        LOG_WARN("%s: %s NULL payload\n", __func__, topic);
+        return 0;
     }
-    
-    cJSON_Delete(publish);
-    return result;
+
+    json_writer_t *writer = JsonWriter_Thread();
+    JsonWriter_JSON(writer, payload);
+    return MQTT_Publish_Writer(topic, writer, qos, retained);
 }
 
 int
@@ -456,20 +496,36 @@ MQTT_Publish_Binary(const char *topic, int payloadlen, void *payload, int qos, i
     return (rc == MQTTASYNC_SUCCESS);
 }
 
+// Subscribe/unsubscribe use the same preTopic prefix as MQTT_Publish
+static int
+MQTT_Topic(char *fullTopic, size_t size, const char *topic) {
+    cJSON* preTopic_item = cJSON_GetObjectItem(MQTTSettings, "preTopic");
+    int result;
+    if (preTopic_item && preTopic_item->valuestring && strlen(preTopic_item->valuestring))
+        result = snprintf(fullTopic, size, "%s/%s", preTopic_item->valuestring, topic);
+    else
+        result = snprintf(fullTopic, size, "%s", topic);
+    return result > 0 && (size_t)result < size;
+}
+
 int
 MQTT_Subscribe(const char *topic) {
     if (!mqtt.isConnected(mqtt_client)) return 0;
 
+    char fullTopic[256];
+    if (!MQTT_Topic(fullTopic, sizeof(fullTopic), topic)) return 0;
     MQTTAsync_responseOptions opts = MQTTAsync_responseOptions_initializer;
-    return (mqtt.subscribe(mqtt_client, topic, 0, &opts) == MQTTASYNC_SUCCESS);
+    return (mqtt.subscribe(mqtt_client, fullTopic, 0, &opts) == MQTTASYNC_SUCCESS);
 }
 
 int
 MQTT_Unsubscribe(const char *topic) {
     if (!mqtt.isConnected(mqtt_client)) return 0;
 
+    char fullTopic[256];
+    if (!MQTT_Topic(fullTopic, sizeof(fullTopic), topic)) return 0;
     MQTTAsync_responseOptions opts = MQTTAsync_responseOptions_initializer;
-    return (mqtt.unsubscribe(mqtt_client, topic, &opts) == MQTTASYNC_SUCCESS);
+    return (mqtt.unsubscribe(mqtt_client, fullTopic, &opts) == MQTTASYNC_SUCCESS);
 }
 
 static int
@@ -569,7 +625,6 @@ static void connectionLost(void* context, char* cause) {
 
 static int
 messageArrived(void* context, char* topicName, int topicLen, MQTTAsync_message* message) {
-/*	
     if (userSubscriptionCallback) {
         // Create null-terminated copy for callback
         char *payload = malloc(message->payloadlen + 1);
@@ -583,7 +638,6 @@ messageArrived(void* context, char* topicName, int topicLen, MQTTAsync_message*
     
     mqtt.freeMessage(&message);  // Proper cleanup
     mqtt.free(topicName);
-*/	
     return 1;
 }
 
@@ -607,7 +661,8 @@ onReconnect(void* context, char* cause) {
     LOG("%s: Reconnected to MQTT broker.  %s\n",__func__, cause?cause:"Unknown");
 	ACAP_STATUS_SetString("mqtt","status","Connected");
 	ACAP_STATUS_SetBool("mqtt","connected",1);
-//    connectionCallback(MQTT_RECONNECTED);
+    // Clean sessions drop subscriptions; the callback renews them
+    connectionCallback(MQTT_RECONNECTED);
 	LOG_TRACE("%s: Exit\n",__func__);
 }
 
@@ -710,6 +765,7 @@ MQTT_Load_Settings() {
         }
         cJSON_Delete(saved);
     }
+    invalidate_payload_suffix();
     return 1;
 }
 
@@ -770,6 +826,7 @@ MQTT_HTTP_callback(const ACAP_HTTP_Response response, const ACAP_HTTP_Request re
             cJSON_ReplaceItemInObject(mqtt_payload, item->string, cJSON_Duplicate(item, 1));
             item = item->next;
         }
+        invalidate_payload_suffix();
         
         ACAP_FILE_Write("localdata/mqtt.json", MQTTSettings);
         ACAP_HTTP_Respond_Text(response, "Payload updated");
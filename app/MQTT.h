@@ -8,6 +8,7 @@
 #define _MQTT_Service_H_
 
 #include "cJSON.h"
+#include "JsonWriter.h"
 
 #ifdef  __cplusplus
 extern "C" {
@@ -30,6 +31,9 @@ void   MQTT_Cleanup();
 cJSON* MQTT_Settings();
 int    MQTT_Publish( const char *topic, const char *payload, int qos, int retained );
 int    MQTT_Publish_JSON( const char *topic, cJSON *payload, int qos, int retained );
+// Publish the object in payload; name, location and serial are appended.
+// MQTT_Publish_JSON uses the thread's writer, so do not mix the two.
+int    MQTT_Publish_Writer( const char *topic, json_writer_t *payload, int qos, int retained );
 int    MQTT_Publish_Binary( const char *topic, int payloadlen, void *payload, int qos, int retained );
 int    MQTT_Subscribe( const char *topic );
 int    MQTT_Unsubscribe( const char *topic );
@@ -18,6 +18,11 @@
 #include "cJSON.h"
 #include "ACAP.h"
 #include "VOD.h"
+#include "Dictionary.h"
+#include "Overlap.h"
+#include "IdMap.h"
+#include "TimerWheel.h"
+#include "Zone.h"
 
 #define LOG(fmt, args...) { syslog(LOG_INFO, fmt, ## args); printf(fmt, ## args); }
 #define LOG_WARN(fmt, args...) { syslog(LOG_WARNING, fmt, ## args); printf(fmt, ## args); }
@@ -25,59 +30,13 @@
 #define LOG_TRACE(fmt, args...) {}
 
 #define IDLE_THRESHOLD_PCT 50
+#define ENTRY_INLINE_ATTRIBUTES 8
 #define DIRECTION_CHANGE_THRESHOLD_RAD (M_PI / 4) // 45 degrees 
 
 typedef struct {
-    char name[64];
-    char value[64];
-} od_attribute_t;
-
-typedef struct {
-    const char *key;
-    const char *value;
-} NameMapEntry;
-
-static const NameMapEntry name_map[] = {
-    { "car", "Car" },
-    { "truck", "Truck" },
-    { "motorcycle_bicycle", "Bike" },
-    { "bus", "Bus" },
-    { "truck","Truck" },
-    { "vehicle_other","Other" },
-    { "vehicle","Vehicle" },	
-    { "license_plate", "LicensePlate" },
-    { "human", "Human" },
-    { "human_face", "Head" },
-    { "human_head", "Head" },
-    { "head", "Head" },
-    { "face", "Head" },	
-    { "hat", "Hat" },
-    { "animal", "Animal" },	
-    { "no_hat", "" },
-    { "hat_other", "Hat" },
-    { "hard_hat", "Helmet" },
-    { "bag", "Bag" },
-    { "bag_other", "Bag" },
-    { "backpack", "Bag" },
-    { "suitcase", "Bag" },
-    { "red", "Red" },
-    { "blue", "Blue" },
-    { "black", "Black" },
-    { "white", "White" },
-    { "green", "Green" },
-    { "beige", "Beige" },
-    { "yellow", "Yellow" },
-    { "gray", "Gray" },
-    { "trailer_experimental", "Trailer" },
-    { "trailer", "Trailer" },
-    { "unknown", "Unknown" }
-};
-
-#define NAME_MAP_SIZE (sizeof(name_map) / sizeof(name_map[0]))
-
-typedef struct {
+    uint32_t tracker_id;
     char id[32];
-    char class_name[64];
+    dict_code_t class_code;
     int confidence;
     int x, y, w, h;
     int cx, cy;
@@ -101,46 +60,165 @@ typedef struct {
     double max_idle_duration; // seconds
     double idle_start_time; // ms epoch
     double last_published_tracker;  //The timestamp the tracker was published
-    od_attribute_t *attributes; // Dynamically allocated array
+    timer_id_t heartbeat;       // Re-publish deadline in the cache's heartbeat wheel
+    // Trajectory simplifier, see sample_trajectory
+    int anchor_x, anchor_y;     // Centre of the last point published on the trajectory
+    float cone_angle;           // Directions from the anchor that pass within
+    float cone_width;           // the tolerance of every centre since; width < 0: not set
+    float cone_reach;           // Farthest centre from the anchor so far
+    bool sample_pending;        // Tolerance exceeded before the minimum interval passed
+    // Attributes are kept inline; an object that reports more gets an
+    // overflow array instead, kept and reused for the rest of its life
+    tracker_attribute_t inline_attributes[ENTRY_INLINE_ATTRIBUTES];
+    tracker_attribute_t *overflow;
+    size_t overflow_capacity;
     size_t num_attributes;      // Number of attributes
     bool active;
 } detection_cache_entry_t;
 
+// Detection cache: entries live inline in a dense slab and the id map
+// points into it. Removal moves the last entry into the hole, so the slab
+// has no gaps and every pass over the cache is a plain array walk.
+// Entry pointers are only valid until the next insert or removal.
+typedef struct {
+    detection_cache_entry_t *entries;
+    uint32_t count;
+    uint32_t capacity;
+    idmap_t index;
+    timer_wheel_t heartbeats;   // On frame time; timers carry the tracker id
+    bool heartbeats_ready;
+    uint32_t high_water;        // Most entries at once
+    uint32_t overflowed;        // Entries with an overflow attribute array
+} detection_cache_t;
+
+#define DETECTION_CACHE_INITIAL_CAPACITY 64
+
+// An active tracker is re-published when it has not been for this long;
+// one that cannot be published yet is tried again after the retry time
+#define TRACKER_HEARTBEAT_MS 1500
+#define TRACKER_HEARTBEAT_RETRY_MS 1000
+#define TRACKER_HEARTBEAT_TICK_MS 100
+
 // ---- THREAD SAFETY ----
-static GMutex detection_mutex;
+// Each channel has its own cache, fed by its own VOD worker thread, and
+// that thread is the only one that touches it. Other threads read the
+// channel's published counters and hand it work through VOD_Wake. The
+// filter settings below are shared by all channels.
+static GRWLock config_lock;
+
+// Per object decision of admit_objects: refused, known or already
+// decided, or a new track still competing
+enum { ADMIT_NO = 0, ADMIT_KEEP, ADMIT_NEW };
 
-static GHashTable *detectionCache = NULL;
+// A new track competing for the object budget, see admit_objects
+typedef struct {
+    uint32_t index;             // Position in the frame
+    dict_code_t class_code;
+    int64_t priority;           // Higher is kept first; unique within a frame
+} budget_candidate_t;
+
+// Counters of a channel as of its last frame, set by its VOD thread and
+// read by update_trackers. Each value is read on its own.
+typedef struct {
+    volatile gint frames;       // Frames and resets processed
+    volatile gint entries;
+    volatile gint capacity;
+    volatile gint high_water;
+    volatile gint overflowed;
+    volatile gint budget_dropped;
+    volatile gint budget_selections;
+    volatile gint duplicates;
+    volatile gint refused;
+} od_status_t;
+
+typedef struct {
+    int channel;
+    char status_group[32];      // "objectdetection" for the primary channel, "objectdetection_<channel>" otherwise
+    detection_cache_t cache;
+    // Cross-thread state; everything else belongs to the VOD thread
+    od_status_t status;                 // See publish_status
+    volatile gint reset_requested;      // See ObjectDetection_Reset
+    gint frames_checked;        // status.frames at the last update_trackers
+    double last_frame_time;     // Frame time of the last VOD_Data, epoch ms
+    // Object budget and duplicate suppression. Arrays are kept between
+    // frames and only grow.
+    GHashTable *refused;        // Tracks refused or suppressed, kept until they die
+    uint8_t *admit;
+    budget_candidate_t *candidates;
+    uint32_t *box_object;       // Frame position of each overlap box
+    size_t budget_capacity;
+    overlap_boxes_t boxes;
+    float *iou;
+    uint32_t iou_capacity;
+    uint64_t budget_dropped;    // Tracks refused since start
+    uint64_t budget_selections; // Frames where the budget had to choose
+    uint64_t duplicates;        // Tracks suppressed as duplicates since start
+} od_channel_t;
+
+static od_channel_t od_channels[OBJECTDETECTION_MAX_CHANNELS];
+static int od_num_channels = 0;
 
 static int config_tracker_confidence = 1;
-static int config_min_confidence = 50;
 static int config_cog = 0;
 static int config_rotation = 0;
 static int config_max_idle = 0;
-static int config_min_height = 10;
-static int config_max_height = 800;
-static int config_min_width = 10;
-static int config_max_width = 800;
-static int config_x1 = 0;
-static int config_x2 = 1000;
-static int config_y1 = 0;
-static int config_y2 = 1000;
 static int config_hanging_objects = 0;
 static int config_cutoff_active = 0;   // 0 = disabled, 1 = enabled
-static int config_cutoff_x1 = 50;
-static int config_cutoff_y1 = 50;
-static int config_cutoff_x2 = 950;
-static int config_cutoff_y2 = 950;
+static zone_set_t *config_cutoff_zone = NULL;
+
+// Object filter compiled from the scene settings. A published filter is
+// never modified; a settings change, or classes interned after it was
+// compiled, swap in a new one. Swaps hold config_lock as writer, so a
+// filter read under the reader lock stays valid until it is released.
+typedef struct {
+    int min_confidence;
+    zone_set_t *aoi;                // Area of interest, NULL for the whole view
+    int min_width, max_width, min_height, max_height;
+    uint32_t num_codes;             // Class codes covered by ignored
+    uint64_t ignored[DICT_MAX_NAMES / 64];
+    char **ignore;                  // ignoreClass, for codes interned later
+    int num_ignore;
+} object_filter_t;
+
+static object_filter_t *object_filter = NULL;
 
-static cJSON* config_blacklist = 0;
+// Object budget; 0 = unlimited
+enum { BUDGET_LARGEST, BUDGET_NEAREST, BUDGET_AOI, BUDGET_OLDEST };
+static int config_max_objects = 0;
+static int config_max_per_class = 0;
+static int config_budget_priority = BUDGET_NEAREST;
+
+// Duplicate suppression: a new track of class drop whose box overlaps a
+// track of class keep by at least iou is suppressed. With keep == drop
+// the older track survives.
+#define MAX_DUPLICATE_RULES 16
+typedef struct {
+    dict_code_t keep;
+    dict_code_t drop;
+    float iou;
+} duplicate_rule_t;
+static duplicate_rule_t config_duplicate_rules[MAX_DUPLICATE_RULES];
+static int config_num_duplicate_rules = 0;
+static float config_duplicate_min_iou = 1;
+
+// Tracker sampling: a moving object is published when its centre leaves
+// the straight line from the last published centre by more than the
+// tolerance (view units), at most every minInterval and at least every
+// maxInterval ms. Tolerance 0 publishes every IDLE_THRESHOLD_PCT of movement.
+#define MAX_SAMPLING_CLASSES 16
+typedef struct {
+    dict_code_t class_code;
+    float tolerance;
+} sampling_class_t;
+static float config_sample_tolerance = 25;
+static double config_sample_min_interval = 200;
+static double config_sample_max_interval = 1500;
+static sampling_class_t config_sample_classes[MAX_SAMPLING_CLASSES];
+static int config_num_sample_classes = 0;
 
 static ObjectDetection_Callback detectionsCallback = 0;
 static TrackerDetection_Callback trackerCallback = 0;
-
-static double get_epoch_ms() {
-    struct timespec ts;
-    clock_gettime(CLOCK_REALTIME, &ts);
-    return (double)(ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
-}
+static ObjectDetection_Due_Callback detectionsDue = 0;
 
 static void free_attributes(GHashTable *attrs) {
     if (!attrs) return;
@@ -154,20 +232,77 @@ static void free_attributes(GHashTable *attrs) {
     g_hash_table_destroy(attrs);
 }
 
-static void free_detection_cache_entry(gpointer data) {
-    detection_cache_entry_t *entry = (detection_cache_entry_t*)data;
-    if (entry->attributes) free(entry->attributes);
-    free(entry);
+static detection_cache_entry_t *cache_find(detection_cache_t *cache, uint32_t id) {
+    if (!cache->index.values) return NULL;
+    uint32_t idx = IdMap_Find(&cache->index, id);
+    return idx == IDMAP_NONE ? NULL : &cache->entries[idx];
 }
 
-const char* NiceName(const char* input) {
-    if (!input) return NULL;
-    for (size_t i = 0; i < NAME_MAP_SIZE; ++i) {
-        if (strcmp(input, name_map[i].key) == 0) {
-            return name_map[i].value;
-        }
+// Returns a zeroed entry for id, which must not be in the cache
+static detection_cache_entry_t *cache_insert(detection_cache_t *cache, uint32_t id) {
+    if (!cache->index.values && !IdMap_Init(&cache->index, DETECTION_CACHE_INITIAL_CAPACITY))
+        return NULL;
+    if (cache->count == cache->capacity) {
+        uint32_t capacity = cache->capacity ? cache->capacity * 2 : DETECTION_CACHE_INITIAL_CAPACITY;
+        detection_cache_entry_t *entries = realloc(cache->entries, capacity * sizeof(detection_cache_entry_t));
+        if (!entries) return NULL;
+        cache->entries = entries;
+        cache->capacity = capacity;
+    }
+    if (!IdMap_Put(&cache->index, id, cache->count))
+        return NULL;
+    detection_cache_entry_t *entry = &cache->entries[cache->count++];
+    if (cache->count > cache->high_water)
+        cache->high_water = cache->count;
+    memset(entry, 0, sizeof(*entry));
+    entry->tracker_id = id;
+    return entry;
+}
+
+static void free_overflow(detection_cache_t *cache, detection_cache_entry_t *entry) {
+    if (!entry->overflow)
+        return;
+    free(entry->overflow);
+    entry->overflow = NULL;
+    entry->overflow_capacity = 0;
+    cache->overflowed--;
+}
+
+static void cache_remove_at(detection_cache_t *cache, uint32_t idx) {
+    detection_cache_entry_t *entry = &cache->entries[idx];
+    free_overflow(cache, entry);
+    if (cache->heartbeats_ready)
+        TimerWheel_Cancel(&cache->heartbeats, entry->heartbeat);
+    IdMap_Remove(&cache->index, entry->tracker_id);
+    uint32_t last = --cache->count;
+    if (idx != last) {
+        *entry = cache->entries[last];
+        IdMap_Put(&cache->index, entry->tracker_id, idx);
     }
-    return input;
+}
+
+static void cache_clear(detection_cache_t *cache) {
+    for (uint32_t i = 0; i < cache->count; ++i)
+        free_overflow(cache, &cache->entries[i]);
+    cache->count = 0;
+    IdMap_Clear(&cache->index);
+    // Restarted on the clock of the next heartbeat
+    if (cache->heartbeats_ready)
+        TimerWheel_Free(&cache->heartbeats);
+    cache->heartbeats_ready = false;
+}
+
+// Valid until the entry's attributes are next replaced; entries move, so
+// the inline array is never referenced by pointer across calls
+static inline tracker_attribute_t *entry_attributes(detection_cache_entry_t *entry) {
+    return entry->overflow ? entry->overflow : entry->inline_attributes;
+}
+
+static void cache_free(detection_cache_t *cache) {
+    cache_clear(cache);
+    free(cache->entries);
+    IdMap_Free(&cache->index);
+    memset(cache, 0, sizeof(*cache));
 }
 
 static float calc_distance(int x1, int y1, int x2, int y2) {
@@ -176,16 +311,113 @@ static float calc_distance(int x1, int y1, int x2, int y2) {
     return sqrtf((float)(dx * dx + dy * dy));
 }
 
-static int ObjectDetection_Blacklisted(const char* label) {
-    if (!config_blacklist || !label)
-        return 0;
-    cJSON* item = config_blacklist->child;
-    while (item) {
-        if (strcmp(label, item->valuestring) == 0)
-            return 1;
-        item = item->next;
+static inline const object_filter_t* current_filter(void) {
+    return g_atomic_pointer_get(&object_filter);
+}
+
+// ignoreClass holds display names; detector names are matched as well
+static bool ignore_listed(const object_filter_t *filter, dict_code_t code) {
+    const char *name = Dictionary_Name(code);
+    const char *label = Dictionary_Label(code);
+    for (int i = 0; i < filter->num_ignore; ++i)
+        if (strcmp(filter->ignore[i], label) == 0 || strcmp(filter->ignore[i], name) == 0)
+            return true;
+    return false;
+}
+
+static bool filter_ignores(const object_filter_t *filter, dict_code_t code) {
+    if (code < filter->num_codes)
+        return (filter->ignored[code >> 6] >> (code & 63)) & 1;
+    return ignore_listed(filter, code);
+}
+
+static void free_filter(object_filter_t *filter) {
+    if (!filter) return;
+    for (int i = 0; i < filter->num_ignore; ++i)
+        free(filter->ignore[i]);
+    free(filter->ignore);
+    Zone_Unref(filter->aoi);
+    free(filter);
+}
+
+static bool set_filter_ignore(object_filter_t *filter, const char **names, int count) {
+    filter->ignore = count ? calloc(count, sizeof(char*)) : NULL;
+    if (count && !filter->ignore) return false;
+    for (int i = 0; i < count; ++i) {
+        filter->ignore[i] = strdup(names[i]);
+        if (!filter->ignore[i]) return false;
+        filter->num_ignore++;
+    }
+    return true;
+}
+
+// Class bitmask over every code interned so far
+static void compile_filter_classes(object_filter_t *filter) {
+    memset(filter->ignored, 0, sizeof(filter->ignored));
+    filter->num_codes = 0;
+    if (filter->num_ignore) {
+        int count = Dictionary_Count();
+        for (int code = 0; code < count; ++code)
+            if (ignore_listed(filter, (dict_code_t)code))
+                filter->ignored[code >> 6] |= 1ULL << (code & 63);
+        filter->num_codes = count;
+    } else {
+        filter->num_codes = DICT_MAX_NAMES;
+    }
+}
+
+static object_filter_t* compile_filter(cJSON *scene) {
+    object_filter_t *filter = calloc(1, sizeof(object_filter_t));
+    if (!filter) return NULL;
+    cJSON *item;
+    filter->min_confidence = scene ? ((item = cJSON_GetObjectItem(scene, "confidence")) ? item->valueint : 40) : 50;
+    filter->min_height = (item = cJSON_GetObjectItem(scene, "minHeight")) ? item->valueint : 10;
+    filter->max_height = (item = cJSON_GetObjectItem(scene, "maxHeight")) ? item->valueint : 800;
+    filter->min_width = (item = cJSON_GetObjectItem(scene, "minWidth")) ? item->valueint : 10;
+    filter->max_width = (item = cJSON_GetObjectItem(scene, "maxWidth")) ? item->valueint : 800;
+    filter->aoi = Zone_Compile(cJSON_GetObjectItem(scene, "aoi"), true, ZONE_VIEW);
+
+    const char *names[DICT_MAX_NAMES];
+    int count = 0;
+    cJSON *ignore = cJSON_GetObjectItem(scene, "ignoreClass");
+    for (item = ignore ? ignore->child : NULL; item && count < DICT_MAX_NAMES; item = item->next)
+        if (cJSON_IsString(item) && item->valuestring[0])
+            names[count++] = item->valuestring;
+    if (!set_filter_ignore(filter, names, count)) {
+        free_filter(filter);
+        return NULL;
+    }
+    compile_filter_classes(filter);
+    return filter;
+}
+
+// Publish filter and free the one it replaces. Takes config_lock as writer.
+static void swap_filter(object_filter_t *filter) {
+    g_rw_lock_writer_lock(&config_lock);
+    object_filter_t *previous = object_filter;
+    g_atomic_pointer_set(&object_filter, filter);
+    g_rw_lock_writer_unlock(&config_lock);
+    free_filter(previous);
+}
+
+// Recompile the class mask when classes were interned after the current
+// filter was compiled. Called from the main loop, like ObjectDetection_Config.
+static void refresh_filter(void) {
+    const object_filter_t *current = current_filter();
+    if (!current || current->num_codes >= (uint32_t)Dictionary_Count())
+        return;
+    object_filter_t *filter = malloc(sizeof(object_filter_t));
+    if (!filter) return;
+    *filter = *current;
+    filter->aoi = Zone_Ref(current->aoi);
+    filter->ignore = NULL;
+    filter->num_ignore = 0;
+    if (!set_filter_ignore(filter, (const char**)current->ignore, current->num_ignore)) {
+        free_filter(filter);
+        return;
     }
-    return 0;
+    compile_filter_classes(filter);
+    swap_filter(filter);
 }
 
 static void rotate_bbox(int x, int y, int w, int h, int *rx, int *ry, int *rw, int *rh, int rotation) {
@@ -218,41 +450,87 @@ static void rotate_bbox(int x, int y, int w, int h, int *rx, int *ry, int *rw, i
 }
 
 void ObjectDetection_Config(cJSON* data) {
-    g_mutex_lock(&detection_mutex);
     LOG_TRACE("%s: Entry\n", __func__);
     if (!data) {
         LOG_WARN("%s: Invalid input\n", __func__);
-        g_mutex_unlock(&detection_mutex);
         return;
     }
+    object_filter_t *filter = compile_filter(data);
+    if (filter)
+        swap_filter(filter);
+    else
+        LOG_WARN("%s: Unable to compile object filter\n", __func__);
+
+
+    // Compiled outside the lock; frames keep using the previous area meanwhile
+    cJSON *cutoff = cJSON_GetObjectItem(data, "cutoff");
+    zone_set_t *cutoff_zone = cutoff ? Zone_Compile(cutoff, true, (zone_rect_t){ 50, 50, 950, 950 }) : NULL;
+
+    g_rw_lock_writer_lock(&config_lock);
 
-    config_min_confidence = cJSON_GetObjectItem(data, "confidence") ? cJSON_GetObjectItem(data, "confidence")->valueint : 40;
     config_cog = cJSON_GetObjectItem(data, "cog") ? cJSON_GetObjectItem(data, "cog")->valueint : 0;
     config_rotation = cJSON_GetObjectItem(data, "rotation") ? cJSON_GetObjectItem(data, "rotation")->valueint : 0;
     config_tracker_confidence = cJSON_GetObjectItem(data, "tracker_confidence") ? cJSON_GetObjectItem(data, "tracker_confidence")->valueint : 1;
     config_max_idle = cJSON_GetObjectItem(data, "maxIdle") ? cJSON_GetObjectItem(data, "maxIdle")->valueint : 0;
-    config_blacklist = cJSON_GetObjectItem(data, "ignoreClass") ? cJSON_GetObjectItem(data, "ignoreClass") : cJSON_CreateArray();
-    config_min_height = cJSON_GetObjectItem(data, "minHeight") ? cJSON_GetObjectItem(data, "minHeight")->valueint : 10;
-    config_max_height = cJSON_GetObjectItem(data, "maxHeight") ? cJSON_GetObjectItem(data, "maxHeight")->valueint : 800;
-    config_min_width = cJSON_GetObjectItem(data, "minWidth") ? cJSON_GetObjectItem(data, "minWidth")->valueint : 10;
-    config_max_width = cJSON_GetObjectItem(data, "maxWidth") ? cJSON_GetObjectItem(data, "maxWidth")->valueint : 800;
     config_hanging_objects = 0;
-    cJSON *cutoff = cJSON_GetObjectItem(data, "cutoff");
-    if (cutoff) {
-        config_cutoff_active = cJSON_GetObjectItem(cutoff, "active") ? cJSON_IsTrue(cJSON_GetObjectItem(cutoff, "active")) : 0;
-        config_cutoff_x1 = cJSON_GetObjectItem(cutoff, "x1") ? cJSON_GetObjectItem(cutoff, "x1")->valueint : 50;
-        config_cutoff_y1 = cJSON_GetObjectItem(cutoff, "y1") ? cJSON_GetObjectItem(cutoff, "y1")->valueint : 50;
-        config_cutoff_x2 = cJSON_GetObjectItem(cutoff, "x2") ? cJSON_GetObjectItem(cutoff, "x2")->valueint : 950;
-        config_cutoff_y2 = cJSON_GetObjectItem(cutoff, "y2") ? cJSON_GetObjectItem(cutoff, "y2")->valueint : 950;
-    } else {
-        config_cutoff_active = 0;
+    config_cutoff_active = cutoff && cutoff_zone ? cJSON_IsTrue(cJSON_GetObjectItem(cutoff, "active")) : 0;
+    zone_set_t *previous_cutoff = config_cutoff_zone;
+    config_cutoff_zone = cutoff_zone;
+    cJSON *budget = cJSON_GetObjectItem(data, "budget");
+    config_max_objects = budget && cJSON_GetObjectItem(budget, "maxObjects") ? cJSON_GetObjectItem(budget, "maxObjects")->valueint : 0;
+    config_max_per_class = budget && cJSON_GetObjectItem(budget, "maxPerClass") ? cJSON_GetObjectItem(budget, "maxPerClass")->valueint : 0;
+    const char *priority = budget ? cJSON_GetStringValue(cJSON_GetObjectItem(budget, "priority")) : NULL;
+    if (!priority || strcmp(priority, "nearest") == 0)
+        config_budget_priority = BUDGET_NEAREST;
+    else if (strcmp(priority, "largest") == 0)
+        config_budget_priority = BUDGET_LARGEST;
+    else if (strcmp(priority, "aoi") == 0)
+        config_budget_priority = BUDGET_AOI;
+    else if (strcmp(priority, "oldest") == 0)
+        config_budget_priority = BUDGET_OLDEST;
+    else {
+        LOG_WARN("%s: Unknown budget priority %s, using nearest\n", __func__, priority);
+        config_budget_priority = BUDGET_NEAREST;
     }
-    cJSON *aoi = cJSON_GetObjectItem(data, "aoi");
-    if (aoi) {
-        config_x1 = cJSON_GetObjectItem(aoi, "x1") ? cJSON_GetObjectItem(aoi, "x1")->valueint : 0;
-        config_x2 = cJSON_GetObjectItem(aoi, "x2") ? cJSON_GetObjectItem(aoi, "x2")->valueint : 1000;
-        config_y1 = cJSON_GetObjectItem(aoi, "y1") ? cJSON_GetObjectItem(aoi, "y1")->valueint : 0;
-        config_y2 = cJSON_GetObjectItem(aoi, "y2") ? cJSON_GetObjectItem(aoi, "y2")->valueint : 1000;
+    cJSON *sampling = cJSON_GetObjectItem(data, "tracker");
+    cJSON *item;
+    config_sample_tolerance = (item = cJSON_GetObjectItem(sampling, "tolerance")) && item->valuedouble >= 0 ? item->valuedouble : 25;
+    config_sample_min_interval = (item = cJSON_GetObjectItem(sampling, "minInterval")) ? item->valuedouble : 200;
+    config_sample_max_interval = (item = cJSON_GetObjectItem(sampling, "maxInterval")) ? item->valuedouble : 1500;
+    config_num_sample_classes = 0;
+    cJSON *classes = cJSON_GetObjectItem(sampling, "classes");
+    for (item = classes ? classes->child : NULL; item && config_num_sample_classes < MAX_SAMPLING_CLASSES; item = item->next) {
+        if (!cJSON_IsNumber(item) || item->valuedouble < 0)
+            continue;
+        sampling_class_t *c = &config_sample_classes[config_num_sample_classes];
+        c->class_code = Dictionary_Intern(item->string);
+        c->tolerance = item->valuedouble;
+        if (c->class_code != DICT_NONE)
+            config_num_sample_classes++;
+    }
+    config_num_duplicate_rules = 0;
+    config_duplicate_min_iou = 1;
+    cJSON *duplicates = cJSON_GetObjectItem(data, "duplicates");
+    if (duplicates && cJSON_IsTrue(cJSON_GetObjectItem(duplicates, "active"))) {
+        cJSON *rule = cJSON_GetObjectItem(duplicates, "rules") ? cJSON_GetObjectItem(duplicates, "rules")->child : NULL;
+        for (; rule && config_num_duplicate_rules < MAX_DUPLICATE_RULES; rule = rule->next) {
+            const char *keep = cJSON_GetStringValue(cJSON_GetObjectItem(rule, "keep"));
+            const char *drop = cJSON_GetStringValue(cJSON_GetObjectItem(rule, "drop"));
+            cJSON *iou = cJSON_GetObjectItem(rule, "iou");
+            if (!keep || !drop || !cJSON_IsNumber(iou) || iou->valuedouble <= 0) {
+                LOG_WARN("%s: Invalid duplicate rule ignored\n", __func__);
+                continue;
+            }
+            duplicate_rule_t *r = &config_duplicate_rules[config_num_duplicate_rules];
+            r->keep = Dictionary_Intern(keep);
+            r->drop = Dictionary_Intern(drop);
+            r->iou = (float)iou->valuedouble;
+            if (r->keep == DICT_NONE || r->drop == DICT_NONE)
+                continue;
+            if (r->iou < config_duplicate_min_iou)
+                config_duplicate_min_iou = r->iou;
+            config_num_duplicate_rules++;
+        }
     }
 /*	
     cJSON *significantMovement = cJSON_GetObjectItem(data, "significantMovement");
@@ -263,127 +541,283 @@ void ObjectDetection_Config(cJSON* data) {
 	}
 */	
     LOG_TRACE("%s: Exit\n", __func__);
-    g_mutex_unlock(&detection_mutex);
+    g_rw_lock_writer_unlock(&config_lock);
+    Zone_Unref(previous_cutoff);
 	ObjectDetection_Reset();
 }
 
 
+// Attribute names and values with a published meaning, interned once
+// tracker_attribute_kind_t by attribute name code; codes never change meaning
+static uint8_t attribute_kinds[DICT_MAX_NAMES];
+static dict_code_t value_no_hat, value_face_non_visible, value_down;
+
+static void intern_attribute_codes(void) {
+    static const struct { const char *name; uint8_t kind; } kinds[] = {
+        { "vehicle_type",          TRACKER_ATTRIBUTE_VEHICLE_TYPE },
+        { "vehicle_color",         TRACKER_ATTRIBUTE_COLOR },
+        { "clothing_upper_color",  TRACKER_ATTRIBUTE_COLOR },
+        { "clothing_lower_color",  TRACKER_ATTRIBUTE_COLOR2 },
+        { "hat_type",              TRACKER_ATTRIBUTE_HAT },
+        { "bag_type",              TRACKER_ATTRIBUTE_BAG },
+        { "human_face_visibility", TRACKER_ATTRIBUTE_FACE },
+        { "human_pose",            TRACKER_ATTRIBUTE_POSE }
+    };
+    for (size_t i = 0; i < sizeof(kinds) / sizeof(kinds[0]); ++i) {
+        dict_code_t code = Dictionary_Intern(kinds[i].name);
+        if (code != DICT_NONE)
+            attribute_kinds[code] = kinds[i].kind;
+    }
+    value_no_hat = Dictionary_Intern("no_hat");
+    value_face_non_visible = Dictionary_Intern("face_non_visible");
+    value_down = Dictionary_Intern("down");
+}
+
+static void decode_attribute(tracker_attribute_t *attribute, dict_code_t name, dict_code_t value) {
+    attribute->name = name;
+    attribute->value = value;
+    attribute->kind = name < DICT_MAX_NAMES ? attribute_kinds[name] : TRACKER_ATTRIBUTE_OTHER;
+    attribute->label = Dictionary_Label(value);
+    switch (attribute->kind) {
+        case TRACKER_ATTRIBUTE_HAT:  attribute->flag = value != value_no_hat; break;
+        case TRACKER_ATTRIBUTE_FACE: attribute->flag = value != value_face_non_visible; break;
+        case TRACKER_ATTRIBUTE_POSE: attribute->flag = value == value_down; break;
+        default:                     attribute->flag = false; break;
+    }
+}
+
+// Tracker events collected while a channel is updated and delivered once
+// config_lock is released. Each VOD worker has its own batch; the array
+// only grows.
 typedef struct {
-    cJSON *payload;
+    tracker_event_t event;
     int timer;
-} tracker_callback_data_t;
+} queued_tracker_t;
+
+typedef struct {
+    queued_tracker_t *items;
+    size_t count;
+    size_t capacity;
+} tracker_batch_t;
 
-static cJSON* build_tracker_json(detection_cache_entry_t *entry, int timer, bool *should_publish) {
-    *should_publish = false;
-    cJSON *obj = cJSON_CreateObject();
-    if (!obj || !entry || !entry->id) return NULL;
+static __thread tracker_batch_t tracker_batch;
+
+static bool build_tracker_event(detection_cache_entry_t *entry, int timer, double now, tracker_event_t *event) {
     if( entry->active == true ) {
-        if (!entry->valid) { cJSON_Delete(obj); return NULL; }
-        if (entry->trackerSleep) { cJSON_Delete(obj); return NULL; }
+        if (!entry->valid) return false;
+        if (entry->trackerSleep) return false;
     }
-    const char* label = NiceName(entry->class_name);
-    if (!label) { cJSON_Delete(obj); return NULL; }
-    if (ObjectDetection_Blacklisted(label)) { cJSON_Delete(obj); return NULL; }
-
-    cJSON_AddStringToObject(obj, "class", label);
-    cJSON_AddNumberToObject(obj, "confidence", entry->confidence);
-    cJSON_AddNumberToObject(obj, "age", entry->age);
-    cJSON_AddNumberToObject(obj, "distance", entry->distance/10);
-    cJSON_AddNumberToObject(obj, "directions", entry->directions);
-    cJSON_AddNumberToObject(obj, "x", entry->x);
-    cJSON_AddNumberToObject(obj, "y", entry->y);
-    cJSON_AddNumberToObject(obj, "w", entry->w);
-    cJSON_AddNumberToObject(obj, "h", entry->h);
-    cJSON_AddNumberToObject(obj, "cx", entry->cx);
-    cJSON_AddNumberToObject(obj, "cy", entry->cy);
-    cJSON_AddNumberToObject(obj, "dx", entry->dx);
-    cJSON_AddNumberToObject(obj, "dy", entry->dy);
-    cJSON_AddNumberToObject(obj, "bx", entry->bx);
-    cJSON_AddNumberToObject(obj, "by", entry->by);
-    cJSON_AddNumberToObject(obj, "timestamp", entry->timestamp);
-    cJSON_AddNumberToObject(obj, "previousTimestamp", entry->previousTimestamp);
-    cJSON_AddNumberToObject(obj, "birth", entry->birthTime);
-    cJSON_AddNumberToObject(obj, "idle", entry->idle_duration);
-    cJSON_AddNumberToObject(obj, "maxIdle", entry->max_idle_duration);
-	cJSON_AddNumberToObject(obj, "speed", entry->speed);
-	cJSON_AddNumberToObject(obj, "maxSpeed", entry->maxSpeed);
-    cJSON_AddStringToObject(obj, "id", entry->id);
+    const char* label = Dictionary_Label(entry->class_code);
+    if (!label) return false;
+    if (filter_ignores(current_filter(), entry->class_code)) return false;
+
+    memcpy(event->id, entry->id, sizeof(event->id));
+    event->class_code = entry->class_code;
+    event->label = label;
+    event->confidence = entry->confidence;
+    event->age = entry->age;
+    event->distance = entry->distance/10;
+    event->directions = entry->directions;
+    event->x = entry->x;
+    event->y = entry->y;
+    event->w = entry->w;
+    event->h = entry->h;
+    event->cx = entry->cx;
+    event->cy = entry->cy;
+    event->dx = entry->dx;
+    event->dy = entry->dy;
+    event->bx = entry->bx;
+    event->by = entry->by;
+    event->timestamp = entry->timestamp;
+    event->previousTimestamp = entry->previousTimestamp;
+    event->birth = entry->birthTime;
+    event->idle = entry->idle_duration;
+    event->maxIdle = entry->max_idle_duration;
+    event->speed = entry->speed;
+    event->maxSpeed = entry->maxSpeed;
     if( entry->sleep && !entry->trackerSleep) {
-        cJSON_AddBoolToObject(obj, "active", 0);
+        event->active = false;
         entry->trackerSleep = 1;
     } else {
-        cJSON_AddBoolToObject(obj, "active", entry->active);
+        event->active = entry->active;
     }
-    for (size_t a = 0; a < entry->num_attributes; ++a) {
-        if (strlen(entry->attributes[a].name) && strlen(entry->attributes[a].value)) {
-            const char* aKey = entry->attributes[a].name;
-            const char* aValue = entry->attributes[a].value;
-            if( strcmp("vehicle_type",aKey) == 0 ) {
-                cJSON_ReplaceItemInObject(obj,"class",cJSON_CreateString(NiceName(aValue)));
-                aKey = 0; aValue = 0;
-            }
-            if( aKey && strcmp("vehicle_color",aKey) == 0 ) {
-                cJSON_AddStringToObject(obj,"color",NiceName(aValue));
-                aKey = 0; aValue = 0;
-            }
-            if( aKey && strcmp("clothing_upper_color",aKey) == 0) {
-                cJSON_AddStringToObject(obj,"color",NiceName(aValue));
-                aKey = 0; aValue = 0;
-            }
-            if( aKey && strcmp("clothing_lower_color",aKey) == 0 ) {
-                cJSON_AddStringToObject(obj,"color2",NiceName(aValue));
-                aKey = 0; aValue = 0;
-            }
-            if( aKey && strcmp("hat_type",aKey) == 0 ) {
-                if( strcmp("no_hat", aValue ) != 0 )
-                    cJSON_AddStringToObject(obj,"hat",NiceName(aValue));
-                aKey = 0; aValue = 0;
-            }
-            if( aKey && strcmp("bag_type",aKey) == 0) {
-                cJSON_AddStringToObject(obj,"bag",NiceName(aValue));
-                aKey = 0; aValue = 0;
-            }
-            if( aKey && strcmp("human_face_visibility",aKey) == 0) {
-                if( strcmp( aValue,"face_non_visible") == 0 )
-                    cJSON_AddFalseToObject(obj,"face");
-                else
-                    cJSON_AddTrueToObject(obj,"face");
-                aKey = 0; aValue = 0;
-            }
-            if( aKey && strcmp("human_pose",aKey) == 0 ) {
-                if( strcmp( aValue,"down") == 0 )
-                    cJSON_AddTrueToObject(obj,"isOnGround");
-                else
-                    cJSON_AddFalseToObject(obj,"isOnGround");
-                aKey = 0; aValue = 0;
-            }
-            if( aKey && aValue )
-                cJSON_AddStringToObject(obj, entry->attributes[a].name, entry->attributes[a].value);
+    event->color = NULL;
+    event->color2 = NULL;
+    event->hat = NULL;
+    event->face = -1;
+    event->anomaly[0] = 0;
+    event->num_attributes = MIN(entry->num_attributes, TRACKER_MAX_ATTRIBUTES);
+    memcpy(event->attributes, entry_attributes(entry), event->num_attributes * sizeof(tracker_attribute_t));
+    for (size_t a = 0; a < event->num_attributes; ++a) {
+        const tracker_attribute_t *attribute = &event->attributes[a];
+        switch (attribute->kind) {
+            case TRACKER_ATTRIBUTE_COLOR:
+                if (!event->color) event->color = attribute->label;
+                break;
+            case TRACKER_ATTRIBUTE_COLOR2:
+                if (!event->color2) event->color2 = attribute->label;
+                break;
+            case TRACKER_ATTRIBUTE_HAT:
+                if (!event->hat && attribute->flag) event->hat = attribute->label;
+                break;
+            case TRACKER_ATTRIBUTE_FACE:
+                if (event->face < 0) event->face = attribute->flag;
+                break;
         }
     }
-    entry->last_published_tracker = get_epoch_ms();
+    entry->last_published_tracker = now;
     if( !timer )
         entry->previousTimestamp = entry->timestamp;
-    *should_publish = true;
-    return obj;
+    return true;
+}
+
+// Move the entry's heartbeat to now + delay
+static void schedule_heartbeat(detection_cache_t *cache, detection_cache_entry_t *entry, double now, double delay) {
+    if (!cache->heartbeats_ready)
+        cache->heartbeats_ready = TimerWheel_Init(&cache->heartbeats, now, TRACKER_HEARTBEAT_TICK_MS);
+    if (!TimerWheel_Reschedule(&cache->heartbeats, entry->heartbeat, now + delay))
+        entry->heartbeat = TimerWheel_Schedule(&cache->heartbeats, now + delay, NULL, (void*)(uintptr_t)entry->tracker_id);
+}
+
+// Add the entry's tracker update to this thread's batch if it is published
+static void queue_tracker(detection_cache_t *cache, detection_cache_entry_t *entry, int timer, double now) {
+    tracker_batch_t *batch = &tracker_batch;
+    if (batch->count == batch->capacity) {
+        size_t capacity = batch->capacity ? batch->capacity * 2 : 64;
+        queued_tracker_t *items = realloc(batch->items, capacity * sizeof(queued_tracker_t));
+        if (!items) {
+            LOG_WARN("%s: Memory allocation failed for tracker events\n", __func__);
+            return;
+        }
+        batch->items = items;
+        batch->capacity = capacity;
+    }
+    queued_tracker_t *item = &batch->items[batch->count];
+    if (build_tracker_event(entry, timer, now, &item->event)) {
+        item->timer = timer;
+        batch->count++;
+        schedule_heartbeat(cache, entry, now, TRACKER_HEARTBEAT_MS);
+    }
+}
+
+// Published tracker members in payload order, ahead of the attributes
+#define TRACKER_FIELDS(FIELD) \
+    FIELD(STRING, "class",      label) \
+    FIELD(INT,    "confidence", confidence) \
+    FIELD(FIXED1, "age",        age) \
+    FIELD(INT,    "distance",   distance) \
+    FIELD(INT,    "directions", directions) \
+    FIELD(INT,    "x",          x) \
+    FIELD(INT,    "y",          y) \
+    FIELD(INT,    "w",          w) \
+    FIELD(INT,    "h",          h) \
+    FIELD(INT,    "cx",         cx) \
+    FIELD(INT,    "cy",         cy) \
+    FIELD(INT,    "dx",         dx) \
+    FIELD(INT,    "dy",         dy) \
+    FIELD(INT,    "bx",         bx) \
+    FIELD(INT,    "by",         by) \
+    FIELD(NUMBER, "timestamp",  timestamp) \
+    FIELD(NUMBER, "birth",      birth) \
+    FIELD(NUMBER, "idle",       idle) \
+    FIELD(NUMBER, "speed",      speed) \
+    FIELD(NUMBER, "maxSpeed",   maxSpeed) \
+    FIELD(STRING, "id",         id) \
+    FIELD(BOOL,   "active",     active)
+
+#define WRITE_TRACKER_FIELD(kind, key, member) JSON_WRITE_##kind(w, key, event->member);
+
+void ObjectDetection_Tracker_Write(json_writer_t *w, const tracker_event_t *event) {
+    JsonWriter_Object_Begin(w);
+    TRACKER_FIELDS(WRITE_TRACKER_FIELD)
+    for (size_t a = 0; a < event->num_attributes; ++a) {
+        const tracker_attribute_t *attribute = &event->attributes[a];
+        switch (attribute->kind) {
+            case TRACKER_ATTRIBUTE_COLOR:
+                JSON_WRITE_STRING(w, "color", attribute->label);
+                break;
+            case TRACKER_ATTRIBUTE_COLOR2:
+                JSON_WRITE_STRING(w, "color2", attribute->label);
+                break;
+            case TRACKER_ATTRIBUTE_HAT:
+                if (attribute->flag)
+                    JSON_WRITE_STRING(w, "hat", attribute->label);
+                break;
+            case TRACKER_ATTRIBUTE_BAG:
+                JSON_WRITE_STRING(w, "bag", attribute->label);
+                break;
+            case TRACKER_ATTRIBUTE_FACE:
+                JSON_WRITE_BOOL(w, "face", attribute->flag);
+                break;
+            case TRACKER_ATTRIBUTE_POSE:
+                JSON_WRITE_BOOL(w, "isOnGround", attribute->flag);
+                break;
+            default:
+                JSON_WRITE_STRING(w, Dictionary_Name(attribute->name), Dictionary_Name(attribute->value));
+                break;
+        }
+    }
+    if (event->anomaly[0])
+        JSON_WRITE_STRING(w, "anomaly", event->anomaly);
+    JsonWriter_Object_End(w);
 }
 
-static cJSON* build_detections_json(GHashTable *cache, GList **tracker_list) {
+// How an entry appears in this frame's detections list
+enum { LISTED_NO = 0, LISTED_ACTIVE, LISTED_ENDED, LISTED_SLEEPS };
+
+static int listed_state(const object_filter_t *filter, const detection_cache_entry_t *entry) {
+    if (!entry->valid) return LISTED_NO;
+    if (entry->active && entry->sleep) return LISTED_NO;
+    if (!Dictionary_Label(entry->class_code)) return LISTED_NO;
+    if (filter_ignores(filter, entry->class_code)) return LISTED_NO;
+    if (!entry->active) return LISTED_ENDED;
+    if (config_max_idle && entry->idle_duration > config_max_idle) return LISTED_SLEEPS;
+    return LISTED_ACTIVE;
+}
+
+// Listed entries that end or fall asleep this frame; the list must be
+// built for them so every end reaches the detections topic
+static int count_ended(const detection_cache_t *cache) {
+    const object_filter_t *filter = current_filter();
+    int ended = 0;
+    for (uint32_t i = 0; i < cache->count; ++i) {
+        int listed = listed_state(filter, &cache->entries[i]);
+        if (listed == LISTED_ENDED || listed == LISTED_SLEEPS)
+            ended++;
+    }
+    return ended;
+}
+
+// Every frame, whether or not the list is built: idle objects fall
+// asleep and ended ones queue their final tracker. Runs after
+// build_detections_json so the list still shows the transition.
+static void settle_listed(detection_cache_t *cache, double now) {
+    const object_filter_t *filter = current_filter();
+    for (uint32_t i = 0; i < cache->count; ++i) {
+        detection_cache_entry_t *entry = &cache->entries[i];
+        switch (listed_state(filter, entry)) {
+            case LISTED_SLEEPS:
+                entry->sleep = true;
+                break;
+            case LISTED_ENDED:
+                // Collect tracker for callback later (outside config_lock)
+                queue_tracker(cache, entry, 0, now);
+                break;
+        }
+    }
+}
+
+static cJSON* build_detections_json(detection_cache_t *cache) {
+    const object_filter_t *filter = current_filter();
     cJSON *arr = cJSON_CreateArray();
     if (!arr) return NULL;
-    GHashTableIter iter;
-    gpointer key, value;
-    g_hash_table_iter_init(&iter, cache);
-    while (g_hash_table_iter_next(&iter, &key, &value)) {
-        detection_cache_entry_t *entry = (detection_cache_entry_t*)value;
+    for (uint32_t i = 0; i < cache->count; ++i) {
+        detection_cache_entry_t *entry = &cache->entries[i];
+        int listed = listed_state(filter, entry);
+        if (listed == LISTED_NO) continue;
         cJSON *obj = cJSON_CreateObject();
-        if (!obj || !entry || !entry->id) continue;
-        if (!entry->valid ) { cJSON_Delete(obj); continue; }
-        if( entry->active == true && entry->sleep) { cJSON_Delete(obj); continue; }
-        const char* label = NiceName(entry->class_name);
-        if (!label) { cJSON_Delete(obj); continue; }
-        if (ObjectDetection_Blacklisted(label)) { cJSON_Delete(obj); continue; }
-        cJSON_AddStringToObject(obj, "class", label);
+        if (!obj) continue;
+        cJSON_AddStringToObject(obj, "class", Dictionary_Label(entry->class_code));
         cJSON_AddNumberToObject(obj, "confidence", entry->confidence);
         cJSON_AddNumberToObject(obj, "age", entry->age);
         cJSON_AddNumberToObject(obj, "distance", entry->distance/10);
@@ -398,73 +832,33 @@ static cJSON* build_detections_json(GHashTable *cache, GList **tracker_list) {
         cJSON_AddNumberToObject(obj, "timestamp", entry->timestamp);
         cJSON_AddNumberToObject(obj, "idle", entry->idle_duration);
         cJSON_AddStringToObject(obj, "id", entry->id);
-        if( config_max_idle && entry->idle_duration > config_max_idle && entry->active ) {
-            cJSON_AddBoolToObject(obj, "active", 0);
-            entry->sleep = true;
-        } else {
-            cJSON_AddBoolToObject(obj, "active", entry->active);
-        }
-        if( entry->active == false ) {
-            // Collect tracker for callback later (outside mutex)
-            bool should_publish = false;
-            cJSON *tracker_json = build_tracker_json(entry, 0, &should_publish);
-            if (should_publish && tracker_json) {
-                tracker_callback_data_t *cb_data = malloc(sizeof(tracker_callback_data_t));
-                if (cb_data) {
-                    cb_data->payload = cJSON_Duplicate(tracker_json, 1);
-                    cb_data->timer = 0;
-                    *tracker_list = g_list_prepend(*tracker_list, cb_data);
-                }
-                cJSON_Delete(tracker_json);
-            }
-        }
+        cJSON_AddBoolToObject(obj, "active", listed == LISTED_ACTIVE);
+        const tracker_attribute_t *attributes = entry_attributes(entry);
         for (size_t a = 0; a < entry->num_attributes; ++a) {
-            if (strlen(entry->attributes[a].name) && strlen(entry->attributes[a].value)) {
-                const char* aKey = entry->attributes[a].name;
-                const char* aValue = entry->attributes[a].value;
-                if( strcmp("vehicle_type",aKey) == 0 ) {
-                    cJSON_ReplaceItemInObject(obj,"class",cJSON_CreateString(NiceName(aValue)));
-                    aKey = 0; aValue = 0;
-                }
-                if( aKey && strcmp("vehicle_color",aKey) == 0) {
-                    cJSON_AddStringToObject(obj,"color",NiceName(aValue));
-                    aKey = 0; aValue = 0;
-                }
-                if( aKey && strcmp("clothing_upper_color",aKey) == 0) {
-                    cJSON_AddStringToObject(obj,"color",NiceName(aValue));
-                    aKey = 0; aValue = 0;
-                }
-                if( aKey && strcmp("clothing_lower_color",aKey) == 0) {
-                    cJSON_AddStringToObject(obj,"color2",NiceName(aValue));
-                    aKey = 0; aValue = 0;
-                }
-                if( aKey && strcmp("hat_type",aKey) == 0) {
-                    if( strcmp("no_hat", aValue ) != 0 )
-                        cJSON_AddStringToObject(obj,"type",NiceName(aValue));
-                    aKey = 0; aValue = 0;
-                }
-                if( aKey && strcmp("bag_type",aKey) == 0) {
-                    cJSON_AddStringToObject(obj,"type",NiceName(aValue));
-                    aKey = 0; aValue = 0;
-                }
-                if( aKey && strcmp("human_face_visibility",aKey) == 0 ) {
-                    if( strcmp( aValue,"face_non_visible") == 0 )
-                        cJSON_AddFalseToObject(obj,"face");
-                    else
-                        cJSON_AddTrueToObject(obj,"face");
-                    aKey = 0; aValue = 0;
-                }
-                if( aKey && strcmp("human_pose",aKey) == 0 ) {
-                    if( strcmp( aValue,"down") == 0 )
-                        cJSON_AddTrueToObject(obj,"isOnGround");
-                    else
-                        cJSON_AddFalseToObject(obj,"isOnGround");
-                    aKey = 0; aValue = 0;
-                }
-                if( aKey && aValue )
-                    cJSON_AddStringToObject(obj, entry->attributes[a].name, entry->attributes[a].value);
-            } else {
-                LOG_WARN("%s: Invalid attribute or value\n", __func__);
+            const tracker_attribute_t *attribute = &attributes[a];
+            switch (attribute->kind) {
+                case TRACKER_ATTRIBUTE_COLOR:
+                    cJSON_AddStringToObject(obj, "color", attribute->label);
+                    break;
+                case TRACKER_ATTRIBUTE_COLOR2:
+                    cJSON_AddStringToObject(obj, "color2", attribute->label);
+                    break;
+                case TRACKER_ATTRIBUTE_HAT:
+                    if (attribute->flag)
+                        cJSON_AddStringToObject(obj, "type", attribute->label);
+                    break;
+                case TRACKER_ATTRIBUTE_BAG:
+                    cJSON_AddStringToObject(obj, "type", attribute->label);
+                    break;
+                case TRACKER_ATTRIBUTE_FACE:
+                    cJSON_AddBoolToObject(obj, "face", attribute->flag);
+                    break;
+                case TRACKER_ATTRIBUTE_POSE:
+                    cJSON_AddBoolToObject(obj, "isOnGround", attribute->flag);
+                    break;
+                default:
+                    cJSON_AddStringToObject(obj, Dictionary_Name(attribute->name), Dictionary_Name(attribute->value));
+                    break;
             }
         }
         cJSON_AddItemToArray(arr, obj);
@@ -472,53 +866,55 @@ static cJSON* build_detections_json(GHashTable *cache, GList **tracker_list) {
     return arr;
 }
 
-static od_attribute_t *clone_attributes(const vod_attribute_t *src, size_t num, size_t *out_num) {
-    if (!src || num == 0) {
-        if (out_num) *out_num = 0;
-        return NULL;
+// Decode attributes into the entry, reusing its array when large enough
+// Replace the entry's attributes in place
+static void copy_attributes(detection_cache_t *cache, detection_cache_entry_t *entry, const vod_attribute_t *src, size_t num) {
+    entry->num_attributes = 0;
+    if (!src || num == 0) return;
+    size_t capacity = entry->overflow ? entry->overflow_capacity : ENTRY_INLINE_ATTRIBUTES;
+    if (num > capacity) {
+        tracker_attribute_t *overflow = realloc(entry->overflow, num * sizeof(tracker_attribute_t));
+        if (!overflow) return;
+        if (!entry->overflow)
+            cache->overflowed++;
+        entry->overflow = overflow;
+        entry->overflow_capacity = num;
     }
-    od_attribute_t *dst = calloc(num, sizeof(od_attribute_t));
-    if (!dst) {
-        if (out_num) *out_num = 0;
-        return NULL;
+    tracker_attribute_t *attributes = entry_attributes(entry);
+    for (size_t i = 0; i < num; ++i) {
+        if (src[i].type == DICT_NONE || src[i].value == DICT_NONE) continue;
+        decode_attribute(&attributes[entry->num_attributes], src[i].type, src[i].value);
+        entry->num_attributes++;
     }
-    for (size_t i = 0, j = 0; i < num; ++i) {
-        if (!src[i].name || !src[i].value) continue;
-        if (strlen(src[i].name) == 0 || strlen(src[i].value) == 0) continue;
-        strncpy(dst[j].name, src[i].name, sizeof(dst[j].name) - 1);
-        dst[j].name[sizeof(dst[j].name) - 1] = '\0';
-        strncpy(dst[j].value, src[i].value, sizeof(dst[j].value) - 1);
-        dst[j].value[sizeof(dst[j].value) - 1] = '\0';
-        ++j;
-        if (out_num) *out_num = j;
+}
+
+static void remove_inactive(detection_cache_t *cache) {
+    uint32_t i = 0;
+    while (i < cache->count) {
+        // Removal moves the last entry into slot i; re-visit it
+        if (!cache->entries[i].active)
+            cache_remove_at(cache, i);
+        else
+            i++;
     }
-    return dst;
 }
 
 void
 Adjust_For_VehicleType(detection_cache_entry_t *entry) {
-    if (!entry || !entry->attributes || entry->num_attributes == 0)
+    if (!entry || entry->num_attributes == 0)
         return;
 
+    // Apply every "vehicle_type" to the class, the last one winning, and
+    // drop it so published attributes never carry it
+    tracker_attribute_t *attributes = entry_attributes(entry);
+    size_t kept = 0;
     for (size_t i = 0; i < entry->num_attributes; ++i) {
-        if (strcmp(entry->attributes[i].name, "vehicle_type") == 0) {
-            // Set class_name to value, making sure to fit the buffer
-            strncpy(entry->class_name, entry->attributes[i].value, sizeof(entry->class_name) - 1);
-            entry->class_name[sizeof(entry->class_name) - 1] = '\0';
-
-            // Remove the attribute by shifting the others
-            for (size_t j = i; j + 1 < entry->num_attributes; ++j) {
-                entry->attributes[j] = entry->attributes[j + 1];
-            }
-            entry->num_attributes--;
-            // Optionally zero out the last slot
-            if (entry->num_attributes > 0) {
-                entry->attributes[entry->num_attributes].name[0] = '\0';
-                entry->attributes[entry->num_attributes].value[0] = '\0';
-            }
-            break; // Remove only the first "vehicle_type"
-        }
+        if (attributes[i].kind == TRACKER_ATTRIBUTE_VEHICLE_TYPE)
+            entry->class_code = attributes[i].value;
+        else
+            attributes[kept++] = attributes[i];
     }
+    entry->num_attributes = kept;
 }
 
 void distinct_direction_change(detection_cache_entry_t *entry, int cx, int cy) {
@@ -546,80 +942,449 @@ void distinct_direction_change(detection_cache_entry_t *entry, int cx, int cy) {
     entry->prev_angle = cur_angle;
 }
 
-static void VOD_Data(const vod_object_t *objects, size_t num_objects, void *user_data) {
-    g_mutex_lock(&detection_mutex);
-    if (!detectionCache) {
-        detectionCache = g_hash_table_new_full(g_str_hash, g_str_equal, free, free_detection_cache_entry);
-        if (!detectionCache) {
-            LOG_WARN("Failed to allocate detectionCache");
-            g_mutex_unlock(&detection_mutex);
+static float sample_tolerance(dict_code_t class_code) {
+    for (int i = 0; i < config_num_sample_classes; ++i)
+        if (config_sample_classes[i].class_code == class_code)
+            return config_sample_classes[i].tolerance;
+    return config_sample_tolerance;
+}
+
+static float wrap_angle(float angle) {
+    while (angle > M_PI) angle -= 2 * M_PI;
+    while (angle < -M_PI) angle += 2 * M_PI;
+    return angle;
+}
+
+// Start a new trajectory segment at (x, y)
+static void restart_trajectory(detection_cache_entry_t *entry, int x, int y) {
+    entry->anchor_x = x;
+    entry->anchor_y = y;
+    entry->cone_width = -1;
+    entry->cone_reach = 0;
+    entry->sample_pending = false;
+}
+
+// Add a centre to the segment. Every centre within the tolerance of the
+// anchor narrows nothing; beyond it, the directions from the anchor whose
+// line passes within the tolerance form a cone, and the segment's cone is
+// the intersection of them all. Returns false when the centre lies outside
+// the cone, or has turned back toward the anchor, so that no straight line
+// from the anchor through it stays within the tolerance of every centre.
+static bool extend_trajectory(detection_cache_entry_t *entry, int cx, int cy, float tolerance) {
+    float dx = cx - entry->anchor_x;
+    float dy = cy - entry->anchor_y;
+    float d = sqrtf(dx * dx + dy * dy);
+    if (d < entry->cone_reach - tolerance)
+        return false;
+    if (d > entry->cone_reach)
+        entry->cone_reach = d;
+    if (d <= tolerance)
+        return true;
+    float angle = atan2f(dy, dx);
+    float half = asinf(tolerance / d);
+    if (entry->cone_width < 0) {
+        entry->cone_angle = angle;
+        entry->cone_width = half;
+        return true;
+    }
+    float offset = wrap_angle(angle - entry->cone_angle);
+    if (fabsf(offset) > entry->cone_width)
+        return false;
+    float lo = fmaxf(-entry->cone_width, offset - half);
+    float hi = fminf(entry->cone_width, offset + half);
+    entry->cone_angle = wrap_angle(entry->cone_angle + (lo + hi) / 2);
+    entry->cone_width = (hi - lo) / 2;
+    return true;
+}
+
+// Called with the centre of a new frame before the entry is updated, so
+// the entry still holds the previous frame. Returns true when that
+// previous frame is to be published: the new centre breaks the segment
+// (the previous one is the last the segment covers) or maxInterval has
+// passed while moving. The published centre becomes the new anchor.
+static bool sample_trajectory(detection_cache_entry_t *entry, int cx, int cy, double now) {
+    float tolerance = sample_tolerance(entry->class_code);
+    double since = now - entry->last_published_tracker;
+    bool emit = entry->sample_pending || !extend_trajectory(entry, cx, cy, tolerance);
+    if (!emit && config_sample_max_interval > 0 && since >= config_sample_max_interval &&
+        entry->cone_reach > tolerance)
+        emit = true;
+    if (!emit)
+        return false;
+    if (since < config_sample_min_interval) {
+        entry->sample_pending = true;
+        return false;
+    }
+    restart_trajectory(entry, entry->cx, entry->cy);
+    extend_trajectory(entry, cx, cy, tolerance);
+    return true;
+}
+
+// Re-publish active trackers that have not been published for 1.5 s.
+// Publishing pushes an entry's heartbeat back, so only the entries that
+// are due are visited. Called on the channel's VOD thread.
+static void sweep_trackers(od_channel_t *ch, double now) {
+    detection_cache_t *cache = &ch->cache;
+    if (!cache->heartbeats_ready)
+        return;
+    TimerWheel_Callback callback;
+    void *data;
+    while (TimerWheel_Pop(&cache->heartbeats, now, &callback, &data)) {
+        detection_cache_entry_t *entry = cache_find(cache, (uint32_t)(uintptr_t)data);
+        if (!entry)
+            continue;
+        entry->heartbeat = 0;
+        if (!entry->active)
+            continue;
+        schedule_heartbeat(cache, entry, now, TRACKER_HEARTBEAT_RETRY_MS);
+        queue_tracker(cache, entry, 1, now);
+    }
+}
+
+// Deliver the payloads collected while the channel was updated, trackers
+// in the order they were queued. The detections callback takes ownership
+// of the payload. Called without config_lock.
+static void dispatch_callbacks(od_channel_t *ch, cJSON *detections_payload) {
+    if (detectionsCallback && detections_payload) {
+        detectionsCallback(detections_payload, ch->channel);
+    }
+
+    tracker_batch_t *batch = &tracker_batch;
+    for (size_t i = 0; i < batch->count; ++i) {
+        if (trackerCallback)
+            trackerCallback(&batch->items[i].event, batch->items[i].timer, ch->channel);
+    }
+    batch->count = 0;
+}
+
+// Reference point of a (rotated) box as selected by the cog setting.
+// Called with config_lock held.
+static void object_position(int rx, int ry, int rw, int rh, int *cx, int *cy) {
+    if (config_cog == 0) {
+        // Center of object
+        *cx = rx + rw / 2;
+        *cy = ry + rh / 2;
+    } else if (config_cog == 2) {
+        // Ceiling (Fisheye): shift object center toward image center,
+        // proportional to distance from image center.
+        // Image center is at (500, 500) in normalized 0-1000 space.
+        double ocx = rx + rw / 2.0;
+        double ocy = ry + rh / 2.0;
+        double dx = 500.0 - ocx;
+        double dy = 500.0 - ocy;
+        double dist = sqrt(dx * dx + dy * dy);
+        if (dist > 0.5) {
+            double r = (double)(rw > rh ? rw : rh) / 2.0 * (dist / 500.0);
+            *cx = (int)(ocx + r * dx / dist);
+            *cy = (int)(ocy + r * dy / dist);
+            if (*cx <    0) *cx =    0;
+            if (*cx > 1000) *cx = 1000;
+            if (*cy <    0) *cy =    0;
+            if (*cy > 1000) *cy = 1000;
+        } else {
+            *cx = (int)ocx;
+            *cy = (int)ocy;
+        }
+    } else {
+        // Bottom-center (feet / wheels)
+        *cx = rx + rw / 2;
+        *cy = ry + rh;
+    }
+}
+
+// ---- OBJECT BUDGET ----
+// In crowded frames only config_max_objects tracks per frame, and
+// config_max_per_class per class, are kept. Tracks already in the cache
+// always keep their place, so a published path is never cut short; a
+// new track that does not fit is refused for its whole life, so none of
+// its path is published either. Among new tracks the ones with the
+// highest priority are kept, chosen by partial selection.
+
+static int64_t budget_priority(const vod_object_t *obj, const object_filter_t *filter) {
+    int rx, ry, rw, rh;
+    rotate_bbox(obj->x, obj->y, obj->w, obj->h, &rx, &ry, &rw, &rh, config_rotation);
+    int64_t key = 0;
+    switch (config_budget_priority) {
+        case BUDGET_LARGEST:
+            key = (int64_t)rw * rh;
+            break;
+        case BUDGET_NEAREST:
+            key = ry + rh;  // Box bottom; lower in the view is closer
+            break;
+        case BUDGET_AOI: {
+            int cx, cy;
+            object_position(rx, ry, rw, rh, &cx, &cy);
+            bool inside = !filter->aoi || Zone_Contains(filter->aoi, cx, cy);
+            key = (inside ? (1 << 21) : 0) + (int64_t)rw * rh;
+            break;
+        }
+        case BUDGET_OLDEST:
+            break;      // Track ids increase, so the tie-break below decides
+    }
+    // Ties go to the older track and make every key unique
+    return (key << 32) | (UINT32_MAX - obj->id);
+}
+
+// Partial selection: move the k highest priorities to the front of c
+static void select_top(budget_candidate_t *c, size_t n, size_t k) {
+    size_t lo = 0, hi = n;
+    while (k > lo && k < hi && hi - lo > 1) {
+        size_t mid = lo + (hi - lo) / 2;
+        int64_t pivot = c[mid].priority;
+        budget_candidate_t tmp = c[mid]; c[mid] = c[hi - 1]; c[hi - 1] = tmp;
+        size_t store = lo;
+        for (size_t i = lo; i + 1 < hi; ++i) {
+            if (c[i].priority > pivot) {
+                tmp = c[i]; c[i] = c[store]; c[store] = tmp;
+                store++;
+            }
+        }
+        tmp = c[store]; c[store] = c[hi - 1]; c[hi - 1] = tmp;
+        if (store + 1 == k || store == k)
             return;
+        if (store < k)
+            lo = store + 1;
+        else
+            hi = store;
+    }
+}
+
+static void refuse(od_channel_t *ch, const vod_frame_t *frame, const budget_candidate_t *c) {
+    ch->admit[c->index] = ADMIT_NO;
+    g_hash_table_add(ch->refused, GUINT_TO_POINTER(frame->objects[c->index].id));
+    ch->budget_dropped++;
+}
+
+// ---- DUPLICATE SUPPRESSION ----
+// The same physical object is sometimes reported twice, under two ids or
+// two classes (vehicle/car, human/face). A new track whose box overlaps a
+// surviving track enough for a rule is suppressed for its whole life, like
+// a track refused by the budget. Tracks in the cache are never suppressed.
+
+static bool duplicate_of(const vod_object_t *obj, const vod_object_t *other, bool other_known, float iou) {
+    for (int r = 0; r < config_num_duplicate_rules; ++r) {
+        const duplicate_rule_t *rule = &config_duplicate_rules[r];
+        if (rule->drop != obj->class_code || rule->keep != other->class_code || iou < rule->iou)
+            continue;
+        if (rule->keep != rule->drop || other_known || other->id < obj->id)
+            return true;
+    }
+    return false;
+}
+
+static bool suppressible(dict_code_t class_code) {
+    for (int r = 0; r < config_num_duplicate_rules; ++r)
+        if (config_duplicate_rules[r].drop == class_code)
+            return true;
+    return false;
+}
+
+// Called from admit_objects with admit[] classified
+static void suppress_duplicates(od_channel_t *ch, const vod_frame_t *frame) {
+    uint8_t *admit = ch->admit;
+    uint32_t n = 0;
+    for (size_t i = 0; i < frame->num_objects; ++i)
+        if (admit[i] != ADMIT_NO && frame->objects[i].active)
+            n++;
+    if (n < 2 || !Overlap_Resize(&ch->boxes, n))
+        return;
+    if (ch->boxes.capacity > ch->iou_capacity) {
+        float *iou = realloc(ch->iou, ch->boxes.capacity * sizeof(float));
+        if (!iou) return;
+        ch->iou = iou;
+        ch->iou_capacity = ch->boxes.capacity;
+    }
+    n = 0;
+    for (size_t i = 0; i < frame->num_objects; ++i) {
+        const vod_object_t *obj = &frame->objects[i];
+        if (admit[i] == ADMIT_NO || !obj->active) continue;
+        ch->box_object[n] = (uint32_t)i;
+        Overlap_Set(&ch->boxes, n++, obj->x, obj->y, obj->w, obj->h);
+    }
+
+    for (uint32_t b = 0; b < n; ++b) {
+        uint32_t i = ch->box_object[b];
+        const vod_object_t *obj = &frame->objects[i];
+        if (admit[i] != ADMIT_NEW || !suppressible(obj->class_code))
+            continue;
+        Overlap_IoU(&ch->boxes, b, ch->iou);
+        for (uint32_t k = 0; k < n; ++k) {
+            uint32_t j = ch->box_object[k];
+            if (k == b || ch->iou[k] < config_duplicate_min_iou || admit[j] == ADMIT_NO)
+                continue;
+            if (duplicate_of(obj, &frame->objects[j], admit[j] == ADMIT_KEEP, ch->iou[k])) {
+                admit[i] = ADMIT_NO;
+                g_hash_table_add(ch->refused, GUINT_TO_POINTER(obj->id));
+                ch->duplicates++;
+                break;
+            }
         }
     }
-    double now = get_epoch_ms();
-    GHashTableIter iter;
-    gpointer key, value;
-    GList *pending_tracker_callbacks = NULL;
+}
+
+// Decide which objects of the frame are processed. Returns NULL when all
+// are, otherwise a flag per object. Called on the channel's VOD thread
+// with config_lock held.
+static const uint8_t *admit_objects(od_channel_t *ch, const vod_frame_t *frame, const object_filter_t *filter) {
+    bool budget = config_max_objects > 0 || config_max_per_class > 0;
+    bool duplicates = config_num_duplicate_rules > 0;
+    if (!budget && !duplicates && !(ch->refused && g_hash_table_size(ch->refused)))
+        return NULL;
+    size_t n = frame->num_objects;
+    if (n > ch->budget_capacity) {
+        size_t capacity = ch->budget_capacity ? ch->budget_capacity : 64;
+        while (capacity < n) capacity *= 2;
+        uint8_t *admit = realloc(ch->admit, capacity);
+        if (admit) ch->admit = admit;
+        budget_candidate_t *candidates = realloc(ch->candidates, capacity * sizeof(budget_candidate_t));
+        if (candidates) ch->candidates = candidates;
+        uint32_t *box_object = realloc(ch->box_object, capacity * sizeof(uint32_t));
+        if (box_object) ch->box_object = box_object;
+        if (!admit || !candidates || !box_object) {
+            LOG_WARN("%s: Memory allocation failed for object budget\n", __func__);
+            return NULL;
+        }
+        ch->budget_capacity = capacity;
+    }
+    if (!ch->refused)
+        ch->refused = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+    // Tracks in the cache hold their place; new ones compete for the rest
+    static __thread uint16_t class_count[DICT_MAX_NAMES];
+    if (config_max_per_class > 0)
+        memset(class_count, 0, sizeof(class_count));
+    uint8_t *admit = ch->admit;
+    budget_candidate_t *candidates = ch->candidates;
+    size_t kept = 0, num_candidates = 0;
+    for (size_t i = 0; i < n; ++i) {
+        const vod_object_t *obj = &frame->objects[i];
+        gpointer key = GUINT_TO_POINTER(obj->id);
+        admit[i] = ADMIT_KEEP;
+        if (cache_find(&ch->cache, obj->id)) {
+            kept++;
+            if (config_max_per_class > 0 && class_count[obj->class_code] < UINT16_MAX)
+                class_count[obj->class_code]++;
+        } else if (g_hash_table_contains(ch->refused, key)) {
+            admit[i] = ADMIT_NO;
+            if (!obj->active)
+                g_hash_table_remove(ch->refused, key);
+        } else if (obj->active) {
+            admit[i] = ADMIT_NEW;
+        }
+    }
+    if (duplicates)
+        suppress_duplicates(ch, frame);
+    if (!budget)
+        return admit;
+    for (size_t i = 0; i < n; ++i) {
+        if (admit[i] != ADMIT_NEW) continue;
+        budget_candidate_t *c = &candidates[num_candidates++];
+        c->index = (uint32_t)i;
+        c->class_code = frame->objects[i].class_code;
+        c->priority = budget_priority(&frame->objects[i], filter);
+    }
+
+    bool selected = false;
+    if (config_max_per_class > 0) {
+        // Group the candidates of one class at a time and keep its best
+        size_t survivors = 0, start = 0;
+        while (start < num_candidates) {
+            dict_code_t cls = candidates[start].class_code;
+            size_t end = start + 1;
+            for (size_t i = end; i < num_candidates; ++i) {
+                if (candidates[i].class_code == cls) {
+                    budget_candidate_t tmp = candidates[i]; candidates[i] = candidates[end]; candidates[end] = tmp;
+                    end++;
+                }
+            }
+            size_t slots = class_count[cls] < config_max_per_class ? (size_t)(config_max_per_class - class_count[cls]) : 0;
+            size_t group = end - start;
+            if (group > slots) {
+                select_top(candidates + start, group, slots);
+                for (size_t i = start + slots; i < end; ++i)
+                    refuse(ch, frame, &candidates[i]);
+                group = slots;
+                selected = true;
+            }
+            for (size_t i = start; i < start + group; ++i)
+                candidates[survivors++] = candidates[i];
+            start = end;
+        }
+        num_candidates = survivors;
+    }
+    if (config_max_objects > 0) {
+        size_t slots = kept < (size_t)config_max_objects ? config_max_objects - kept : 0;
+        if (num_candidates > slots) {
+            select_top(candidates, num_candidates, slots);
+            for (size_t i = slots; i < num_candidates; ++i)
+                refuse(ch, frame, &candidates[i]);
+            selected = true;
+        }
+    }
+    if (selected)
+        ch->budget_selections++;
+    return admit;
+}
+
+// Publish the channel counters. Called on the channel's VOD thread, the
+// only writer, once the frame is processed.
+static void publish_status(od_channel_t *ch) {
+    od_status_t *s = &ch->status;
+    g_atomic_int_set(&s->entries, (gint)ch->cache.count);
+    g_atomic_int_set(&s->capacity, (gint)ch->cache.capacity);
+    g_atomic_int_set(&s->high_water, (gint)ch->cache.high_water);
+    g_atomic_int_set(&s->overflowed, (gint)ch->cache.overflowed);
+    g_atomic_int_set(&s->budget_dropped, (gint)MIN(ch->budget_dropped, G_MAXINT));
+    g_atomic_int_set(&s->budget_selections, (gint)MIN(ch->budget_selections, G_MAXINT));
+    g_atomic_int_set(&s->duplicates, (gint)MIN(ch->duplicates, G_MAXINT));
+    g_atomic_int_set(&s->refused, ch->refused ? (gint)g_hash_table_size(ch->refused) : 0);
+    g_atomic_int_inc(&s->frames);
+}
 
-    for (size_t i = 0; i < num_objects; ++i) {
-        const vod_object_t *obj = &objects[i];
-        if (!obj || !obj->class_name) continue;
+static void reset_channel(od_channel_t *ch);
+static void sweep_idle_channel(od_channel_t *ch);
+
+// Called on the channel's VOD thread with each frame, and with NULL when
+// another thread has asked for work by VOD_Wake.
+static void VOD_Data(const vod_frame_t *frame, void *user_data) {
+    od_channel_t *ch = (od_channel_t*)user_data;
+    if (g_atomic_int_compare_and_exchange(&ch->reset_requested, 1, 0))
+        reset_channel(ch);
+    if (!frame) {
+        sweep_idle_channel(ch);
+        return;
+    }
+    detection_cache_t *detectionCache = &ch->cache;
+    double now = frame->timestamp;
+
+    g_rw_lock_reader_lock(&config_lock);
+    const object_filter_t *filter = current_filter();
+    const uint8_t *admit = admit_objects(ch, frame, filter);
+    for (size_t i = 0; i < frame->num_objects; ++i) {
+        if (admit && admit[i] == ADMIT_NO)
+            continue;
+        const vod_object_t *obj = &frame->objects[i];
         int rx, ry, rw, rh;
         rotate_bbox(obj->x, obj->y, obj->w, obj->h, &rx, &ry, &rw, &rh, config_rotation);
         int cx, cy;
-        if (config_cog == 0) {
-            // Center of object
-            cx = rx + rw / 2;
-            cy = ry + rh / 2;
-        } else if (config_cog == 2) {
-            // Ceiling (Fisheye): shift object center toward image center,
-            // proportional to distance from image center.
-            // Image center is at (500, 500) in normalized 0-1000 space.
-            double ocx = rx + rw / 2.0;
-            double ocy = ry + rh / 2.0;
-            double dx = 500.0 - ocx;
-            double dy = 500.0 - ocy;
-            double dist = sqrt(dx * dx + dy * dy);
-            if (dist > 0.5) {
-                double r = (double)(rw > rh ? rw : rh) / 2.0 * (dist / 500.0);
-                cx = (int)(ocx + r * dx / dist);
-                cy = (int)(ocy + r * dy / dist);
-                if (cx <    0) cx =    0;
-                if (cx > 1000) cx = 1000;
-                if (cy <    0) cy =    0;
-                if (cy > 1000) cy = 1000;
-            } else {
-                cx = (int)ocx;
-                cy = (int)ocy;
-            }
-        } else {
-            // Bottom-center (feet / wheels)
-            cx = rx + rw / 2;
-            cy = ry + rh;
-        }
+        object_position(rx, ry, rw, rh, &cx, &cy);
         bool valid = true;
-        if (obj->confidence < config_min_confidence) valid = false;
-        if (cx < config_x1 || cx > config_x2) valid = false;
-        if (cy < config_y1 || cy > config_y2) valid = false;
+        if (obj->confidence < filter->min_confidence) valid = false;
+        if (filter->aoi && !Zone_Contains(filter->aoi, cx, cy)) valid = false;
         if (rw < 5 || rh < 5) valid = false;
-        if (ObjectDetection_Blacklisted(obj->class_name)) valid = false;
-        if (rw < config_min_width || rh < config_min_height) valid = false;
-        if (rw > config_max_width || rh > config_max_height) valid = false;
-        detection_cache_entry_t *entry = (detection_cache_entry_t*)g_hash_table_lookup(detectionCache, obj->id);
+        if (filter_ignores(filter, obj->class_code)) valid = false;
+        if (rw < filter->min_width || rh < filter->min_height) valid = false;
+        if (rw > filter->max_width || rh > filter->max_height) valid = false;
+        detection_cache_entry_t *entry = cache_find(detectionCache, obj->id);
         if (!entry) {
-            entry = calloc(1, sizeof(detection_cache_entry_t));
+            entry = cache_insert(detectionCache, obj->id);
             if (!entry) {
                 LOG_WARN("Failed to allocate detection_cache_entry_t");
                 continue;
             }
-            if (!obj->id) {
-                free(entry);
-                continue;
-            }
-            strncpy(entry->id, obj->id, sizeof(entry->id)-1);
-            entry->id[sizeof(entry->id) - 1] = '\0';
-            strncpy(entry->class_name, obj->class_name, sizeof(entry->class_name)-1);
-            entry->class_name[sizeof(entry->class_name) - 1] = '\0';
+            // The published id string is formatted once per object
+            snprintf(entry->id, sizeof(entry->id), "%u", obj->id);
+            entry->class_code = obj->class_code;
             entry->confidence = obj->confidence;
             entry->x = rx;
             entry->y = ry;
@@ -648,28 +1413,14 @@ static void VOD_Data(const vod_object_t *objects, size_t num_objects, void *user
             entry->trackerSleep = false;
             entry->idle_duration = 0.0f;
             entry->idle_start_time = now;
-            entry->attributes = clone_attributes(obj->attributes, obj->num_attributes, &entry->num_attributes);
+            restart_trajectory(entry, cx, cy);
+            schedule_heartbeat(detectionCache, entry, now, TRACKER_HEARTBEAT_RETRY_MS);
+            copy_attributes(detectionCache, entry, obj->attributes, obj->num_attributes);
             entry->active = obj->active;
-            char *keycopy = strdup(entry->id);
-            if (!keycopy) {
-                free_detection_cache_entry(entry);
-                continue;
-            }
 			Adjust_For_VehicleType(entry);
 			if (valid) {
-                bool should_publish = false;
-                cJSON *tracker_json = build_tracker_json(entry, 0, &should_publish);
-                if (should_publish && tracker_json) {
-                    tracker_callback_data_t *cb_data = malloc(sizeof(tracker_callback_data_t));
-                    if (cb_data) {
-                        cb_data->payload = cJSON_Duplicate(tracker_json, 1);
-                        cb_data->timer = 0;
-                        pending_tracker_callbacks = g_list_prepend(pending_tracker_callbacks, cb_data);
-                    }
-                    cJSON_Delete(tracker_json);
-                }
+                queue_tracker(detectionCache, entry, 0, now);
             }
-            g_hash_table_insert(detectionCache, keycopy, entry);
 
         } else {
             // Cut-off area guard: detect when an existing tracked object moves outside the
@@ -677,29 +1428,16 @@ static void VOD_Data(const vod_object_t *objects, size_t num_objects, void *user
             // finalized ("lost").  If VOD later reuses the same ID (the object re-enters),
             // it will be treated as a brand-new object with its own path.
             if (config_cutoff_active && entry->valid) {
-                int inside_cutoff = (cx >= config_cutoff_x1 && cx <= config_cutoff_x2 &&
-                                     cy >= config_cutoff_y1 && cy <= config_cutoff_y2);
-                int was_inside = (entry->cx >= config_cutoff_x1 && entry->cx <= config_cutoff_x2 &&
-                                  entry->cy >= config_cutoff_y1 && entry->cy <= config_cutoff_y2);
+                int inside_cutoff = Zone_Contains(config_cutoff_zone, cx, cy);
+                int was_inside = Zone_Contains(config_cutoff_zone, entry->cx, entry->cy);
                 if (was_inside && !inside_cutoff) {
                     LOG_TRACE("%s: Object %s exited cutoff area (%d,%d) -> (%d,%d)\n", __func__,
                         entry->id, entry->cx, entry->cy, cx, cy);
                     // Publish death of current identity
                     entry->active = false;
-                    bool co_should_publish = false;
-                    cJSON *death_json = build_tracker_json(entry, 0, &co_should_publish);
-                    if (co_should_publish && death_json) {
-                        tracker_callback_data_t *cb_data = malloc(sizeof(tracker_callback_data_t));
-                        if (cb_data) {
-                            cb_data->payload = cJSON_Duplicate(death_json, 1);
-                            cb_data->timer = 0;
-                            pending_tracker_callbacks = g_list_prepend(pending_tracker_callbacks, cb_data);
-                        }
-                        cJSON_Delete(death_json);
-                    }
+                    queue_tracker(detectionCache, entry, 0, now);
                     // Reinitialize entry as a new object
-                    strncpy(entry->class_name, obj->class_name, sizeof(entry->class_name)-1);
-                    entry->class_name[sizeof(entry->class_name) - 1] = '\0';
+                    entry->class_code = obj->class_code;
                     entry->active = obj->active;
                     entry->confidence = obj->confidence;
                     entry->x = rx;
@@ -729,30 +1467,18 @@ static void VOD_Data(const vod_object_t *objects, size_t num_objects, void *user
                     entry->idle = false;
                     entry->sleep = false;
                     entry->trackerSleep = false;
-                    if (entry->attributes) {
-                        free(entry->attributes);
-                        entry->attributes = NULL;
-                        entry->num_attributes = 0;
-                    }
-                    entry->attributes = clone_attributes(obj->attributes, obj->num_attributes, &entry->num_attributes);
+                    restart_trajectory(entry, cx, cy);
+                    copy_attributes(detectionCache, entry, obj->attributes, obj->num_attributes);
                     Adjust_For_VehicleType(entry);
                     // Publish birth tracker for new identity
                     if (entry->valid) {
-                        co_should_publish = false;
-                        cJSON *birth_json = build_tracker_json(entry, 0, &co_should_publish);
-                        if (co_should_publish && birth_json) {
-                            tracker_callback_data_t *cb_data = malloc(sizeof(tracker_callback_data_t));
-                            if (cb_data) {
-                                cb_data->payload = cJSON_Duplicate(birth_json, 1);
-                                cb_data->timer = 0;
-                                pending_tracker_callbacks = g_list_prepend(pending_tracker_callbacks, cb_data);
-                            }
-                            cJSON_Delete(birth_json);
-                        }
+                        queue_tracker(detectionCache, entry, 0, now);
                     }
                     continue;  // Skip normal update processing
                 }
             }
+            bool sampling = config_sample_tolerance > 0;
+            bool emit = sampling && entry->valid && !entry->sleep && sample_trajectory(entry, cx, cy, now);
             float dist = calc_distance(entry->prev_cx, entry->prev_cy, cx, cy);
             if (dist < IDLE_THRESHOLD_PCT) {
                 if (!entry->idle) {
@@ -762,9 +1488,17 @@ static void VOD_Data(const vod_object_t *objects, size_t num_objects, void *user
                 entry->idle_duration = (now - entry->idle_start_time) / 1000.0f;
                 if( entry->idle_duration > entry->max_idle_duration )
                     entry->max_idle_duration = floor((entry->idle_duration*10)+0.5) / 10.0;
+                if (emit)
+                    queue_tracker(detectionCache, entry, 0, now);
             } else {
 				distinct_direction_change(entry, cx, cy);
                 if( entry->sleep ) {
+                    // Waking up is always published and starts a new segment
+                    if (sampling && !emit) {
+                        restart_trajectory(entry, entry->cx, entry->cy);
+                        extend_trajectory(entry, cx, cy, sample_tolerance(entry->class_code));
+                    }
+                    emit = true;
                     entry->sleep = false;
                     entry->bx = cx;
                     entry->by = cy;
@@ -785,17 +1519,8 @@ static void VOD_Data(const vod_object_t *objects, size_t num_objects, void *user
 				if( entry->speed > entry->maxSpeed )
 					entry->maxSpeed = entry->speed;
                 entry->idle = false;
-                bool should_publish = false;
-                cJSON *tracker_json = build_tracker_json(entry, 0, &should_publish);
-                if (should_publish && tracker_json) {
-                    tracker_callback_data_t *cb_data = malloc(sizeof(tracker_callback_data_t));
-                    if (cb_data) {
-                        cb_data->payload = cJSON_Duplicate(tracker_json, 1);
-                        cb_data->timer = 0;
-                        pending_tracker_callbacks = g_list_prepend(pending_tracker_callbacks, cb_data);
-                    }
-                    cJSON_Delete(tracker_json);
-                }
+                if (emit || !sampling)
+                    queue_tracker(detectionCache, entry, 0, now);
                 entry->idle_duration = 0.0f;
                 entry->idle_start_time = now;
                 entry->prev_cx = cx;
@@ -814,178 +1539,135 @@ static void VOD_Data(const vod_object_t *objects, size_t num_objects, void *user
             entry->age = round(10.0 * ((now - entry->birthTime) / 1000.0)) / 10.0;
             if( entry->valid == false && valid == true)
                 entry->valid = true;
-            if (entry->attributes) {
-                free(entry->attributes);
-                entry->attributes = NULL;
-                entry->num_attributes = 0;
-            }
-            entry->attributes = clone_attributes(obj->attributes, obj->num_attributes, &entry->num_attributes);
+            copy_attributes(detectionCache, entry, obj->attributes, obj->num_attributes);
             entry->active = obj->active;
 			Adjust_For_VehicleType(entry);
         }
     }
 
-    // Build detections JSON (this also collects more tracker callbacks)
-    cJSON *detections_json = build_detections_json(detectionCache, &pending_tracker_callbacks);
-    cJSON *detections_payload = detections_json ? cJSON_Duplicate(detections_json, 1) : NULL;
-    if (detections_json) cJSON_Delete(detections_json);
+    ch->last_frame_time = now;
+    sweep_trackers(ch, now);
+
+    // Build the detections list only when its subscriber will use it
+    cJSON *detections_payload = NULL;
+    if (detectionsCallback && (!detectionsDue || detectionsDue(ch->channel) || count_ended(detectionCache)))
+        detections_payload = build_detections_json(detectionCache);
+    settle_listed(detectionCache, now);
+    g_rw_lock_reader_unlock(&config_lock);
 
     // Remove inactive objects
-    g_hash_table_iter_init(&iter, detectionCache);
-    GList *remove_list = NULL;
-    while (g_hash_table_iter_next(&iter, &key, &value)) {
-        detection_cache_entry_t *entry = (detection_cache_entry_t*)value;
-        if (!entry->active) {
-            remove_list = g_list_prepend(remove_list, key);
-        }
-    }
-    for (GList *l = remove_list; l != NULL; l = l->next) {
-        g_hash_table_remove(detectionCache, l->data);
-    }
-    g_list_free(remove_list);
+    remove_inactive(detectionCache);
+    publish_status(ch);
 
-    g_mutex_unlock(&detection_mutex);
+    dispatch_callbacks(ch, detections_payload);
+}
 
-    // Now call callbacks WITHOUT holding the mutex
-    if (detectionsCallback && detections_payload) {
-        detectionsCallback(detections_payload);
-    }
+double ObjectDetection_Time(void) {
+    return VOD_Time();
+}
 
-    for (GList *l = pending_tracker_callbacks; l != NULL; l = l->next) {
-        tracker_callback_data_t *cb_data = (tracker_callback_data_t*)l->data;
-        if (trackerCallback && cb_data->payload) {
-            trackerCallback(cb_data->payload, cb_data->timer);
-        }
-        free(cb_data);
-    }
-    g_list_free(pending_tracker_callbacks);
+void ObjectDetection_Detections_Due(ObjectDetection_Due_Callback due) {
+    detectionsDue = due;
 }
 
-void ObjectDetection_Reset() {
-    g_mutex_lock(&detection_mutex);
+int ObjectDetection_Channel_Index(int channel) {
+    for (int i = 0; i < od_num_channels; ++i)
+        if (od_channels[i].channel == channel)
+            return i;
+    return -1;
+}
 
-    GList *pending_tracker_callbacks = NULL;
-    cJSON *detections_payload = NULL;
+static void reset_channel(od_channel_t *ch) {
+    g_rw_lock_reader_lock(&config_lock);
 
-    if (detectionCache) {
-        // Temporary hash table to hold valid objects for publishing
-        GHashTable *validCache = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, NULL);
-
-        GHashTableIter iter;
-        gpointer key, value;
-        g_hash_table_iter_init(&iter, detectionCache);
-        while (g_hash_table_iter_next(&iter, &key, &value)) {
-            detection_cache_entry_t *entry = (detection_cache_entry_t*)value;
-            if (entry->valid) {
-                // Set active to false before publishing
-                entry->active = false;
-                // Insert into validCache for publishing
-                g_hash_table_insert(validCache, key, entry);
-            }
-        }
+    cJSON *detections_payload = NULL;
+    double now = VOD_Channel_Time(ch->channel);
 
-        // Build trackers for valid objects
-        GHashTableIter validIter;
-        gpointer vkey, vvalue;
-        g_hash_table_iter_init(&validIter, validCache);
-        while (g_hash_table_iter_next(&validIter, &vkey, &vvalue)) {
-            detection_cache_entry_t *entry = (detection_cache_entry_t*)vvalue;
-            bool should_publish = false;
-            cJSON *tracker_json = build_tracker_json(entry, 0, &should_publish);
-            if (should_publish && tracker_json) {
-                tracker_callback_data_t *cb_data = malloc(sizeof(tracker_callback_data_t));
-                if (cb_data) {
-                    cb_data->payload = cJSON_Duplicate(tracker_json, 1);
-                    cb_data->timer = 0;
-                    pending_tracker_callbacks = g_list_prepend(pending_tracker_callbacks, cb_data);
-                }
-                cJSON_Delete(tracker_json);
-            }
+    if (ch->cache.count) {
+        // End every valid object and publish its tracker
+        for (uint32_t i = 0; i < ch->cache.count; ++i) {
+            detection_cache_entry_t *entry = &ch->cache.entries[i];
+            if (!entry->valid)
+                continue;
+            entry->active = false;
+            queue_tracker(&ch->cache, entry, 0, now);
         }
 
-        // Build detections for valid objects
-        cJSON *detections_json = build_detections_json(validCache, &pending_tracker_callbacks);
-        detections_payload = detections_json ? cJSON_Duplicate(detections_json, 1) : NULL;
-        if (detections_json) cJSON_Delete(detections_json);
-
-        // Destroy the old cache
-        g_hash_table_destroy(detectionCache);
-        detectionCache = NULL;
-
-        // Destroy the temporary validCache (does not free keys/values)
-        g_hash_table_destroy(validCache);
+        // Build detections for valid objects; invalid ones are skipped
+        detections_payload = build_detections_json(&ch->cache);
+        settle_listed(&ch->cache, now);
     }
+    cache_clear(&ch->cache);
+    // Every track starts over, so refused ones compete again
+    if (ch->refused)
+        g_hash_table_remove_all(ch->refused);
 
-    // Create a new empty cache
-    detectionCache = g_hash_table_new_full(g_str_hash, g_str_equal, free, free_detection_cache_entry);
-
-    g_mutex_unlock(&detection_mutex);
-
-    // Now call callbacks WITHOUT holding the mutex
-    if (detectionsCallback && detections_payload) {
-        detectionsCallback(detections_payload);
-    }
+    g_rw_lock_reader_unlock(&config_lock);
+    publish_status(ch);
 
-    for (GList *l = pending_tracker_callbacks; l != NULL; l = l->next) {
-        tracker_callback_data_t *cb_data = (tracker_callback_data_t*)l->data;
-        if (trackerCallback && cb_data->payload) {
-            trackerCallback(cb_data->payload, cb_data->timer);
-        }
-        free(cb_data);
-    }
-    g_list_free(pending_tracker_callbacks);
+    dispatch_callbacks(ch, detections_payload);
 }
 
-gboolean update_trackers(gpointer user_data) {
-    g_mutex_lock(&detection_mutex);
-    if( !detectionCache ) {
-        g_mutex_unlock(&detection_mutex);
-        return TRUE;
+// Each channel ends its trackers on its own VOD thread, before the next
+// frame it processes.
+void ObjectDetection_Reset() {
+    for (int i = 0; i < od_num_channels; ++i) {
+        g_atomic_int_set(&od_channels[i].reset_requested, 1);
+        VOD_Wake(od_channels[i].channel);
     }
-    double now = get_epoch_ms();
-    GHashTableIter iter;
-    gpointer key, value;
-    GList *pending_callbacks = NULL;
+}
 
-    g_hash_table_iter_init(&iter, detectionCache);
-    while (g_hash_table_iter_next(&iter, &key, &value)) {
-        detection_cache_entry_t *entry = (detection_cache_entry_t*)value;
-        if( entry->active == true && now - entry->last_published_tracker > 1500 ) {
-            bool should_publish = false;
-            cJSON *tracker_json = build_tracker_json(entry, 1, &should_publish);
-            if (should_publish && tracker_json) {
-                tracker_callback_data_t *cb_data = malloc(sizeof(tracker_callback_data_t));
-                if (cb_data) {
-                    cb_data->payload = cJSON_Duplicate(tracker_json, 1);
-                    cb_data->timer = 1;
-                    pending_callbacks = g_list_prepend(pending_callbacks, cb_data);
-                }
-                cJSON_Delete(tracker_json);
-            }
-        }
-    }
-    g_mutex_unlock(&detection_mutex);
+// Frames drive the tracker sweep on frame time; during a gap in the frame
+// flow update_trackers wakes the VOD thread for it.
+static void sweep_idle_channel(od_channel_t *ch) {
+    double now = VOD_Channel_Time(ch->channel);
+    if (ch->cache.count == 0 || now - ch->last_frame_time < 1000)
+        return;
+    g_rw_lock_reader_lock(&config_lock);
+    sweep_trackers(ch, now);
+    g_rw_lock_reader_unlock(&config_lock);
+    dispatch_callbacks(ch, NULL);
+}
 
-    // Call callbacks WITHOUT holding the mutex
-    for (GList *l = pending_callbacks; l != NULL; l = l->next) {
-        tracker_callback_data_t *cb_data = (tracker_callback_data_t*)l->data;
-        if (trackerCallback && cb_data->payload) {
-            trackerCallback(cb_data->payload, cb_data->timer);
-        }
-        free(cb_data);
+// Status from the published counters; never waits for a frame in progress
+static void update_trackers(void *user_data) {
+    refresh_filter();
+    for (int i = 0; i < od_num_channels; ++i) {
+        od_channel_t *ch = &od_channels[i];
+        od_status_t *s = &ch->status;
+        gint entries = g_atomic_int_get(&s->entries);
+        ACAP_STATUS_SetNumber(ch->status_group, "budgetDropped", g_atomic_int_get(&s->budget_dropped));
+        ACAP_STATUS_SetNumber(ch->status_group, "budgetRefused", g_atomic_int_get(&s->refused));
+        ACAP_STATUS_SetNumber(ch->status_group, "budgetSelections", g_atomic_int_get(&s->budget_selections));
+        ACAP_STATUS_SetNumber(ch->status_group, "duplicates", g_atomic_int_get(&s->duplicates));
+        ACAP_STATUS_SetNumber(ch->status_group, "cacheEntries", entries);
+        ACAP_STATUS_SetNumber(ch->status_group, "cacheCapacity", g_atomic_int_get(&s->capacity));
+        ACAP_STATUS_SetNumber(ch->status_group, "cacheHighWater", g_atomic_int_get(&s->high_water));
+        ACAP_STATUS_SetNumber(ch->status_group, "attributeOverflow", g_atomic_int_get(&s->overflowed));
+        // No frame since the last update: let the VOD thread sweep the gap
+        gint frames = g_atomic_int_get(&s->frames);
+        if (entries && frames == ch->frames_checked)
+            VOD_Wake(ch->channel);
+        ch->frames_checked = frames;
     }
-    g_list_free(pending_callbacks);
 
-    return TRUE;
+    TimerWheel_Main_Schedule(1000, update_trackers, NULL);
 }
 
 int ObjectDetection_Init(ObjectDetection_Callback detections, TrackerDetection_Callback tracker) {
-    g_mutex_lock(&detection_mutex);
     LOG_TRACE("%s: Entry\n",__func__);
     detectionsCallback = detections;
     trackerCallback = tracker;
-    if (!detectionCache)
-        detectionCache = g_hash_table_new_full(g_str_hash, g_str_equal, free, free_detection_cache_entry);
+    intern_attribute_codes();
+    if (!current_filter()) {
+        object_filter_t *filter = compile_filter(NULL);
+        if (!filter) {
+            LOG_WARN("%s: Unable to compile object filter\n", __func__);
+            return 0;
+        }
+        swap_filter(filter);
+    }
+
 	int allow_predictions = 0;
 	cJSON* settings = ACAP_Get_Config("settings");
 	cJSON* scene = settings?cJSON_GetObjectItem(settings,"scene"):0;
@@ -993,10 +1675,60 @@ int ObjectDetection_Init(ObjectDetection_Callback detections, TrackerDetection_C
 	if( tracker_confidence && tracker_confidence->type==cJSON_False)
 		allow_predictions = 1;
 
-    if (VOD_Init(0, VOD_Data, NULL, allow_predictions) != 0) {
+	cJSON* pipeline = settings?cJSON_GetObjectItem(settings,"pipeline"):0;
+	cJSON* queueDepth = pipeline?cJSON_GetObjectItem(pipeline,"queueDepth"):0;
+	cJSON* overflow = pipeline?cJSON_GetObjectItem(pipeline,"overflow"):0;
+	VOD_Queue_Config( queueDepth ? queueDepth->valueint : 0,
+	                  cJSON_IsString(overflow) ? overflow->valuestring : "drop-oldest" );
+	cJSON* decimation = pipeline?cJSON_GetObjectItem(pipeline,"decimation"):0;
+	cJSON* budget = decimation?cJSON_GetObjectItem(decimation,"budget"):0;
+	cJSON* cpuLimit = decimation?cJSON_GetObjectItem(decimation,"cpuLimit"):0;
+	cJSON* maxStride = decimation?cJSON_GetObjectItem(decimation,"maxStride"):0;
+	VOD_Decimation_Config( cJSON_IsNumber(budget) ? budget->valueint : 50,
+	                       cJSON_IsNumber(cpuLimit) ? cpuLimit->valueint : 80,
+	                       cJSON_IsNumber(maxStride) ? maxStride->valueint : 4 );
+	cJSON* missingFrames = pipeline?cJSON_GetObjectItem(pipeline,"missingFrames"):0;
+	VOD_Expiry_Config( cJSON_IsNumber(missingFrames) ? missingFrames->valueint : 0 );
+
+	// One pipeline shard per channel; the first channel that subscribes is the primary
+	cJSON* channels = pipeline?cJSON_GetObjectItem(pipeline,"channels"):0;
+	int requested[OBJECTDETECTION_MAX_CHANNELS];
+	int num_requested = 0;
+	cJSON* item = cJSON_IsArray(channels) ? channels->child : 0;
+	for( ; item; item = item->next ) {
+		if( !cJSON_IsNumber(item) ) continue;
+		if( num_requested == OBJECTDETECTION_MAX_CHANNELS ) {
+			LOG_WARN("%s: Only the first %d channels are used\n", __func__, OBJECTDETECTION_MAX_CHANNELS);
+			break;
+		}
+		requested[num_requested++] = item->valueint;
+	}
+	if( num_requested == 0 )
+		requested[num_requested++] = 0;
+
+    for (int i = 0; i < num_requested; ++i) {
+        od_channel_t *ch = &od_channels[od_num_channels];
+        ch->channel = requested[i];
+        if (od_num_channels == 0)
+            snprintf(ch->status_group, sizeof(ch->status_group), "objectdetection");
+        else
+            snprintf(ch->status_group, sizeof(ch->status_group), "objectdetection_%d", ch->channel);
+        ch->last_frame_time = 0;
+        memset(&ch->status, 0, sizeof(ch->status));
+        ch->reset_requested = 0;
+        ch->frames_checked = 0;
+        memset(&ch->cache, 0, sizeof(ch->cache));
+        // Count the channel first; VOD may deliver frames before VOD_Init returns
+        od_num_channels++;
+        if (VOD_Init(ch->channel, VOD_Data, ch, allow_predictions) != 0) {
+            LOG_WARN("%s: Object detection service failed on channel %d\n", __func__, ch->channel);
+            od_num_channels--;
+            cache_free(&ch->cache);
+        }
+    }
+    if (od_num_channels == 0) {
         LOG_WARN("%s: Object detection service failed\n", __func__);
         LOG_TRACE("%s: Exit\n",__func__);
-        g_mutex_unlock(&detection_mutex);
         return 0;
     }
 
@@ -1021,9 +1753,13 @@ int ObjectDetection_Init(ObjectDetection_Callback detections, TrackerDetection_C
     LOG("%s: Storing %d labels in status\n", __func__, cJSON_GetArraySize(labels));
     ACAP_STATUS_SetObject("detections", "labels", labels);
     cJSON_Delete(labels);
-    g_timeout_add_seconds(1, update_trackers, NULL);	
+    cJSON* active = cJSON_CreateArray();
+    for (int i = 0; i < od_num_channels; ++i)
+        cJSON_AddItemToArray(active, cJSON_CreateNumber(od_channels[i].channel));
+    ACAP_STATUS_SetObject("objectdetection", "channels", active);
+    cJSON_Delete(active);
+    TimerWheel_Main_Schedule(1000, update_trackers, NULL);
     LOG_TRACE("%s: Exit\n",__func__);
-    g_mutex_unlock(&detection_mutex);
 
     return 1;
 }
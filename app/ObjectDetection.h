@@ -5,15 +5,88 @@
 #ifndef ObjectDetection_H
 #define ObjectDetection_H
 
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
 #include "cJSON.h"
+#include "Dictionary.h"
+#include "JsonWriter.h"
 
-typedef void (*ObjectDetection_Callback)( cJSON *detections  );
-typedef void (*TrackerDetection_Callback)( cJSON *detections, int timer );
-//Subscribers are responsible for deleting the cJSON object.
+#define OBJECTDETECTION_MAX_CHANNELS 4     // Entries used from settings pipeline.channels
+#define TRACKER_MAX_ATTRIBUTES 16
+
+// How an attribute is published, resolved once when it is ingested
+typedef enum {
+    TRACKER_ATTRIBUTE_OTHER = 0,    // Published as name: value
+    TRACKER_ATTRIBUTE_VEHICLE_TYPE, // Replaces the class
+    TRACKER_ATTRIBUTE_COLOR,        // vehicle_color, clothing_upper_color
+    TRACKER_ATTRIBUTE_COLOR2,       // clothing_lower_color
+    TRACKER_ATTRIBUTE_HAT,          // hat_type
+    TRACKER_ATTRIBUTE_BAG,          // bag_type
+    TRACKER_ATTRIBUTE_FACE,         // human_face_visibility
+    TRACKER_ATTRIBUTE_POSE          // human_pose
+} tracker_attribute_kind_t;
+
+typedef struct {
+    dict_code_t name;       // Attribute type, e.g. vehicle_color
+    dict_code_t value;      // Attribute class, e.g. blue
+    uint8_t kind;           // tracker_attribute_kind_t
+    bool flag;              // HAT: a hat is worn, FACE: visible, POSE: down
+    const char *label;      // Display name of value
+} tracker_attribute_t;
+
+// One tracker update. Owned by ObjectDetection and valid until the
+// callback returns; consumers copy what they keep.
+typedef struct {
+    char id[32];                // Published tracker id
+    dict_code_t class_code;     // Class, vehicle_type applied
+    const char *label;          // Display name of the class
+    int confidence;
+    double age;                 // Seconds since birth
+    int distance;               // Percent of the view traversed
+    int directions;             // Distinct direction changes
+    int x, y, w, h;             // Box in [0..1000] view space
+    int cx, cy;                 // Reference point selected by the cog setting
+    int dx, dy;                 // Displacement from the birth position
+    int bx, by;                 // Birth position
+    double timestamp;           // Epoch ms of this update
+    double previousTimestamp;   // Epoch ms of the previous position update
+    double birth;               // Epoch ms
+    double idle;                // Seconds without significant movement
+    double maxIdle;             // Longest idle period, seconds
+    double speed;
+    double maxSpeed;
+    bool active;                // False on the final update
+    // Decoded attributes; NULL or -1 when not reported
+    const char *color;
+    const char *color2;
+    const char *hat;
+    int face;
+    tracker_attribute_t attributes[TRACKER_MAX_ATTRIBUTES];   // As reported, in order
+    size_t num_attributes;
+    char anomaly[64];           // Set by the anomaly check, empty if none
+} tracker_event_t;
+
+typedef void (*ObjectDetection_Callback)( cJSON *detections, int channel );
+typedef void (*TrackerDetection_Callback)( tracker_event_t *event, int timer, int channel );
+// Asked on the channel's thread whether this frame's detections list is
+// used; frames where it is not, and no object ends, get no list.
+typedef int  (*ObjectDetection_Due_Callback)( int channel );
+//Subscribers are responsible for deleting the detections cJSON object.
+//Tracker events are only valid during the callback.
+//Callbacks for different channels may run concurrently on their own threads.
 
 int		ObjectDetection_Init( ObjectDetection_Callback detections, TrackerDetection_Callback tracker);
 void	ObjectDetection_Config( cJSON* data );
 void	ObjectDetection_Reset();
 cJSON*	ObjectDetection_Labels(void);
+// Pipeline time in epoch ms; the frame time while callbacks run
+double	ObjectDetection_Time(void);
+// Skip building the detections list for frames the subscriber discards
+void	ObjectDetection_Detections_Due( ObjectDetection_Due_Callback due );
+// The tracker message as published on MQTT, without the device members
+void	ObjectDetection_Tracker_Write(json_writer_t *w, const tracker_event_t *event);
+// Position of channel in settings pipeline.channels (0 = primary), -1 if not running
+int		ObjectDetection_Channel_Index(int channel);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,110 @@
+/*------------------------------------------------------------------
+ *  Overlap.c
+ *  Fred Juhlin (2025)
+ *------------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include <string.h>
+#include "Overlap.h"
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define OVERLAP_NEON 1
+#elif defined(__SSE__) || defined(__x86_64__)
+#include <xmmintrin.h>
+#define OVERLAP_SSE 1
+#endif
+
+static int grow(float **array, uint32_t capacity) {
+    float *p = realloc(*array, capacity * sizeof(float));
+    if (!p) return 0;
+    *array = p;
+    return 1;
+}
+
+int Overlap_Resize(overlap_boxes_t *boxes, uint32_t count) {
+    uint32_t lanes = (count + OVERLAP_LANES - 1) & ~(uint32_t)(OVERLAP_LANES - 1);
+    if (lanes > boxes->capacity) {
+        uint32_t capacity = boxes->capacity ? boxes->capacity : 64;
+        while (capacity < lanes) capacity *= 2;
+        if (!grow(&boxes->x1, capacity) || !grow(&boxes->y1, capacity) ||
+            !grow(&boxes->x2, capacity) || !grow(&boxes->y2, capacity) ||
+            !grow(&boxes->area, capacity))
+            return 0;
+        boxes->capacity = capacity;
+    }
+    boxes->count = count;
+    // Padding lanes: empty boxes with a non-zero area never divide by zero
+    for (uint32_t i = count; i < lanes; ++i) {
+        boxes->x1[i] = boxes->y1[i] = boxes->x2[i] = boxes->y2[i] = 0;
+        boxes->area[i] = 1;
+    }
+    return 1;
+}
+
+void Overlap_Free(overlap_boxes_t *boxes) {
+    free(boxes->x1);
+    free(boxes->y1);
+    free(boxes->x2);
+    free(boxes->y2);
+    free(boxes->area);
+    memset(boxes, 0, sizeof(*boxes));
+}
+
+void Overlap_Set(overlap_boxes_t *boxes, uint32_t i, int x, int y, int w, int h) {
+    boxes->x1[i] = (float)x;
+    boxes->y1[i] = (float)y;
+    boxes->x2[i] = (float)(x + w);
+    boxes->y2[i] = (float)(y + h);
+    boxes->area[i] = w > 0 && h > 0 ? (float)w * (float)h : 1;
+}
+
+void Overlap_IoU(const overlap_boxes_t *boxes, uint32_t i, float *iou) {
+    uint32_t lanes = Overlap_Lanes(boxes);
+#if defined(OVERLAP_NEON)
+    float32x4_t x1 = vdupq_n_f32(boxes->x1[i]);
+    float32x4_t y1 = vdupq_n_f32(boxes->y1[i]);
+    float32x4_t x2 = vdupq_n_f32(boxes->x2[i]);
+    float32x4_t y2 = vdupq_n_f32(boxes->y2[i]);
+    float32x4_t area = vdupq_n_f32(boxes->area[i]);
+    float32x4_t zero = vdupq_n_f32(0);
+    for (uint32_t k = 0; k < lanes; k += OVERLAP_LANES) {
+        float32x4_t w = vmaxq_f32(vsubq_f32(vminq_f32(x2, vld1q_f32(boxes->x2 + k)),
+                                            vmaxq_f32(x1, vld1q_f32(boxes->x1 + k))), zero);
+        float32x4_t h = vmaxq_f32(vsubq_f32(vminq_f32(y2, vld1q_f32(boxes->y2 + k)),
+                                            vmaxq_f32(y1, vld1q_f32(boxes->y1 + k))), zero);
+        float32x4_t inter = vmulq_f32(w, h);
+        float32x4_t uni = vsubq_f32(vaddq_f32(area, vld1q_f32(boxes->area + k)), inter);
+        // ARMv7 has no vector divide; two Newton steps give full float precision
+        float32x4_t r = vrecpeq_f32(uni);
+        r = vmulq_f32(vrecpsq_f32(uni, r), r);
+        r = vmulq_f32(vrecpsq_f32(uni, r), r);
+        vst1q_f32(iou + k, vmulq_f32(inter, r));
+    }
+#elif defined(OVERLAP_SSE)
+    __m128 x1 = _mm_set1_ps(boxes->x1[i]);
+    __m128 y1 = _mm_set1_ps(boxes->y1[i]);
+    __m128 x2 = _mm_set1_ps(boxes->x2[i]);
+    __m128 y2 = _mm_set1_ps(boxes->y2[i]);
+    __m128 area = _mm_set1_ps(boxes->area[i]);
+    __m128 zero = _mm_setzero_ps();
+    for (uint32_t k = 0; k < lanes; k += OVERLAP_LANES) {
+        __m128 w = _mm_max_ps(_mm_sub_ps(_mm_min_ps(x2, _mm_loadu_ps(boxes->x2 + k)),
+                                         _mm_max_ps(x1, _mm_loadu_ps(boxes->x1 + k))), zero);
+        __m128 h = _mm_max_ps(_mm_sub_ps(_mm_min_ps(y2, _mm_loadu_ps(boxes->y2 + k)),
+                                         _mm_max_ps(y1, _mm_loadu_ps(boxes->y1 + k))), zero);
+        __m128 inter = _mm_mul_ps(w, h);
+        __m128 uni = _mm_sub_ps(_mm_add_ps(area, _mm_loadu_ps(boxes->area + k)), inter);
+        _mm_storeu_ps(iou + k, _mm_div_ps(inter, uni));
+    }
+#else
+    for (uint32_t k = 0; k < lanes; ++k) {
+        float w = (boxes->x2[i] < boxes->x2[k] ? boxes->x2[i] : boxes->x2[k]) -
+                  (boxes->x1[i] > boxes->x1[k] ? boxes->x1[i] : boxes->x1[k]);
+        float h = (boxes->y2[i] < boxes->y2[k] ? boxes->y2[i] : boxes->y2[k]) -
+                  (boxes->y1[i] > boxes->y1[k] ? boxes->y1[i] : boxes->y1[k]);
+        float inter = (w > 0 ? w : 0) * (h > 0 ? h : 0);
+        iou[k] = inter / (boxes->area[i] + boxes->area[k] - inter);
+    }
+#endif
+}
@@ -0,0 +1,55 @@
+/*------------------------------------------------------------------
+ *  Overlap.h
+ *  Box overlap for duplicate suppression. Boxes are stored as
+ *  structure-of-arrays so the IoU of one box against all others is
+ *  computed four lanes at a time: NEON on ARM, SSE on x86 and plain C
+ *  elsewhere.
+ *  Fred Juhlin (2025)
+ *------------------------------------------------------------------*/
+
+#ifndef OVERLAP_H
+#define OVERLAP_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define OVERLAP_LANES 4
+
+typedef struct {
+    float *x1, *y1, *x2, *y2;
+    float *area;
+    uint32_t count;      // Boxes in use
+    uint32_t capacity;   // Allocated lanes, a multiple of OVERLAP_LANES
+} overlap_boxes_t;
+
+/**
+ * Size the set for count boxes. Lanes past count are filled with empty
+ * boxes that overlap nothing. Arrays only grow.
+ * @return 1 on success, 0 on allocation failure.
+ */
+int      Overlap_Resize(overlap_boxes_t *boxes, uint32_t count);
+void     Overlap_Free(overlap_boxes_t *boxes);
+
+// Store box i; x, y, w, h in the [0..1000] view space
+void     Overlap_Set(overlap_boxes_t *boxes, uint32_t i, int x, int y, int w, int h);
+
+/**
+ * IoU of box i against every box, including itself.
+ * @param iou  Receives Overlap_Lanes(boxes) values.
+ */
+void     Overlap_IoU(const overlap_boxes_t *boxes, uint32_t i, float *iou);
+
+// Count rounded up to whole lanes
+static inline uint32_t Overlap_Lanes(const overlap_boxes_t *boxes) {
+    return (boxes->count + OVERLAP_LANES - 1) & ~(uint32_t)(OVERLAP_LANES - 1);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // OVERLAP_H
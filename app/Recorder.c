@@ -0,0 +1,560 @@
+/*------------------------------------------------------------------
+ *  Recorder.c
+ *  Fred Juhlin (2025)
+ *------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <time.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <syslog.h>
+#include "Recorder.h"
+#include "VOD.h"
+#include "ACAP.h"
+
+#define LOG(fmt, args...) { syslog(LOG_INFO, fmt, ## args); printf(fmt, ## args); }
+#define LOG_WARN(fmt, args...) { syslog(LOG_WARNING, fmt, ## args); printf(fmt, ## args); }
+//#define LOG_TRACE(fmt, args...) { syslog(LOG_INFO, fmt, ## args); printf(fmt, ## args); }
+#define LOG_TRACE(fmt, args...) {}
+
+#define RECORDER_BUFFER_SIZE    (4u << 20)      // Power of two
+#define RECORDER_DIR            "localdata/"
+#define RECORDER_PREFIX         "scene_"
+#define RECORDER_SUFFIX         ".dqr"
+#define RECORDER_MAX_LISTED     64
+
+G_STATIC_ASSERT(sizeof(recorder_record_t) == 16);
+
+enum { REC_IDLE, REC_RECORDING, REC_FLUSHING };
+
+typedef struct {
+    // Ring of records, subscriber thread -> writer thread
+    uint8_t *buffer;
+    guint mask;
+    volatile gint head;
+    volatile gint tail;
+    volatile gint recording;    // Gate checked by the subscriber thread
+    volatile gint dropped;
+    gint64 start_us;            // Monotonic start, set before recording opens
+    sem_t pending;
+    pthread_t writer;
+    bool writer_running;
+    volatile gint quit;
+
+    GMutex lock;                // Protects everything below
+    int state;
+    char *info;                 // INFO record, JSON
+    uint8_t *detector;          // DETECTOR record
+    size_t detector_size;
+    char name[48];              // scene_YYYYMMDD_HHMMSS
+    int segment;
+    FILE *file;
+    char file_name[64];
+    uint64_t file_bytes;
+    uint64_t total_bytes;
+    uint64_t frames;
+    gint64 max_us;
+    uint64_t max_bytes;
+    const char *stop_reason;
+
+    // Settings
+    int max_seconds;
+    int max_megabytes;
+    int segment_megabytes;
+    int max_files;
+} recorder_t;
+
+static recorder_t rec = {
+    .max_seconds = 600,
+    .max_megabytes = 50,
+    .segment_megabytes = 10,
+    .max_files = 10
+};
+static guint status_timer_id = 0;
+
+static inline guint load(volatile gint *counter) {
+    return (guint)g_atomic_int_get(counter);
+}
+
+static inline void store(volatile gint *counter, guint value) {
+    g_atomic_int_set(counter, (gint)value);
+}
+
+static void ring_write(guint pos, const void *src, size_t len) {
+    guint offset = pos & rec.mask;
+    size_t first = RECORDER_BUFFER_SIZE - offset;
+    if (first > len) first = len;
+    memcpy(rec.buffer + offset, src, first);
+    if (len > first)
+        memcpy(rec.buffer, (const uint8_t *)src + first, len - first);
+}
+
+static void ring_read(guint pos, void *dst, size_t len) {
+    guint offset = pos & rec.mask;
+    size_t first = RECORDER_BUFFER_SIZE - offset;
+    if (first > len) first = len;
+    memcpy(dst, rec.buffer + offset, first);
+    if (len > first)
+        memcpy((uint8_t *)dst + first, rec.buffer, len - first);
+}
+
+// --- Subscriber thread ---
+void Recorder_Scene(const uint8_t *data, size_t size, gint64 received_us) {
+    if (!g_atomic_int_get(&rec.recording) || !data) return;
+    guint head = load(&rec.head);
+    guint space = RECORDER_BUFFER_SIZE - (head - load(&rec.tail));
+    if (size > RECORDER_BUFFER_SIZE || sizeof(recorder_record_t) + size > space) {
+        g_atomic_int_inc(&rec.dropped);
+        return;
+    }
+    recorder_record_t header = { RECORDER_SCENE, (uint32_t)size, received_us - rec.start_us };
+    ring_write(head, &header, sizeof(header));
+    ring_write(head + sizeof(header), data, size);
+    store(&rec.head, head + sizeof(header) + size);
+    sem_post(&rec.pending);
+}
+
+// --- Writer thread; callers below hold rec.lock ---
+static int compare_names(const void *a, const void *b) {
+    return strcmp(*(char * const *)a, *(char * const *)b);
+}
+
+static bool is_recording_file(const char *name) {
+    size_t len = strlen(name);
+    return strncmp(name, RECORDER_PREFIX, strlen(RECORDER_PREFIX)) == 0 &&
+           len > strlen(RECORDER_SUFFIX) &&
+           strcmp(name + len - strlen(RECORDER_SUFFIX), RECORDER_SUFFIX) == 0 &&
+           !strchr(name, '/');
+}
+
+// Recording files, oldest first (names embed the start time)
+static int list_files(char **names, int max) {
+    char path[ACAP_MAX_PATH_LENGTH];
+    snprintf(path, sizeof(path), "%s%s", ACAP_FILE_AppPath(), RECORDER_DIR);
+    DIR *dir = opendir(path);
+    if (!dir) return 0;
+    int count = 0;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL && count < max) {
+        if (is_recording_file(entry->d_name))
+            names[count++] = strdup(entry->d_name);
+    }
+    closedir(dir);
+    qsort(names, count, sizeof(char *), compare_names);
+    return count;
+}
+
+static void prune_files(int keep) {
+    char *names[RECORDER_MAX_LISTED];
+    int count = list_files(names, RECORDER_MAX_LISTED);
+    for (int i = 0; i < count; ++i) {
+        if (count - i > keep) {
+            char path[128];
+            snprintf(path, sizeof(path), RECORDER_DIR "%s", names[i]);
+            ACAP_FILE_Delete(path);
+            LOG("Recorder: Removed %s\n", names[i]);
+        }
+        free(names[i]);
+    }
+}
+
+static bool write_record(uint32_t type, const void *data, size_t size) {
+    recorder_record_t header = { type, (uint32_t)size, g_get_monotonic_time() - rec.start_us };
+    if (fwrite(&header, sizeof(header), 1, rec.file) != 1) return false;
+    if (size && fwrite(data, size, 1, rec.file) != 1) return false;
+    rec.file_bytes += sizeof(header) + size;
+    rec.total_bytes += sizeof(header) + size;
+    return true;
+}
+
+static void close_file(void) {
+    if (!rec.file) return;
+    fclose(rec.file);
+    rec.file = NULL;
+    LOG("Recorder: Closed %s (%llu bytes)\n", rec.file_name, (unsigned long long)rec.file_bytes);
+}
+
+static void stop_recording(const char *reason) {
+    g_atomic_int_set(&rec.recording, 0);
+    if (rec.state == REC_RECORDING) {
+        rec.state = REC_FLUSHING;
+        rec.stop_reason = reason;
+        LOG("Recorder: Stopped (%s), %llu frames, %llu bytes\n", reason,
+            (unsigned long long)rec.frames, (unsigned long long)rec.total_bytes);
+    }
+}
+
+static bool open_segment(void) {
+    rec.segment++;
+    snprintf(rec.file_name, sizeof(rec.file_name), "%s_%02d" RECORDER_SUFFIX, rec.name, rec.segment);
+    prune_files(rec.max_files > 1 ? rec.max_files - 1 : 0);
+
+    char path[128];
+    snprintf(path, sizeof(path), RECORDER_DIR "%s", rec.file_name);
+    rec.file = ACAP_FILE_Open(path, "wb");
+    rec.file_bytes = 0;
+    if (!rec.file) {
+        LOG_WARN("Recorder: Unable to create %s\n", path);
+        stop_recording("file error");
+        return false;
+    }
+    bool ok = fwrite(RECORDER_MAGIC, RECORDER_MAGIC_SIZE, 1, rec.file) == 1;
+    rec.file_bytes = RECORDER_MAGIC_SIZE;
+    rec.total_bytes += RECORDER_MAGIC_SIZE;
+    ok = ok && write_record(RECORDER_INFO, rec.info, strlen(rec.info));
+    ok = ok && write_record(RECORDER_DETECTOR, rec.detector, rec.detector_size);
+    if (!ok) {
+        LOG_WARN("Recorder: Write to %s failed\n", path);
+        close_file();
+        stop_recording("file error");
+        return false;
+    }
+    LOG("Recorder: Writing %s\n", rec.file_name);
+    return true;
+}
+
+// Write the queued record at tail, rotating or stopping on the limits
+static void write_scene(guint tail, const recorder_record_t *header) {
+    uint64_t segment_bytes = (uint64_t)rec.segment_megabytes << 20;
+    uint64_t total = sizeof(*header) + header->length;
+
+    if (rec.state == REC_RECORDING && !rec.file && !open_segment())
+        return;
+    if (!rec.file) return;  // Stopped on a limit; discard
+    if (segment_bytes && rec.file_bytes + total > segment_bytes && rec.frames) {
+        close_file();
+        if (!open_segment()) return;
+    }
+
+    // Copy out of the ring in at most two pieces
+    guint offset = tail & rec.mask;
+    size_t first = RECORDER_BUFFER_SIZE - offset;
+    if (first > total) first = total;
+    bool ok = fwrite(rec.buffer + offset, first, 1, rec.file) == 1;
+    if (ok && total > first)
+        ok = fwrite(rec.buffer, total - first, 1, rec.file) == 1;
+    if (!ok) {
+        LOG_WARN("Recorder: Write to %s failed\n", rec.file_name);
+        close_file();
+        stop_recording("file error");
+        return;
+    }
+    rec.file_bytes += total;
+    rec.total_bytes += total;
+    rec.frames++;
+
+    if (rec.state == REC_RECORDING && rec.max_bytes && rec.total_bytes >= rec.max_bytes) {
+        stop_recording("size limit");
+        close_file();
+    }
+}
+
+static void write_pending(void) {
+    g_mutex_lock(&rec.lock);
+    guint tail = load(&rec.tail);
+    guint head = load(&rec.head);
+    while (head - tail >= sizeof(recorder_record_t)) {
+        recorder_record_t header;
+        ring_read(tail, &header, sizeof(header));
+        write_scene(tail, &header);
+        tail += sizeof(header) + header.length;
+        store(&rec.tail, tail);
+        head = load(&rec.head);
+    }
+    if (rec.state == REC_RECORDING && rec.max_us &&
+        g_get_monotonic_time() - rec.start_us >= rec.max_us) {
+        stop_recording("duration limit");
+        close_file();
+    }
+    if (rec.state == REC_FLUSHING && head == tail) {
+        close_file();
+        rec.state = REC_IDLE;
+    }
+    g_mutex_unlock(&rec.lock);
+}
+
+static void *writer_thread(void *arg) {
+    while (!g_atomic_int_get(&rec.quit)) {
+        // Wake at least once a second to enforce the duration limit
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += 1;
+        while (sem_timedwait(&rec.pending, &deadline) != 0 && errno == EINTR);
+        write_pending();
+    }
+    write_pending();
+    return NULL;
+}
+
+// --- Control, main thread ---
+static char *build_info(cJSON *description) {
+    time_t now = time(NULL);
+    struct tm local;
+    localtime_r(&now, &local);
+    char started[32];
+    strftime(started, sizeof(started), "%Y-%m-%dT%H:%M:%S%z", &local);
+
+    cJSON *info = description ? description : cJSON_CreateObject();
+    cJSON_AddNumberToObject(info, "version", 1);
+    cJSON_AddStringToObject(info, "serial", ACAP_DEVICE_Prop("serial"));
+    cJSON_AddStringToObject(info, "started", started);
+    cJSON_AddNumberToObject(info, "timestamp", (double)now * 1000.0);
+    char *json = cJSON_PrintUnformatted(info);
+    cJSON_Delete(info);
+    return json;
+}
+
+int Recorder_Start(int max_seconds, int max_megabytes) {
+    if (!rec.writer_running) return 0;
+
+    uint8_t *detector = NULL;
+    size_t detector_size = 0;
+    cJSON *description = VOD_Scene_Description(&detector, &detector_size);
+    if (!description) {
+        LOG_WARN("Recorder: Detector information not available\n");
+        return 0;
+    }
+
+    g_mutex_lock(&rec.lock);
+    if (rec.state != REC_IDLE) {
+        g_mutex_unlock(&rec.lock);
+        cJSON_Delete(description);
+        free(detector);
+        LOG_WARN("Recorder: Recording already active\n");
+        return 0;
+    }
+    free(rec.info);
+    free(rec.detector);
+    rec.info = build_info(description);
+    rec.detector = detector;
+    rec.detector_size = detector_size;
+
+    time_t now = time(NULL);
+    struct tm local;
+    localtime_r(&now, &local);
+    strftime(rec.name, sizeof(rec.name), RECORDER_PREFIX "%Y%m%d_%H%M%S", &local);
+    rec.segment = 0;
+    rec.file_bytes = 0;
+    rec.total_bytes = 0;
+    rec.frames = 0;
+    rec.stop_reason = NULL;
+    g_atomic_int_set(&rec.dropped, 0);
+    if (max_seconds <= 0) max_seconds = rec.max_seconds;
+    if (max_megabytes <= 0) max_megabytes = rec.max_megabytes;
+    rec.max_us = (gint64)max_seconds * G_USEC_PER_SEC;
+    rec.max_bytes = (uint64_t)max_megabytes << 20;
+    rec.start_us = g_get_monotonic_time();
+    rec.state = REC_RECORDING;
+    g_atomic_int_set(&rec.recording, 1);
+    g_mutex_unlock(&rec.lock);
+
+    LOG("Recorder: Started %s (max %d s, %d MB)\n", rec.name, max_seconds, max_megabytes);
+    return 1;
+}
+
+void Recorder_Stop(void) {
+    g_mutex_lock(&rec.lock);
+    stop_recording("stopped");
+    g_mutex_unlock(&rec.lock);
+    sem_post(&rec.pending);
+}
+
+int Recorder_Command(cJSON *command) {
+    cJSON *action = cJSON_GetObjectItem(command, "action");
+    if (!cJSON_IsString(action)) return 0;
+    if (strcmp(action->valuestring, "start") == 0) {
+        cJSON *duration = cJSON_GetObjectItem(command, "duration");
+        cJSON *size = cJSON_GetObjectItem(command, "size");
+        return Recorder_Start(cJSON_IsNumber(duration) ? duration->valueint : 0,
+                              cJSON_IsNumber(size) ? size->valueint : 0);
+    }
+    if (strcmp(action->valuestring, "stop") == 0) {
+        Recorder_Stop();
+        return 1;
+    }
+    LOG_WARN("Recorder: Unknown command %s\n", action->valuestring);
+    return 0;
+}
+
+static cJSON *status_json(void) {
+    cJSON *status = cJSON_CreateObject();
+    g_mutex_lock(&rec.lock);
+    gint64 elapsed = rec.state == REC_RECORDING ? g_get_monotonic_time() - rec.start_us : 0;
+    cJSON_AddBoolToObject(status, "active", rec.state != REC_IDLE);
+    cJSON_AddStringToObject(status, "file", rec.file ? rec.file_name : "");
+    cJSON_AddNumberToObject(status, "frames", (double)rec.frames);
+    cJSON_AddNumberToObject(status, "bytes", (double)rec.total_bytes);
+    cJSON_AddNumberToObject(status, "dropped", load(&rec.dropped));
+    cJSON_AddNumberToObject(status, "seconds", elapsed / G_USEC_PER_SEC);
+    cJSON_AddStringToObject(status, "stopReason", rec.stop_reason ? rec.stop_reason : "");
+    g_mutex_unlock(&rec.lock);
+    return status;
+}
+
+static gboolean recorder_status_timer(gpointer user_data) {
+    cJSON *status = status_json();
+    cJSON *item = status->child;
+    while (item) {
+        if (cJSON_IsBool(item))
+            ACAP_STATUS_SetBool("recorder", item->string, cJSON_IsTrue(item));
+        else if (cJSON_IsNumber(item))
+            ACAP_STATUS_SetNumber("recorder", item->string, item->valuedouble);
+        else if (cJSON_IsString(item))
+            ACAP_STATUS_SetString("recorder", item->string, item->valuestring);
+        item = item->next;
+    }
+    cJSON_Delete(status);
+    return G_SOURCE_CONTINUE;
+}
+
+static void respond_file(ACAP_HTTP_Response response, const char *name) {
+    char path[128];
+    snprintf(path, sizeof(path), RECORDER_DIR "%s", name);
+    FILE *file = ACAP_FILE_Open(path, "rb");
+    if (!file) {
+        ACAP_HTTP_Respond_Error(response, 404, "File not found");
+        return;
+    }
+    struct stat st;
+    if (fstat(fileno(file), &st) != 0) {
+        fclose(file);
+        ACAP_HTTP_Respond_Error(response, 500, "Unable to read file");
+        return;
+    }
+    ACAP_HTTP_Header_FILE(response, name, "application/octet-stream", (unsigned)st.st_size);
+    uint8_t chunk[16384];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), file)) > 0)
+        if (!ACAP_HTTP_Respond_Data(response, n, chunk)) break;
+    fclose(file);
+}
+
+static void
+Recorder_HTTP(const ACAP_HTTP_Response response, const ACAP_HTTP_Request request) {
+    char *action = ACAP_HTTP_Request_Param(request, "action");
+    char *file = ACAP_HTTP_Request_Param(request, "file");
+
+    if (action && strcmp(action, "start") == 0) {
+        char *duration = ACAP_HTTP_Request_Param(request, "duration");
+        char *size = ACAP_HTTP_Request_Param(request, "size");
+        int ok = Recorder_Start(duration ? atoi(duration) : 0, size ? atoi(size) : 0);
+        free(duration);
+        free(size);
+        if (!ok) {
+            ACAP_HTTP_Respond_Error(response, 400, "Recording is active or detector is not available");
+            goto done;
+        }
+    } else if (action && strcmp(action, "stop") == 0) {
+        Recorder_Stop();
+    } else if (action && (strcmp(action, "download") == 0 || strcmp(action, "delete") == 0)) {
+        if (!file || !is_recording_file(file)) {
+            ACAP_HTTP_Respond_Error(response, 400, "Invalid file");
+            goto done;
+        }
+        if (strcmp(action, "download") == 0) {
+            respond_file(response, file);
+            goto done;
+        }
+        g_mutex_lock(&rec.lock);
+        bool busy = rec.file && strcmp(rec.file_name, file) == 0;
+        g_mutex_unlock(&rec.lock);
+        char path[128];
+        snprintf(path, sizeof(path), RECORDER_DIR "%s", file);
+        if (busy || !ACAP_FILE_Delete(path)) {
+            ACAP_HTTP_Respond_Error(response, 500, busy ? "File is being recorded" : "Failed to remove");
+            goto done;
+        }
+    } else if (action && strcmp(action, "status") != 0) {
+        ACAP_HTTP_Respond_Error(response, 400, "Invalid action");
+        goto done;
+    }
+
+    cJSON *status = status_json();
+    cJSON *files = cJSON_AddArrayToObject(status, "files");
+    char *names[RECORDER_MAX_LISTED];
+    int count = list_files(names, RECORDER_MAX_LISTED);
+    for (int i = 0; i < count; ++i) {
+        char path[ACAP_MAX_PATH_LENGTH];
+        struct stat st;
+        snprintf(path, sizeof(path), "%s" RECORDER_DIR "%s", ACAP_FILE_AppPath(), names[i]);
+        cJSON *entry = cJSON_CreateObject();
+        cJSON_AddStringToObject(entry, "name", names[i]);
+        cJSON_AddNumberToObject(entry, "size", stat(path, &st) == 0 ? (double)st.st_size : 0);
+        cJSON_AddItemToArray(files, entry);
+        free(names[i]);
+    }
+    ACAP_HTTP_Respond_JSON(response, status);
+    cJSON_Delete(status);
+
+done:
+    free(action);
+    free(file);
+}
+
+void Recorder_Settings(cJSON *settings) {
+    if (!settings) return;
+    cJSON *item;
+    g_mutex_lock(&rec.lock);
+    if ((item = cJSON_GetObjectItem(settings, "maxDuration")) && item->valueint > 0)
+        rec.max_seconds = item->valueint;
+    if ((item = cJSON_GetObjectItem(settings, "maxSize")) && item->valueint > 0)
+        rec.max_megabytes = item->valueint;
+    if ((item = cJSON_GetObjectItem(settings, "segmentSize")) && item->valueint > 0)
+        rec.segment_megabytes = item->valueint;
+    if ((item = cJSON_GetObjectItem(settings, "maxFiles")) && item->valueint > 0)
+        rec.max_files = item->valueint;
+    g_mutex_unlock(&rec.lock);
+    LOG_TRACE("%s: %d s, %d MB, %d MB segments, %d files\n", __func__,
+              rec.max_seconds, rec.max_megabytes, rec.segment_megabytes, rec.max_files);
+}
+
+void Recorder_Init(cJSON *settings) {
+    Recorder_Settings(settings);
+    ACAP_HTTP_Node("recorder", Recorder_HTTP);
+    if (rec.writer_running) return;
+
+    rec.buffer = malloc(RECORDER_BUFFER_SIZE);
+    if (!rec.buffer) {
+        LOG_WARN("Recorder: Memory allocation failed\n");
+        return;
+    }
+    rec.mask = RECORDER_BUFFER_SIZE - 1;
+    sem_init(&rec.pending, 0, 0);
+    if (pthread_create(&rec.writer, NULL, writer_thread, NULL) != 0) {
+        LOG_WARN("Recorder: Failed to start writer thread\n");
+        sem_destroy(&rec.pending);
+        free(rec.buffer);
+        rec.buffer = NULL;
+        return;
+    }
+    rec.writer_running = true;
+    recorder_status_timer(NULL);
+    status_timer_id = g_timeout_add_seconds(2, recorder_status_timer, NULL);
+}
+
+void Recorder_Cleanup(void) {
+    if (!rec.writer_running) return;
+    if (status_timer_id) {
+        g_source_remove(status_timer_id);
+        status_timer_id = 0;
+    }
+    Recorder_Stop();
+    g_atomic_int_set(&rec.quit, 1);
+    sem_post(&rec.pending);
+    pthread_join(rec.writer, NULL);
+    rec.writer_running = false;
+    close_file();
+    sem_destroy(&rec.pending);
+    free(rec.buffer);
+    free(rec.info);
+    free(rec.detector);
+    rec.buffer = NULL;
+    rec.info = NULL;
+    rec.detector = NULL;
+}
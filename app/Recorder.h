@@ -0,0 +1,71 @@
+/*------------------------------------------------------------------
+ *  Recorder.h
+ *  Scene capture recorder.
+ *
+ *  Appends every raw Scene payload received from the detection service
+ *  to a binary log in localdata/ so field problems can be replayed
+ *  offline. The subscriber thread only copies the payload into a
+ *  preallocated ring; a background thread writes it to disk. If the
+ *  ring is full the payload is counted as dropped, never waited for.
+ *
+ *  File format (little endian):
+ *    "DQSCENE1"                               8 byte magic
+ *    records: uint32 type, uint32 length, int64 time_us, payload[length]
+ *
+ *  time_us is microseconds since the recording started, continuous over
+ *  rotated files. Every file starts with an INFO and a DETECTOR record
+ *  so each file can be replayed on its own.
+ *  Fred Juhlin (2025)
+ *------------------------------------------------------------------*/
+
+#ifndef RECORDER_H
+#define RECORDER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <glib.h>
+#include "cJSON.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RECORDER_MAGIC          "DQSCENE1"
+#define RECORDER_MAGIC_SIZE     8
+
+#define RECORDER_INFO           1   // JSON: serial, channel, started, classes [{id,name}]
+#define RECORDER_DETECTOR       2   // Raw DetectorInformation protobuf
+#define RECORDER_SCENE          3   // Raw Scene protobuf as received
+
+typedef struct {
+    uint32_t type;
+    uint32_t length;
+    int64_t  time_us;
+} recorder_record_t;
+
+/**
+ * Register the "recorder" HTTP node and start the writer thread.
+ * @param settings  "recorder" settings object, may be NULL.
+ */
+void Recorder_Init(cJSON *settings);
+void Recorder_Settings(cJSON *settings);
+void Recorder_Cleanup(void);
+
+/**
+ * Start a recording. Limits <= 0 use the configured defaults.
+ * @return 1 on success, 0 if a recording is active or the header could not be read.
+ */
+int  Recorder_Start(int max_seconds, int max_megabytes);
+void Recorder_Stop(void);
+
+// Apply a command object, e.g. {"action":"start","duration":60}. Main thread only.
+int  Recorder_Command(cJSON *command);
+
+// Subscriber thread: queue a raw payload if recording
+void Recorder_Scene(const uint8_t *data, size_t size, gint64 received_us);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RECORDER_H
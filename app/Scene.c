@@ -0,0 +1,400 @@
+/*------------------------------------------------------------------
+ *  Scene.c
+ *  Fred Juhlin (2025)
+ *------------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "Scene.h"
+#include "video_object_detection.pb-c.h"
+
+// Protobuf wire types
+#define WIRE_VARINT   0
+#define WIRE_FIXED64  1
+#define WIRE_LEN      2
+#define WIRE_FIXED32  5
+
+#define SCENE_MIN_ROWS 32
+
+typedef struct {
+    const uint8_t *p;
+    const uint8_t *end;
+} wire_reader_t;
+
+/*------------------------------------------------------------------
+ * Frame storage
+ *------------------------------------------------------------------*/
+
+void Scene_Frame_Init(scene_frame_t *frame) {
+    if (!frame) return;
+    memset(frame, 0, sizeof(*frame));
+}
+
+void Scene_Frame_Free(scene_frame_t *frame) {
+    if (!frame) return;
+    free(frame->ids);
+    free(frame->left);
+    free(frame->top);
+    free(frame->right);
+    free(frame->bottom);
+    free(frame->classes);
+    free(frame->scores);
+    free(frame->status);
+    free(frame->attr_first);
+    free(frame->attr_count);
+    free(frame->attr_type);
+    free(frame->attr_class);
+    free(frame->attr_score);
+    free(frame->attr_flags);
+    free(frame->event_action);
+    free(frame->event_ids);
+    memset(frame, 0, sizeof(*frame));
+}
+
+void Scene_Frame_Clear(scene_frame_t *frame) {
+    frame->timestamp = 0;
+    frame->time_ms = 0;
+    frame->num_detections = 0;
+    frame->num_attributes = 0;
+    frame->num_events = 0;
+}
+
+static bool grow_array(void **array, uint32_t capacity, size_t elem_size) {
+    void *p = realloc(*array, capacity * elem_size);
+    if (!p) return false;
+    *array = p;
+    return true;
+}
+
+static bool reserve_detection(scene_frame_t *f) {
+    if (f->num_detections < f->cap_detections) return true;
+    uint32_t cap = f->cap_detections ? f->cap_detections * 2 : SCENE_MIN_ROWS;
+    if (!grow_array((void **)&f->ids, cap, sizeof(uint32_t)) ||
+        !grow_array((void **)&f->left, cap, sizeof(float)) ||
+        !grow_array((void **)&f->top, cap, sizeof(float)) ||
+        !grow_array((void **)&f->right, cap, sizeof(float)) ||
+        !grow_array((void **)&f->bottom, cap, sizeof(float)) ||
+        !grow_array((void **)&f->classes, cap, sizeof(uint32_t)) ||
+        !grow_array((void **)&f->scores, cap, sizeof(uint32_t)) ||
+        !grow_array((void **)&f->status, cap, sizeof(uint8_t)) ||
+        !grow_array((void **)&f->attr_first, cap, sizeof(uint32_t)) ||
+        !grow_array((void **)&f->attr_count, cap, sizeof(uint32_t)))
+        return false;
+    f->cap_detections = cap;
+    f->grows++;
+    return true;
+}
+
+static bool reserve_attribute(scene_frame_t *f) {
+    if (f->num_attributes < f->cap_attributes) return true;
+    uint32_t cap = f->cap_attributes ? f->cap_attributes * 2 : SCENE_MIN_ROWS * 4;
+    if (!grow_array((void **)&f->attr_type, cap, sizeof(uint32_t)) ||
+        !grow_array((void **)&f->attr_class, cap, sizeof(uint32_t)) ||
+        !grow_array((void **)&f->attr_score, cap, sizeof(uint32_t)) ||
+        !grow_array((void **)&f->attr_flags, cap, sizeof(uint8_t)))
+        return false;
+    f->cap_attributes = cap;
+    f->grows++;
+    return true;
+}
+
+static bool reserve_event(scene_frame_t *f) {
+    if (f->num_events < f->cap_events) return true;
+    uint32_t cap = f->cap_events ? f->cap_events * 2 : SCENE_MIN_ROWS;
+    if (!grow_array((void **)&f->event_action, cap, sizeof(uint8_t)) ||
+        !grow_array((void **)&f->event_ids, cap, sizeof(int32_t)))
+        return false;
+    f->cap_events = cap;
+    f->grows++;
+    return true;
+}
+
+static bool begin_detection(scene_frame_t *f) {
+    if (!reserve_detection(f)) return false;
+    uint32_t d = f->num_detections;
+    f->ids[d] = 0;
+    f->left[d] = f->top[d] = f->right[d] = f->bottom[d] = 0;
+    f->classes[d] = 0;
+    f->scores[d] = 0;
+    f->status[d] = VOD__DETECTION__DETECTION_STATUS__UNTRACKED;
+    f->attr_first[d] = f->num_attributes;
+    f->attr_count[d] = 0;
+    return true;
+}
+
+static bool push_event(scene_frame_t *f, int32_t id) {
+    if (!reserve_event(f)) return false;
+    f->event_action[f->num_events] = VOD__EVENT_ACTION__EVENT_DELETE;
+    f->event_ids[f->num_events] = id;
+    f->num_events++;
+    return true;
+}
+
+int Scene_Frame_Append_Events(scene_frame_t *dst, const scene_frame_t *src) {
+    for (uint32_t e = 0; e < src->num_events; ++e) {
+        if (!reserve_event(dst)) return -1;
+        dst->event_action[dst->num_events] = src->event_action[e];
+        dst->event_ids[dst->num_events] = src->event_ids[e];
+        dst->num_events++;
+    }
+    return 0;
+}
+
+/*------------------------------------------------------------------
+ * Wire format primitives
+ *------------------------------------------------------------------*/
+
+static inline bool read_varint(wire_reader_t *r, uint64_t *out) {
+    uint64_t v = 0;
+    for (int shift = 0; shift < 64 && r->p < r->end; shift += 7) {
+        uint8_t b = *r->p++;
+        v |= (uint64_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) {
+            *out = v;
+            return true;
+        }
+    }
+    return false;
+}
+
+static inline bool read_fixed32_float(wire_reader_t *r, float *out) {
+    if (r->end - r->p < 4) return false;
+    // Axis targets are little-endian, same as the wire format
+    memcpy(out, r->p, 4);
+    r->p += 4;
+    return true;
+}
+
+static inline bool read_len(wire_reader_t *r, wire_reader_t *sub) {
+    uint64_t len;
+    if (!read_varint(r, &len)) return false;
+    if (len > (uint64_t)(r->end - r->p)) return false;
+    sub->p = r->p;
+    sub->end = r->p + len;
+    r->p += len;
+    return true;
+}
+
+static bool skip_field(wire_reader_t *r, uint32_t wire_type) {
+    uint64_t v;
+    wire_reader_t sub;
+    switch (wire_type) {
+        case WIRE_VARINT:  return read_varint(r, &v);
+        case WIRE_LEN:     return read_len(r, &sub);
+        case WIRE_FIXED64:
+            if (r->end - r->p < 8) return false;
+            r->p += 8;
+            return true;
+        case WIRE_FIXED32:
+            if (r->end - r->p < 4) return false;
+            r->p += 4;
+            return true;
+    }
+    return false;
+}
+
+/*------------------------------------------------------------------
+ * Messages
+ *------------------------------------------------------------------*/
+
+static int decode_attribute(scene_frame_t *f, wire_reader_t *r) {
+    if (!reserve_attribute(f)) return SCENE_DECODE_ERROR;
+    uint32_t a = f->num_attributes;
+    f->attr_type[a] = 0;
+    f->attr_class[a] = 0;
+    f->attr_score[a] = 0;
+    f->attr_flags[a] = 0;
+    while (r->p < r->end) {
+        uint64_t key, v;
+        if (!read_varint(r, &key)) return SCENE_DECODE_ERROR;
+        uint32_t field = (uint32_t)(key >> 3), wire = (uint32_t)(key & 7);
+        if (wire != WIRE_VARINT || field < 1 || field > 3) return SCENE_DECODE_FALLBACK;
+        if (!read_varint(r, &v)) return SCENE_DECODE_ERROR;
+        switch (field) {
+            case 1: f->attr_type[a] = (uint32_t)v; break;
+            case 2: f->attr_class[a] = (uint32_t)v; f->attr_flags[a] |= SCENE_ATTR_HAS_CLASS; break;
+            case 3: f->attr_score[a] = (uint32_t)v; f->attr_flags[a] |= SCENE_ATTR_HAS_SCORE; break;
+        }
+    }
+    f->num_attributes++;
+    return SCENE_DECODE_OK;
+}
+
+static int decode_detection(scene_frame_t *f, wire_reader_t *r) {
+    if (!begin_detection(f)) return SCENE_DECODE_ERROR;
+    uint32_t d = f->num_detections;
+    while (r->p < r->end) {
+        uint64_t key, v;
+        if (!read_varint(r, &key)) return SCENE_DECODE_ERROR;
+        uint32_t field = (uint32_t)(key >> 3), wire = (uint32_t)(key & 7);
+        float fv;
+        switch (field) {
+            case 1: case 2: case 3: case 4:
+                if (wire != WIRE_FIXED32) return SCENE_DECODE_FALLBACK;
+                if (!read_fixed32_float(r, &fv)) return SCENE_DECODE_ERROR;
+                if (field == 1) f->left[d] = fv;
+                else if (field == 2) f->top[d] = fv;
+                else if (field == 3) f->right[d] = fv;
+                else f->bottom[d] = fv;
+                break;
+            case 5: case 6: case 7: case 8:
+                if (wire != WIRE_VARINT) return SCENE_DECODE_FALLBACK;
+                if (!read_varint(r, &v)) return SCENE_DECODE_ERROR;
+                if (field == 5) f->ids[d] = (uint32_t)v;
+                else if (field == 6) f->classes[d] = (uint32_t)v;
+                else if (field == 7) f->scores[d] = (uint32_t)v;
+                else f->status[d] = (uint8_t)v;
+                break;
+            case 9: {
+                wire_reader_t sub;
+                if (wire != WIRE_LEN) return SCENE_DECODE_FALLBACK;
+                if (!read_len(r, &sub)) return SCENE_DECODE_ERROR;
+                int rc = decode_attribute(f, &sub);
+                if (rc != SCENE_DECODE_OK) return rc;
+                f->attr_count[d]++;
+                break;
+            }
+            case 11:
+                // Classifications are not used by DataQ
+                if (!skip_field(r, wire)) return SCENE_DECODE_ERROR;
+                break;
+            default:
+                return SCENE_DECODE_FALLBACK;
+        }
+    }
+    f->num_detections++;
+    return SCENE_DECODE_OK;
+}
+
+static int decode_event(scene_frame_t *f, wire_reader_t *r) {
+    uint32_t first = f->num_events;
+    uint8_t action = VOD__EVENT_ACTION__EVENT_DELETE;
+    int32_t object_id = 0;
+    while (r->p < r->end) {
+        uint64_t key, v;
+        if (!read_varint(r, &key)) return SCENE_DECODE_ERROR;
+        uint32_t field = (uint32_t)(key >> 3), wire = (uint32_t)(key & 7);
+        if (field == 1 && wire == WIRE_VARINT) {
+            if (!read_varint(r, &v)) return SCENE_DECODE_ERROR;
+            action = (uint8_t)v;
+        } else if (field == 2 && wire == WIRE_VARINT) {
+            if (!read_varint(r, &v)) return SCENE_DECODE_ERROR;
+            object_id = (int32_t)v;
+        } else if (field == 3 && wire == WIRE_VARINT) {
+            if (!read_varint(r, &v)) return SCENE_DECODE_ERROR;
+            if (!push_event(f, (int32_t)v)) return SCENE_DECODE_ERROR;
+        } else if (field == 3 && wire == WIRE_LEN) {
+            // Packed object_ids
+            wire_reader_t sub;
+            if (!read_len(r, &sub)) return SCENE_DECODE_ERROR;
+            while (sub.p < sub.end) {
+                if (!read_varint(&sub, &v)) return SCENE_DECODE_ERROR;
+                if (!push_event(f, (int32_t)v)) return SCENE_DECODE_ERROR;
+            }
+        } else {
+            return SCENE_DECODE_FALLBACK;
+        }
+    }
+    // object_id is implicit 0 when absent; only keep it as a row when set
+    // or when the event carries no object_ids
+    if ((object_id != 0 || f->num_events == first) && !push_event(f, object_id))
+        return SCENE_DECODE_ERROR;
+    // The action may follow the ids on the wire
+    for (uint32_t e = first; e < f->num_events; ++e)
+        f->event_action[e] = action;
+    return SCENE_DECODE_OK;
+}
+
+int Scene_Decode(scene_frame_t *frame, const uint8_t *data, size_t size) {
+    if (!frame || (!data && size)) return SCENE_DECODE_ERROR;
+    Scene_Frame_Clear(frame);
+    wire_reader_t r = { data, data + size };
+    while (r.p < r.end) {
+        uint64_t key, v;
+        if (!read_varint(&r, &key)) return SCENE_DECODE_ERROR;
+        uint32_t field = (uint32_t)(key >> 3), wire = (uint32_t)(key & 7);
+        int rc = SCENE_DECODE_OK;
+        wire_reader_t sub;
+        switch (field) {
+            case 1:
+                if (wire != WIRE_VARINT) return SCENE_DECODE_FALLBACK;
+                if (!read_varint(&r, &v)) return SCENE_DECODE_ERROR;
+                frame->timestamp = v;
+                break;
+            case 2:
+                if (wire != WIRE_LEN) return SCENE_DECODE_FALLBACK;
+                if (!read_len(&r, &sub)) return SCENE_DECODE_ERROR;
+                rc = decode_detection(frame, &sub);
+                break;
+            case 3:
+                if (wire != WIRE_LEN) return SCENE_DECODE_FALLBACK;
+                if (!read_len(&r, &sub)) return SCENE_DECODE_ERROR;
+                rc = decode_event(frame, &sub);
+                break;
+            default:
+                return SCENE_DECODE_FALLBACK;
+        }
+        if (rc != SCENE_DECODE_OK) return rc;
+    }
+    return SCENE_DECODE_OK;
+}
+
+int Scene_Decode_Protobuf(scene_frame_t *frame, const uint8_t *data, size_t size) {
+    if (!frame) return SCENE_DECODE_ERROR;
+    Scene_Frame_Clear(frame);
+    VOD__Scene *scene = vod__scene__unpack(NULL, size, data);
+    if (!scene) return SCENE_DECODE_ERROR;
+
+    int rc = SCENE_DECODE_OK;
+    frame->timestamp = scene->timestamp;
+    for (size_t i = 0; i < scene->n_detections && rc == SCENE_DECODE_OK; ++i) {
+        VOD__Detection *det = scene->detections[i];
+        if (!det) continue;
+        if (!begin_detection(frame)) { rc = SCENE_DECODE_ERROR; break; }
+        uint32_t d = frame->num_detections;
+        frame->ids[d] = det->id;
+        frame->left[d] = det->left;
+        frame->top[d] = det->top;
+        frame->right[d] = det->right;
+        frame->bottom[d] = det->bottom;
+        frame->classes[d] = det->det_class;
+        frame->scores[d] = det->score;
+        frame->status[d] = (uint8_t)det->detection_status;
+        for (size_t j = 0; j < det->n_attributes; ++j) {
+            VOD__Attribute *attr = det->attributes[j];
+            if (!attr) continue;
+            if (!reserve_attribute(frame)) { rc = SCENE_DECODE_ERROR; break; }
+            uint32_t a = frame->num_attributes++;
+            frame->attr_type[a] = attr->type;
+            frame->attr_flags[a] = 0;
+            frame->attr_class[a] = 0;
+            frame->attr_score[a] = 0;
+            if (attr->has_class_case == VOD__ATTRIBUTE__HAS_CLASS_ATTR_CLASS) {
+                frame->attr_class[a] = attr->attr_class;
+                frame->attr_flags[a] |= SCENE_ATTR_HAS_CLASS;
+            }
+            if (attr->has_score_case == VOD__ATTRIBUTE__HAS_SCORE_SCORE) {
+                frame->attr_score[a] = attr->score;
+                frame->attr_flags[a] |= SCENE_ATTR_HAS_SCORE;
+            }
+            frame->attr_count[d]++;
+        }
+        frame->num_detections++;
+    }
+    for (size_t e = 0; e < scene->n_events && rc == SCENE_DECODE_OK; ++e) {
+        VOD__Event *ev = scene->events[e];
+        if (!ev) continue;
+        uint32_t first = frame->num_events;
+        for (size_t k = 0; k < ev->n_object_ids && rc == SCENE_DECODE_OK; ++k) {
+            if (!push_event(frame, ev->object_ids[k])) rc = SCENE_DECODE_ERROR;
+        }
+        if (rc == SCENE_DECODE_OK && (ev->object_id != 0 || ev->n_object_ids == 0) &&
+            !push_event(frame, ev->object_id))
+            rc = SCENE_DECODE_ERROR;
+        for (uint32_t k = first; k < frame->num_events; ++k)
+            frame->event_action[k] = (uint8_t)ev->action;
+    }
+    vod__scene__free_unpacked(scene, NULL);
+    return rc;
+}
@@ -0,0 +1,88 @@
+/*------------------------------------------------------------------
+ *  Scene.h
+ *  Allocation-free decoder for VOD.Scene protobuf frames.
+ *
+ *  Decodes the Scene/Detection/Attribute/Event messages of
+ *  video_object_detection.proto straight into a reusable
+ *  structure-of-arrays frame. Arrays only grow when a frame holds more
+ *  rows than any previous frame, so the steady state does no malloc.
+ *  Fred Juhlin (2025)
+ *------------------------------------------------------------------*/
+
+#ifndef SCENE_H
+#define SCENE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SCENE_DECODE_OK         0
+#define SCENE_DECODE_FALLBACK   1   // Unknown field; decode with Scene_Decode_Protobuf
+#define SCENE_DECODE_ERROR     -1   // Malformed data or allocation failure
+
+#define SCENE_ATTR_HAS_CLASS   0x01
+#define SCENE_ATTR_HAS_SCORE   0x02
+
+typedef struct {
+    uint64_t  timestamp;     // Scene.timestamp, capture time in microseconds
+    double    time_ms;       // timestamp mapped to epoch ms by the receiver
+
+    // Detections
+    uint32_t  num_detections;
+    uint32_t  cap_detections;
+    uint32_t *ids;
+    float    *left, *top, *right, *bottom;   // VOD coordinates [-1..1]
+    uint32_t *classes;
+    uint32_t *scores;
+    uint8_t  *status;        // VOD__Detection__DetectionStatus
+    uint32_t *attr_first;    // First row in the attribute arrays
+    uint32_t *attr_count;
+
+    // Attributes of all detections
+    uint32_t  num_attributes;
+    uint32_t  cap_attributes;
+    uint32_t *attr_type;
+    uint32_t *attr_class;
+    uint32_t *attr_score;
+    uint8_t  *attr_flags;    // SCENE_ATTR_HAS_CLASS | SCENE_ATTR_HAS_SCORE
+
+    // Events, one row per referenced object id
+    uint32_t  num_events;
+    uint32_t  cap_events;
+    uint8_t  *event_action;  // VOD__EventAction
+    int32_t  *event_ids;
+
+    uint32_t  grows;         // Array reallocations since init
+} scene_frame_t;
+
+void Scene_Frame_Init(scene_frame_t *frame);
+void Scene_Frame_Free(scene_frame_t *frame);
+void Scene_Frame_Clear(scene_frame_t *frame);
+
+/**
+ * Append the event rows of src to dst. Used to carry delete events of a
+ * frame that is skipped over to the frame processed in its place.
+ * @return 0 on success, -1 on allocation failure.
+ */
+int  Scene_Frame_Append_Events(scene_frame_t *dst, const scene_frame_t *src);
+
+/**
+ * Decode a serialized VOD.Scene into frame.
+ * @return SCENE_DECODE_OK, SCENE_DECODE_FALLBACK or SCENE_DECODE_ERROR.
+ */
+int  Scene_Decode(scene_frame_t *frame, const uint8_t *data, size_t size);
+
+/**
+ * Decode with protobuf-c (vod__scene__unpack) and copy into frame.
+ * Used when Scene_Decode reports fields it does not know.
+ */
+int  Scene_Decode_Protobuf(scene_frame_t *frame, const uint8_t *data, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SCENE_H
@@ -8,6 +8,8 @@
 #include <math.h>
 #include "Stitch.h"
 #include "cJSON.h"
+#include "TimerWheel.h"
+#include "Zone.h"
 
 #define LOG(fmt, args...)      { syslog(LOG_INFO, fmt, ## args); printf(fmt, ## args); }
 #define LOG_WARN(fmt, args...) { syslog(LOG_WARNING, fmt, ## args); printf(fmt, ## args); }
@@ -18,21 +20,50 @@
 // The hold timeout must be much larger to outlive the person's full journey across the scene.
 #define STITCH_HOLD_TIMEOUT_MULTIPLIER 24
 
+// Paths are only stitched with paths from the same channel. Each channel
+// holds its own paths under its own mutex so channels stitch in parallel.
+#define STITCH_MAX_CHANNELS 8
+
+typedef struct _StitchChannel {
+    int channel;
+    GMutex mutex;
+    GList* held_paths;
+} StitchChannel;
+
 typedef struct _StitchHeldPath {
     cJSON* path;
-    GTimer* expiry_timer;
+    timer_id_t expiry;  // Publish when no match has come in time
     bool is_birth_in;   // true = born inside stitch area (re-emergence); false = died inside (pre-occlusion)
+    StitchChannel* owner;
 } StitchHeldPath;
 
 static gint stitch_active = 0;
 static gint stitch_duration = 5;
-static gint stitch_x1 = 250, stitch_x2 = 750, stitch_y1 = 250, stitch_y2 = 750;
+static zone_set_t* stitch_area = NULL;    // Replaced with every channel mutex held
 static double stitch_angle_threshold = 40.0;
 static gint stitch_allow_class_switch = 0;
 static stitch_callback stitch_publish = NULL;
 
-static GMutex stitch_mutex;
-static GList* held_paths = NULL;
+static GMutex stitch_mutex;     // Channel table
+static StitchChannel stitch_channels[STITCH_MAX_CHANNELS];
+static int stitch_num_channels = 0;
+
+static StitchChannel* get_channel(int channel) {
+    g_mutex_lock(&stitch_mutex);
+    StitchChannel* sc = NULL;
+    for(int i = 0; i < stitch_num_channels && !sc; i++)
+        if(stitch_channels[i].channel == channel)
+            sc = &stitch_channels[i];
+    if(!sc && stitch_num_channels < STITCH_MAX_CHANNELS) {
+        sc = &stitch_channels[stitch_num_channels];
+        sc->channel = channel;
+        sc->held_paths = NULL;
+        g_mutex_init(&sc->mutex);
+        stitch_num_channels++;
+    }
+    g_mutex_unlock(&stitch_mutex);
+    return sc;
+}
 
 static double vec_angle(int x1, int y1, int x2, int y2) {
     double dx = x2-x1, dy = y2-y1;
@@ -51,15 +82,51 @@ static double point_distance(int x1, int y1, int x2, int y2) {
     return sqrt(dx*dx + dy*dy);
 }
 
-static gboolean publish_timeout_cb(gpointer data) {
+static void publish_timeout_cb(void* data) {
     StitchHeldPath* hp = (StitchHeldPath*)data;
-    g_mutex_lock(&stitch_mutex);
-    stitch_publish(hp->path);
-    held_paths = g_list_remove(held_paths, hp);
-    g_timer_destroy(hp->expiry_timer);
+    StitchChannel* sc = hp->owner;
+    g_mutex_lock(&sc->mutex);
+    // Gone when a merge or a settings change took it while this was due
+    if (g_list_find(sc->held_paths, hp)) {
+        stitch_publish(hp->path, sc->channel);
+        sc->held_paths = g_list_remove(sc->held_paths, hp);
+    }
     free(hp);
-    g_mutex_unlock(&stitch_mutex);
-    return G_SOURCE_REMOVE;
+    g_mutex_unlock(&sc->mutex);
+}
+
+// Hold a path until a match or its expiry. Called with sc->mutex held. A
+// path that cannot be held is published at once rather than never.
+static StitchHeldPath* hold_path(StitchChannel* sc, cJSON* path, bool is_birth_in) {
+    int hold_timeout = stitch_duration * STITCH_HOLD_TIMEOUT_MULTIPLIER;
+    if(hold_timeout < 60) hold_timeout = 60;
+    StitchHeldPath* hp = malloc(sizeof(StitchHeldPath));
+    if(!hp) {
+        LOG_WARN("STICH: Unable to hold path\n");
+        stitch_publish(path, sc->channel);
+        return NULL;
+    }
+    hp->path        = path;
+    hp->is_birth_in = is_birth_in;
+    hp->owner       = sc;
+    hp->expiry = TimerWheel_Main_Schedule(hold_timeout * 1000.0, publish_timeout_cb, hp);
+    if(!hp->expiry) {
+        LOG_WARN("STICH: Unable to schedule path expiry\n");
+        free(hp);
+        stitch_publish(path, sc->channel);
+        return NULL;
+    }
+    sc->held_paths = g_list_append(sc->held_paths, hp);
+    return hp;
+}
+
+// Free a held path that has been taken off the list. If its expiry is
+// already being delivered, publish_timeout_cb frees it instead.
+static void release_held_path(StitchHeldPath* hp) {
+    if (!hp->expiry || TimerWheel_Main_Cancel(hp->expiry))
+        free(hp);
+    else
+        hp->path = NULL;
 }
 
 static int class_match(cJSON* a, cJSON* b) {
@@ -266,37 +333,41 @@ static cJSON* merge_paths(cJSON* a, cJSON* b) {
  * Best-match scoring: all candidates are evaluated; the one with the lowest
  * combined angular + temporal penalty is chosen.
  */
-void Stitch_Path(cJSON* path) {
+void Stitch_Path(cJSON* path, int channel) {
     if(!path) return;
-    if(!stitch_active) { stitch_publish(path); return; }
+    if(!stitch_active) { stitch_publish(path, channel); return; }
 
     cJSON* arr = cJSON_GetObjectItem(path, "path");
-    if(!arr) { stitch_publish(path); return; }
+    if(!arr) { stitch_publish(path, channel); return; }
     int n = cJSON_GetArraySize(arr);
-    if(n < 2) { stitch_publish(path); return; }
+    if(n < 2) { stitch_publish(path, channel); return; }
 
     cJSON* start = cJSON_GetArrayItem(arr, 0);
     cJSON* end   = cJSON_GetArrayItem(arr, n-1);
-    if(!start || !end) { stitch_publish(path); return; }
+    if(!start || !end) { stitch_publish(path, channel); return; }
 
     cJSON* sx_obj = cJSON_GetObjectItem(start, "x"); cJSON* sy_obj = cJSON_GetObjectItem(start, "y");
     cJSON* ex_obj = cJSON_GetObjectItem(end,   "x"); cJSON* ey_obj = cJSON_GetObjectItem(end,   "y");
-    if(!sx_obj || !sy_obj || !ex_obj || !ey_obj) { stitch_publish(path); return; }
+    if(!sx_obj || !sy_obj || !ex_obj || !ey_obj) { stitch_publish(path, channel); return; }
 
     int sx = sx_obj->valueint, sy = sy_obj->valueint;
     int ex = ex_obj->valueint, ey = ey_obj->valueint;
 
-    bool birth_in = (sx >= stitch_x1 && sx <= stitch_x2 && sy >= stitch_y1 && sy <= stitch_y2);
-    bool death_in = (ex >= stitch_x1 && ex <= stitch_x2 && ey >= stitch_y1 && ey <= stitch_y2);
+    StitchChannel* sc = get_channel(channel);
+    if(!sc) { stitch_publish(path, channel); return; }
+
+    /* The area is only replaced with every channel mutex held */
+    g_mutex_lock(&sc->mutex);
+    bool birth_in = Zone_Contains(stitch_area, sx, sy);
+    bool death_in = Zone_Contains(stitch_area, ex, ey);
 
     /* Path touches neither side of stitch area → pass through unchanged */
     if(!birth_in && !death_in) {
-        stitch_publish(path);
+        g_mutex_unlock(&sc->mutex);
+        stitch_publish(path, channel);
         return;
     }
 
-    g_mutex_lock(&stitch_mutex);
-
     /* ------------------------------------------------------------------
      * Find the BEST candidate from held_paths.
      *
@@ -312,7 +383,7 @@ void Stitch_Path(cJSON* path) {
     StitchHeldPath* best_match = NULL;
     double           best_score = 1e18;
 
-    for(GList* node = held_paths; node != NULL; node = node->next) {
+    for(GList* node = sc->held_paths; node != NULL; node = node->next) {
         StitchHeldPath* hp = node->data;
         if(!hp || !hp->path) { LOG_WARN("STICH: NULL entry in held_paths\n"); continue; }
         cJSON* candidate = hp->path;
@@ -392,19 +463,17 @@ void Stitch_Path(cJSON* path) {
         cJSON* merged = merge_paths(old_path, new_path);
         if(!merged) {
             LOG_WARN("STICH: merge_paths failed\n");
-            g_mutex_unlock(&stitch_mutex);
-            stitch_publish(path);
+            g_mutex_unlock(&sc->mutex);
+            stitch_publish(path, channel);
             return;
         }
         if(!cJSON_GetObjectItem(merged, "stitched"))
             cJSON_AddTrueToObject(merged, "stitched");
 
         /* Remove held entry and free resources */
-        g_source_remove_by_user_data(best_match);
-        held_paths = g_list_remove(held_paths, best_match);
-        g_timer_destroy(best_match->expiry_timer);
+        sc->held_paths = g_list_remove(sc->held_paths, best_match);
         cJSON_Delete(best_match->path);
-        free(best_match);
+        release_held_path(best_match);
         cJSON_Delete(path); /* original incoming path consumed by merge */
 
         /* Check whether the merged path's END is still inside the stitch area */
@@ -412,7 +481,7 @@ void Stitch_Path(cJSON* path) {
         if(!merged_arr || cJSON_GetArraySize(merged_arr) < 1) {
             LOG_WARN("STICH: Invalid merged path array\n");
             cJSON_Delete(merged);
-            g_mutex_unlock(&stitch_mutex);
+            g_mutex_unlock(&sc->mutex);
             return;
         }
         int m_n = cJSON_GetArraySize(merged_arr);
@@ -420,7 +489,7 @@ void Stitch_Path(cJSON* path) {
         if(!merged_end) {
             LOG_WARN("STICH: Invalid merged path end\n");
             cJSON_Delete(merged);
-            g_mutex_unlock(&stitch_mutex);
+            g_mutex_unlock(&sc->mutex);
             return;
         }
         cJSON* mex_obj = cJSON_GetObjectItem(merged_end, "x");
@@ -428,26 +497,18 @@ void Stitch_Path(cJSON* path) {
         if(!mex_obj || !mey_obj) {
             LOG_WARN("STICH: Invalid merged path end coords\n");
             cJSON_Delete(merged);
-            g_mutex_unlock(&stitch_mutex);
+            g_mutex_unlock(&sc->mutex);
             return;
         }
         int mex = mex_obj->valueint, mey = mey_obj->valueint;
-        bool merged_death_in = (mex >= stitch_x1 && mex <= stitch_x2 &&
-                                 mey >= stitch_y1 && mey <= stitch_y2);
+        bool merged_death_in = Zone_Contains(stitch_area, mex, mey);
         if(merged_death_in) {
             /* Still ends inside → hold as a (death_in) segment for further stitching */
-            int hold_timeout = stitch_duration * STITCH_HOLD_TIMEOUT_MULTIPLIER;
-            if(hold_timeout < 60) hold_timeout = 60;
-            StitchHeldPath* hp_new = malloc(sizeof(StitchHeldPath));
-            hp_new->path        = merged;
-            hp_new->expiry_timer = g_timer_new();
-            hp_new->is_birth_in = false;
-            held_paths = g_list_append(held_paths, hp_new);
-            g_timeout_add_seconds(hold_timeout, publish_timeout_cb, hp_new);
+            hold_path(sc, merged, false);
         } else {
-            stitch_publish(merged);
+            stitch_publish(merged, channel);
         }
-        g_mutex_unlock(&stitch_mutex);
+        g_mutex_unlock(&sc->mutex);
         return;
     }
 
@@ -461,60 +522,61 @@ void Stitch_Path(cJSON* path) {
      * stitch area are held, with a long hold timeout so they survive the
      * full scene crossing.
      * ------------------------------------------------------------------ */
-    int hold_timeout = stitch_duration * STITCH_HOLD_TIMEOUT_MULTIPLIER;
-    if(hold_timeout < 60) hold_timeout = 60;
-
-    StitchHeldPath* hp = malloc(sizeof(StitchHeldPath));
-    hp->path         = path;
-    hp->expiry_timer = g_timer_new();
-    hp->is_birth_in  = birth_in && !death_in; /* true only when purely birth_in */
-    held_paths = g_list_append(held_paths, hp);
-    g_timeout_add_seconds(hold_timeout, publish_timeout_cb, hp);
-    g_mutex_unlock(&stitch_mutex);
+    hold_path(sc, path, birth_in && !death_in); /* birth_in only when purely birth_in */
+    g_mutex_unlock(&sc->mutex);
 }
 
 int  Stitch_Settings(cJSON* settings) {
     if(!settings) return 0;
 
+    // The stitch area is the settings object itself: x1..y2 or a polygon,
+    // the center of the view for corners it does not set
+    zone_set_t* area = Zone_Compile(settings, true, (zone_rect_t){ 250, 250, 750, 750 });
+
+    // Hold every channel so no path is stitched with mixed settings
     g_mutex_lock(&stitch_mutex);
+    for(int i = 0; i < stitch_num_channels; i++)
+        g_mutex_lock(&stitch_channels[i].mutex);
 
     // Clear all held paths when settings change to avoid inconsistent state
-    GList* node = held_paths;
-    while (node) {
-        StitchHeldPath* hp = node->data;
-        GList* next = node->next;
-
-        // Publish the held path immediately
-        if (hp->path && stitch_publish) {
-            stitch_publish(hp->path);
-        }
+    for(int i = 0; i < stitch_num_channels; i++) {
+        StitchChannel* sc = &stitch_channels[i];
+        GList* node = sc->held_paths;
+        while (node) {
+            StitchHeldPath* hp = node->data;
+            GList* next = node->next;
+
+            // Publish the held path immediately
+            if (hp->path && stitch_publish) {
+                stitch_publish(hp->path, sc->channel);
+            }
 
-        // Clean up
-        g_source_remove_by_user_data(hp);
-        g_timer_destroy(hp->expiry_timer);
-        free(hp);
+            // Clean up
+            release_held_path(hp);
 
-        node = next;
+            node = next;
+        }
+        g_list_free(sc->held_paths);
+        sc->held_paths = NULL;
     }
-    g_list_free(held_paths);
-    held_paths = NULL;
 
     // Update settings
     stitch_active = cJSON_GetObjectItem(settings,"active")?cJSON_GetObjectItem(settings,"active")->type==cJSON_True?1:0:0;
     stitch_duration = cJSON_GetObjectItem(settings,"duration")?cJSON_GetObjectItem(settings,"duration")->valueint:5;
-    stitch_x1 = cJSON_GetObjectItem(settings,"x1")?cJSON_GetObjectItem(settings,"x1")->valueint:250;
-    stitch_x2 = cJSON_GetObjectItem(settings,"x2")?cJSON_GetObjectItem(settings,"x2")->valueint:750;
-    stitch_y1 = cJSON_GetObjectItem(settings,"y1")?cJSON_GetObjectItem(settings,"y1")->valueint:250;
-    stitch_y2 = cJSON_GetObjectItem(settings,"y2")?cJSON_GetObjectItem(settings,"y2")->valueint:750;
+    Zone_Unref(stitch_area);
+    stitch_area = area;
     stitch_angle_threshold = cJSON_GetObjectItem(settings,"angle_threshold")?
         cJSON_GetObjectItem(settings,"angle_threshold")->valuedouble:40.0;
     stitch_allow_class_switch = cJSON_GetObjectItem(settings,"allow_class_switch")?
         cJSON_GetObjectItem(settings,"allow_class_switch")->type==cJSON_True?1:0:0;
 
+    for(int i = stitch_num_channels - 1; i >= 0; i--)
+        g_mutex_unlock(&stitch_channels[i].mutex);
     g_mutex_unlock(&stitch_mutex);
 
-    LOG("Stitch settings updated: active=%d, area=[%d,%d,%d,%d], duration=%d, angle=%0.1f, allow_class_switch=%d\n",
-        stitch_active, stitch_x1, stitch_y1, stitch_x2, stitch_y2, stitch_duration, stitch_angle_threshold, stitch_allow_class_switch);
+    LOG("Stitch settings updated: active=%d, area=%s, duration=%d, angle=%0.1f, allow_class_switch=%d\n",
+        stitch_active, cJSON_GetObjectItem(settings,"polygon") ? "polygon" : "rectangle",
+        stitch_duration, stitch_angle_threshold, stitch_allow_class_switch);
 
     return 1;
 }
@@ -523,6 +585,6 @@ int  Stitch_Init(stitch_callback cb) {
     if(!cb) return 0;
     stitch_publish = cb;
     g_mutex_init(&stitch_mutex);
-    held_paths = NULL;
+    stitch_num_channels = 0;
     return 1;
 }
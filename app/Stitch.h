@@ -5,11 +5,12 @@
 #include <stddef.h>
 #include "cJSON.h"
 
-typedef void (*stitch_callback)(cJSON*);
+typedef void (*stitch_callback)(cJSON* path, int channel);
 
 int  Stitch_Init(stitch_callback cb);
 int  Stitch_Settings(cJSON* settings);
-void Stitch_Path(cJSON* path);
+// Paths are only stitched with earlier paths of the same channel
+void Stitch_Path(cJSON* path, int channel);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,321 @@
+/*------------------------------------------------------------------
+ *  TimerWheel.c
+ *  Fred Juhlin (2025)
+ *------------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <glib.h>
+#include "TimerWheel.h"
+
+#define TIMERWHEEL_BITS 6
+#define TIMERWHEEL_MASK (TIMERWHEEL_SLOTS - 1)
+#define TIMERWHEEL_SPAN (1ULL << (TIMERWHEEL_BITS * TIMERWHEEL_LEVELS))
+#define TIMERWHEEL_MIN_NODES 64
+#define TIMERWHEEL_DUE (TIMERWHEEL_LEVELS * TIMERWHEEL_SLOTS)   // Head of timers already due
+
+// First tick at or after t, so a timer never fires early
+static uint64_t deadline_tick(const timer_wheel_t *w, double t) {
+    return t > 0 ? (uint64_t)ceil(t / w->tick) : 0;
+}
+
+static uint64_t current_tick(const timer_wheel_t *w, double t) {
+    return t > 0 ? (uint64_t)floor(t / w->tick) : 0;
+}
+
+static void link_node(timer_wheel_t *w, int32_t index) {
+    timer_wheel_node_t *node = &w->nodes[index];
+    node->prev = -1;
+    if (node->expires < w->base) {
+        // The base has passed it; Pop returns it first
+        node->slot = TIMERWHEEL_DUE;
+        node->next = w->heads[TIMERWHEEL_DUE];
+        if (node->next >= 0)
+            w->nodes[node->next].prev = index;
+        w->heads[TIMERWHEEL_DUE] = index;
+        return;
+    }
+    uint64_t expires = node->expires;
+    uint64_t delta = expires - w->base;
+    // Beyond the top level: park at its far end, the cascade re-places it
+    if (delta >= TIMERWHEEL_SPAN)
+        expires = w->base + TIMERWHEEL_SPAN - 1, delta = TIMERWHEEL_SPAN - 1;
+    int level = 0;
+    while (level < TIMERWHEEL_LEVELS - 1 && delta >= 1ULL << (TIMERWHEEL_BITS * (level + 1)))
+        level++;
+    int index_in_level = (int)((expires >> (TIMERWHEEL_BITS * level)) & TIMERWHEEL_MASK);
+    int32_t slot = level * TIMERWHEEL_SLOTS + index_in_level;
+    node->slot = slot;
+    node->next = w->heads[slot];
+    if (node->next >= 0)
+        w->nodes[node->next].prev = index;
+    w->heads[slot] = index;
+    w->occupied[level] |= 1ULL << index_in_level;
+}
+
+static void unlink_node(timer_wheel_t *w, int32_t index) {
+    timer_wheel_node_t *node = &w->nodes[index];
+    int32_t slot = node->slot;
+    if (node->prev >= 0)
+        w->nodes[node->prev].next = node->next;
+    else
+        w->heads[slot] = node->next;
+    if (node->next >= 0)
+        w->nodes[node->next].prev = node->prev;
+    if (w->heads[slot] < 0 && slot != TIMERWHEEL_DUE)
+        w->occupied[slot / TIMERWHEEL_SLOTS] &= ~(1ULL << (slot % TIMERWHEEL_SLOTS));
+    node->slot = -1;
+}
+
+static void release_node(timer_wheel_t *w, int32_t index) {
+    timer_wheel_node_t *node = &w->nodes[index];
+    node->generation++;
+    node->callback = NULL;
+    node->data = NULL;
+    node->next = w->free;
+    w->free = index;
+    w->count--;
+}
+
+static int32_t find_node(const timer_wheel_t *w, timer_id_t id) {
+    uint32_t index = (uint32_t)(id & 0xFFFFFFFFu);
+    if (!index || index > w->capacity)
+        return -1;
+    const timer_wheel_node_t *node = &w->nodes[index - 1];
+    if (node->generation != (uint32_t)(id >> 32) || node->slot < 0)
+        return -1;
+    return (int32_t)(index - 1);
+}
+
+// Re-place the timers of the slots that the base has just reached. Runs
+// when the base crosses a multiple of TIMERWHEEL_SLOTS; a level is only
+// cascaded when the level below it has wrapped as well.
+static void cascade(timer_wheel_t *w) {
+    for (int level = 1; level < TIMERWHEEL_LEVELS; ++level) {
+        int index_in_level = (int)((w->base >> (TIMERWHEEL_BITS * level)) & TIMERWHEEL_MASK);
+        int32_t slot = level * TIMERWHEEL_SLOTS + index_in_level;
+        int32_t index = w->heads[slot];
+        w->heads[slot] = -1;
+        w->occupied[level] &= ~(1ULL << index_in_level);
+        while (index >= 0) {
+            int32_t next = w->nodes[index].next;
+            link_node(w, index);
+            index = next;
+        }
+        if (index_in_level)
+            break;
+    }
+}
+
+int TimerWheel_Init(timer_wheel_t *w, double now, double tick) {
+    memset(w, 0, sizeof(*w));
+    w->tick = tick > 0 ? tick : 1;
+    w->base = current_tick(w, now);
+    for (int i = 0; i <= TIMERWHEEL_DUE; ++i)
+        w->heads[i] = -1;
+    w->free = -1;
+    return 1;
+}
+
+void TimerWheel_Free(timer_wheel_t *w) {
+    free(w->nodes);
+    memset(w, 0, sizeof(*w));
+}
+
+void TimerWheel_Clear(timer_wheel_t *w, double now) {
+    for (int i = 0; i <= TIMERWHEEL_DUE; ++i)
+        w->heads[i] = -1;
+    memset(w->occupied, 0, sizeof(w->occupied));
+    w->free = -1;
+    for (int32_t i = (int32_t)w->capacity - 1; i >= 0; --i) {
+        timer_wheel_node_t *node = &w->nodes[i];
+        if (node->slot >= 0)
+            node->generation++;
+        node->slot = -1;
+        node->callback = NULL;
+        node->data = NULL;
+        node->next = w->free;
+        w->free = i;
+    }
+    w->count = 0;
+    w->base = current_tick(w, now);
+}
+
+timer_id_t TimerWheel_Schedule(timer_wheel_t *w, double deadline, TimerWheel_Callback callback, void *data) {
+    if (w->free < 0) {
+        uint32_t capacity = w->capacity ? w->capacity * 2 : TIMERWHEEL_MIN_NODES;
+        timer_wheel_node_t *nodes = realloc(w->nodes, capacity * sizeof(timer_wheel_node_t));
+        if (!nodes)
+            return 0;
+        memset(nodes + w->capacity, 0, (capacity - w->capacity) * sizeof(timer_wheel_node_t));
+        for (int32_t i = (int32_t)capacity - 1; i >= (int32_t)w->capacity; --i) {
+            nodes[i].slot = -1;
+            nodes[i].next = w->free;
+            w->free = i;
+        }
+        w->nodes = nodes;
+        w->capacity = capacity;
+    }
+    int32_t index = w->free;
+    timer_wheel_node_t *node = &w->nodes[index];
+    w->free = node->next;
+    node->expires = deadline_tick(w, deadline);
+    node->callback = callback;
+    node->data = data;
+    link_node(w, index);
+    w->count++;
+    return ((timer_id_t)node->generation << 32) | (uint32_t)(index + 1);
+}
+
+bool TimerWheel_Reschedule(timer_wheel_t *w, timer_id_t id, double deadline) {
+    int32_t index = find_node(w, id);
+    if (index < 0)
+        return false;
+    unlink_node(w, index);
+    w->nodes[index].expires = deadline_tick(w, deadline);
+    link_node(w, index);
+    return true;
+}
+
+bool TimerWheel_Cancel(timer_wheel_t *w, timer_id_t id) {
+    int32_t index = find_node(w, id);
+    if (index < 0)
+        return false;
+    unlink_node(w, index);
+    release_node(w, index);
+    return true;
+}
+
+bool TimerWheel_Pop(timer_wheel_t *w, double now, TimerWheel_Callback *callback, void **data) {
+    uint64_t now_tick = current_tick(w, now);
+    if (!w->count) {
+        // Nothing pending: follow the clock, in either direction
+        w->base = now_tick;
+        return false;
+    }
+    int32_t due = w->heads[TIMERWHEEL_DUE];
+    if (due >= 0) {
+        unlink_node(w, due);
+        *callback = w->nodes[due].callback;
+        *data = w->nodes[due].data;
+        release_node(w, due);
+        return true;
+    }
+    while (w->base <= now_tick) {
+        int index_in_level = (int)(w->base & TIMERWHEEL_MASK);
+        int32_t index = w->heads[index_in_level];
+        if (index >= 0) {
+            unlink_node(w, index);
+            *callback = w->nodes[index].callback;
+            *data = w->nodes[index].data;
+            release_node(w, index);
+            return true;
+        }
+        // Skip empty slots, but stop at the next cascade
+        uint64_t pending = w->occupied[0] >> index_in_level;
+        uint64_t next = pending ? w->base + (uint64_t)__builtin_ctzll(pending)
+                                : (w->base | TIMERWHEEL_MASK) + 1;
+        w->base = next <= now_tick ? next : now_tick + 1;
+        if ((w->base & TIMERWHEEL_MASK) == 0)
+            cascade(w);
+    }
+    return false;
+}
+
+double TimerWheel_Next(const timer_wheel_t *w) {
+    if (!w->count)
+        return INFINITY;
+    if (w->heads[TIMERWHEEL_DUE] >= 0)
+        return 0;
+    uint64_t next = UINT64_MAX;
+    for (int level = 0; level < TIMERWHEEL_LEVELS; ++level) {
+        uint64_t bits = w->occupied[level];
+        if (!bits)
+            continue;
+        int shift = TIMERWHEEL_BITS * level;
+        uint64_t position = w->base >> shift;
+        // Level 0 slots are due at their own tick; a higher level slot is
+        // cascaded when the base reaches it, the current one a turn later
+        int start = (int)(position & TIMERWHEEL_MASK) + (level ? 1 : 0);
+        int rotate = start & TIMERWHEEL_MASK;
+        uint64_t ahead = rotate ? (bits >> rotate) | (bits << (64 - rotate)) : bits;
+        uint64_t tick = (position + (uint64_t)(level ? 1 : 0) + (uint64_t)__builtin_ctzll(ahead)) << shift;
+        if (tick < next)
+            next = tick;
+    }
+    return next * w->tick;
+}
+
+// Shared wheel on the main loop. One GLib timeout is armed for the
+// earliest slot; scheduling from another thread re-arms it when needed.
+#define MAIN_TICK_MS 10
+
+static GMutex main_mutex;
+static timer_wheel_t main_wheel;
+static bool main_ready = false;
+static guint main_source = 0;
+static guint main_generation = 0;   // Identifies the armed timeout
+static double main_armed = INFINITY;
+
+static double main_now(void) {
+    return g_get_monotonic_time() / 1000.0;
+}
+
+static gboolean main_dispatch(gpointer user_data);
+
+// Called with main_mutex held
+static void main_arm(void) {
+    double next = TimerWheel_Next(&main_wheel);
+    if (next >= main_armed)
+        return;
+    if (main_source)
+        g_source_remove(main_source);
+    double delay = next - main_now();
+    main_armed = next;
+    main_generation++;
+    main_source = g_timeout_add(delay > 0 ? (guint)ceil(delay) : 0, main_dispatch, GUINT_TO_POINTER(main_generation));
+}
+
+static gboolean main_dispatch(gpointer user_data) {
+    g_mutex_lock(&main_mutex);
+    if (GPOINTER_TO_UINT(user_data) != main_generation) {
+        // Replaced by an earlier timeout while waiting for the mutex
+        g_mutex_unlock(&main_mutex);
+        return G_SOURCE_REMOVE;
+    }
+    main_source = 0;
+    main_armed = INFINITY;
+    TimerWheel_Callback callback;
+    void *data;
+    while (TimerWheel_Pop(&main_wheel, main_now(), &callback, &data)) {
+        g_mutex_unlock(&main_mutex);
+        if (callback)
+            callback(data);
+        g_mutex_lock(&main_mutex);
+    }
+    main_arm();
+    g_mutex_unlock(&main_mutex);
+    return G_SOURCE_REMOVE;
+}
+
+timer_id_t TimerWheel_Main_Schedule(double delay, TimerWheel_Callback callback, void *data) {
+    g_mutex_lock(&main_mutex);
+    double now = main_now();
+    if (!main_ready)
+        main_ready = TimerWheel_Init(&main_wheel, now, MAIN_TICK_MS);
+    timer_id_t id = TimerWheel_Schedule(&main_wheel, now + (delay > 0 ? delay : 0), callback, data);
+    if (id)
+        main_arm();
+    g_mutex_unlock(&main_mutex);
+    return id;
+}
+
+bool TimerWheel_Main_Cancel(timer_id_t id) {
+    if (!id)
+        return false;
+    g_mutex_lock(&main_mutex);
+    bool cancelled = main_ready && TimerWheel_Cancel(&main_wheel, id);
+    g_mutex_unlock(&main_mutex);
+    return cancelled;
+}
@@ -0,0 +1,83 @@
+/*------------------------------------------------------------------
+ *  TimerWheel.h
+ *  Hierarchical timer wheel for deadlines in milliseconds.
+ *
+ *  Four levels of 64 slots; level n holds timers due within 64^(n+1)
+ *  ticks and is cascaded into the level below as time reaches them.
+ *  Scheduling, rescheduling and cancelling are O(1) and advancing only
+ *  touches timers that are due (plus one cascade per 64 ticks), so a
+ *  tick never scans every pending deadline. Timers live in a pool
+ *  owned by the wheel and are named by a timer_id_t, which goes stale
+ *  once the timer has fired or been cancelled.
+ *
+ *  A wheel is not thread safe; the owner drives it on its own clock
+ *  (e.g. frame time under a channel mutex). TimerWheel_Main_* is the
+ *  shared wheel on the main loop and may be used from any thread.
+ *
+ *  Fred Juhlin (2025)
+ *------------------------------------------------------------------*/
+
+#ifndef TIMERWHEEL_H
+#define TIMERWHEEL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TIMERWHEEL_LEVELS 4
+#define TIMERWHEEL_SLOTS  64
+
+typedef uint64_t timer_id_t;    // 0 = no timer
+
+typedef void (*TimerWheel_Callback)(void *data);
+
+typedef struct {
+    uint64_t expires;           // Tick
+    int32_t next, prev;         // Slot list, or free list in next
+    int32_t slot;               // Index into heads, -1 when not pending
+    uint32_t generation;
+    TimerWheel_Callback callback;
+    void *data;
+} timer_wheel_node_t;
+
+typedef struct {
+    double tick;                // ms per tick
+    uint64_t base;              // Next tick to process
+    int32_t heads[TIMERWHEEL_LEVELS * TIMERWHEEL_SLOTS + 1];  // Last: already due
+    uint64_t occupied[TIMERWHEEL_LEVELS];   // Non-empty slots per level
+    timer_wheel_node_t *nodes;
+    uint32_t capacity;
+    int32_t free;               // First free node, -1 when none
+    uint32_t count;             // Pending timers
+} timer_wheel_t;
+
+int        TimerWheel_Init(timer_wheel_t *w, double now, double tick);
+void       TimerWheel_Free(timer_wheel_t *w);
+// Drop every pending timer; the wheel continues from now
+void       TimerWheel_Clear(timer_wheel_t *w, double now);
+
+timer_id_t TimerWheel_Schedule(timer_wheel_t *w, double deadline, TimerWheel_Callback callback, void *data);
+// Move a pending timer; false if it already fired or was cancelled
+bool       TimerWheel_Reschedule(timer_wheel_t *w, timer_id_t id, double deadline);
+bool       TimerWheel_Cancel(timer_wheel_t *w, timer_id_t id);
+// Remove one timer that is due at now and return its callback and data.
+// Call until it returns false; callbacks may schedule new timers.
+bool       TimerWheel_Pop(timer_wheel_t *w, double now, TimerWheel_Callback *callback, void **data);
+// Time the wheel next needs to be advanced, or INFINITY when empty. May
+// be earlier than the first deadline when a level has to be cascaded.
+double     TimerWheel_Next(const timer_wheel_t *w);
+
+// Shared wheel on the main loop, on monotonic time. Callbacks run on the
+// main loop; delay is in ms from now.
+timer_id_t TimerWheel_Main_Schedule(double delay, TimerWheel_Callback callback, void *data);
+bool       TimerWheel_Main_Cancel(timer_id_t id);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TIMERWHEEL_H
@@ -9,7 +9,15 @@
 #include <glib.h>
 #include <pthread.h>
 #include <syslog.h>
+#include <math.h>
+#include <sys/sysinfo.h>
 #include "cJSON.h"
+#include "IdMap.h"
+#include "Scene.h"
+#include "Dictionary.h"
+#include "FrameQueue.h"
+#include "Recorder.h"
+#include "ACAP.h"
 
 
 #define LOG(fmt, args...) { syslog(LOG_INFO, fmt, ## args); printf(fmt, ## args); }
@@ -20,20 +28,17 @@
 int vod_predictions = 0;
 
 
-// Watchdog variables
-static double last_detection_time = 0;
+// Watchdog configuration
 static guint watchdog_timer_id = 0;
 static const double DETECTION_TIMEOUT_SECONDS = 300.0;
-static int consecutive_timeouts = 0;
 static const int MAX_CONSECUTIVE_TIMEOUTS = 2;
-static bool recovery_in_progress = false;
 
 
 typedef struct {
     uint32_t type_id;
-    char type_name[64];
+    dict_code_t type_code;
     uint32_t class_id;
-    char class_name[64];
+    dict_code_t class_code;
     uint32_t score;
 } vod_tracked_attribute_t;
 
@@ -41,36 +46,114 @@ typedef struct {
 typedef struct {
     float confidence;
     int type;
-    char class_name[64];
+    dict_code_t class_code;
     int x, y, w, h;
     bool active;
     vod_tracked_attribute_t *attributes;
     size_t num_attributes;
-    int missing_frames;
-    bool detected_this_frame;
+    uint32_t seen_frame;    // Frame sequence when last detected
+    double seen_ms;         // Frame time when last detected
 } tracked_object_t;
 
 
-typedef struct object_map_entry {
+typedef struct {
     uint32_t id;
     tracked_object_t obj;
-    struct object_map_entry *next;
 } object_map_entry_t;
 
 
+// Tracked objects live in a dense array; the id map points into it.
 typedef struct {
-    vod_callback_t cb;
-    void *user_data;
-    VOD__DetectorInformation *det_info;
-    video_object_detection_subscriber_class_t **det_classes;
-    int num_classes;
-    object_map_entry_t *object_map;
-} vod_internal_ctx_t;
+    object_map_entry_t *entries;
+    uint32_t count;
+    uint32_t capacity;
+    idmap_t index;
+} object_store_t;
 
 
-static vod_internal_ctx_t g_ctx = {0};
-static video_object_detection_subscriber_t *subscriber = NULL;
-static pthread_mutex_t vod_mutex = PTHREAD_MUTEX_INITIALIZER;
+// Frame handed to the callback. Arrays are kept between frames and only
+// grow, so steady state does no allocation. Only the processing thread
+// touches it, and the callback returns before the next frame is filled.
+typedef struct {
+    vod_object_t *objects;
+    size_t object_capacity;
+    vod_attribute_t *attributes;
+    size_t attribute_capacity;
+    vod_frame_t view;
+} frame_buffer_t;
+
+
+// One pipeline shard per subscribed channel: its own subscriber, object
+// store, frame queue and processing thread. Shards share nothing but the
+// dictionary, so channels are processed in parallel.
+typedef struct {
+    int channel;
+    char status_group[32];          // "pipeline" for the first channel, "pipeline_<channel>" otherwise
+    video_object_detection_subscriber_t *subscriber;
+    pthread_mutex_t lock;           // Object store; held while a frame is processed
+    vod_callback_t cb;
+    void *user_data;
+    object_store_t objects;
+    uint32_t frame;
+    frame_buffer_t frame_buffer;
+    // Subscriber thread -> processing thread
+    frame_queue_t queue;
+    pthread_t worker;
+    bool worker_running;
+    uint64_t decoded_frames;
+    uint64_t decode_fallbacks;
+    uint64_t decode_errors;
+    gint64 decode_time_us;          // Accumulated decode time
+    // Frame time base, see map_frame_time
+    double frame_time_offset;
+    uint64_t frame_time_last;
+    volatile gint frame_time_resyncs;
+    double frame_time_prev;             // Frame time of the previous decoded frame
+    volatile gint frame_interval_us;    // Smoothed input frame interval, frame time
+    // Pipeline clock, see VOD_Time. Written by the processing thread.
+    pthread_mutex_t clock_mutex;
+    double clock_frame_ms;
+    gint64 clock_frame_mono;
+    // Capture-to-publish latency of the last frame and the maximum since
+    // the last status update, microseconds
+    volatile gint latency_us;
+    volatile gint max_latency_us;
+    // Load-aware decimation, see update_stride
+    volatile gint stride;           // Deliver every stride-th position-only frame
+    volatile gint process_us;       // Smoothed processing time of a delivered frame
+    volatile gint decimated;        // Frames not delivered
+    double budget;                  // Effective budget, percent of one core
+    // Watchdog
+    volatile gint last_detection_time;  // Monotonic seconds, set by the subscriber thread
+    int consecutive_timeouts;
+    bool recovery_in_progress;
+} vod_channel_ctx_t;
+
+
+static vod_channel_ctx_t vod_channels[VOD_MAX_CHANNELS];
+static int vod_num_channels = 0;
+static int vod_num_classes = 0;
+static pthread_mutex_t vod_mutex = PTHREAD_MUTEX_INITIALIZER;   // Channel table, subscriber API, dictionary
+static guint status_timer_id = 0;
+
+// Channel whose frame the calling thread is processing
+static __thread vod_channel_ctx_t *current_ctx = NULL;
+
+// Queue configuration, applied by VOD_Init
+static guint queue_depth = FRAME_QUEUE_DEFAULT_DEPTH;
+static int queue_policy = FRAME_QUEUE_DROP_OLDEST;
+
+// Decimation configuration, see VOD_Decimation_Config
+static double decimation_budget = 50.0;
+static double decimation_cpu_limit = 80.0;
+static int decimation_max_stride = 4;
+
+// An object not detected for this many input frames is expired, see
+// VOD_Expiry_Config. 0 keeps objects until the detector deletes them.
+static int missing_frames = 0;
+#define VOD_DEFAULT_FRAME_INTERVAL_US 100000
+
+#define OBJECT_STORE_INITIAL_CAPACITY 64
 
 
 // --- Helper to free a tracked object ---
@@ -84,132 +167,231 @@ static void free_tracked_object(tracked_object_t *obj) {
 
 
 // --- Helper to clear the entire object map ---
-static void clear_object_map(void) {
-    object_map_entry_t *entry = g_ctx.object_map;
-    while (entry) {
-        object_map_entry_t *next = entry->next;
-        free_tracked_object(&entry->obj);
-        free(entry);
-        entry = next;
+static void clear_object_map(vod_channel_ctx_t *ctx) {
+    object_store_t *store = &ctx->objects;
+    for (uint32_t i = 0; i < store->count; ++i)
+        free_tracked_object(&store->entries[i].obj);
+    store->count = 0;
+    IdMap_Clear(&store->index);
+}
+
+
+static void free_object_map(vod_channel_ctx_t *ctx) {
+    clear_object_map(ctx);
+    free(ctx->objects.entries);
+    ctx->objects.entries = NULL;
+    ctx->objects.capacity = 0;
+    IdMap_Free(&ctx->objects.index);
+}
+
+
+// --- Grow frame buffer arrays when a frame is larger than any before ---
+static bool reserve_frame_buffer(frame_buffer_t *buffer, size_t objects, size_t attributes) {
+    if (objects > buffer->object_capacity) {
+        size_t capacity = buffer->object_capacity ? buffer->object_capacity : OBJECT_STORE_INITIAL_CAPACITY;
+        while (capacity < objects) capacity *= 2;
+        vod_object_t *p = realloc(buffer->objects, capacity * sizeof(vod_object_t));
+        if (!p) return false;
+        buffer->objects = p;
+        buffer->object_capacity = capacity;
+    }
+    if (attributes > buffer->attribute_capacity) {
+        size_t capacity = buffer->attribute_capacity ? buffer->attribute_capacity : OBJECT_STORE_INITIAL_CAPACITY;
+        while (capacity < attributes) capacity *= 2;
+        vod_attribute_t *p = realloc(buffer->attributes, capacity * sizeof(vod_attribute_t));
+        if (!p) return false;
+        buffer->attributes = p;
+        buffer->attribute_capacity = capacity;
     }
-    g_ctx.object_map = NULL;
+    return true;
+}
+
+
+static void free_frame_buffer(vod_channel_ctx_t *ctx) {
+    frame_buffer_t *buffer = &ctx->frame_buffer;
+    free(buffer->objects);
+    free(buffer->attributes);
+    memset(buffer, 0, sizeof(*buffer));
 }
 
 
 // --- Get or create a tracked object by id ---
-static tracked_object_t *get_or_create_tracked(uint32_t id) {
-    object_map_entry_t *entry = g_ctx.object_map;
-    while (entry) {
-        if (entry->id == id) return &entry->obj;
-        entry = entry->next;
-    }
-    entry = calloc(1, sizeof(*entry));
-    if (!entry) {
+static tracked_object_t *get_or_create_tracked(vod_channel_ctx_t *ctx, uint32_t id) {
+    object_store_t *store = &ctx->objects;
+    if (!store->index.values && !IdMap_Init(&store->index, OBJECT_STORE_INITIAL_CAPACITY)) {
+        LOG_WARN("Memory allocation failed for object index");
+        return NULL;
+    }
+    uint32_t idx = IdMap_Find(&store->index, id);
+    if (idx != IDMAP_NONE)
+        return &store->entries[idx].obj;
+
+    if (store->count == store->capacity) {
+        uint32_t capacity = store->capacity ? store->capacity * 2 : OBJECT_STORE_INITIAL_CAPACITY;
+        object_map_entry_t *entries = realloc(store->entries, capacity * sizeof(object_map_entry_t));
+        if (!entries) {
+            LOG_WARN("Memory allocation failed for tracked object id=%u", id);
+            return NULL;
+        }
+        store->entries = entries;
+        store->capacity = capacity;
+    }
+    idx = store->count;
+    if (!IdMap_Put(&store->index, id, idx)) {
         LOG_WARN("Memory allocation failed for tracked object id=%u", id);
         return NULL;
     }
+    object_map_entry_t *entry = &store->entries[idx];
+    memset(entry, 0, sizeof(*entry));
+    store->count++;
     entry->id = id;
     entry->obj.active = true;
-    strncpy(entry->obj.class_name, "Unknown", sizeof(entry->obj.class_name) - 1);
-    entry->obj.class_name[sizeof(entry->obj.class_name) - 1] = '\0';
-    entry->next = g_ctx.object_map;
-    g_ctx.object_map = entry;
+    entry->obj.class_code = Dictionary_Lookup("Unknown");
     return &entry->obj;
 }
 
 
-// --- Remove all inactive objects from the cache ---
-static void remove_inactive_objects_from_cache(void) {
-    object_map_entry_t **pentry = &g_ctx.object_map;
-    while (*pentry) {
-        if (!(*pentry)->obj.active) {
-            object_map_entry_t *to_remove = *pentry;
-            *pentry = to_remove->next;
-            free_tracked_object(&to_remove->obj);
-            free(to_remove);
-        } else {
-            pentry = &(*pentry)->next;
-        }
+// --- Remove the entry at dense index idx; the last entry takes its place ---
+static void remove_tracked_at(vod_channel_ctx_t *ctx, uint32_t idx) {
+    object_store_t *store = &ctx->objects;
+    object_map_entry_t *entry = &store->entries[idx];
+    free_tracked_object(&entry->obj);
+    IdMap_Remove(&store->index, entry->id);
+    uint32_t last = store->count - 1;
+    if (idx != last) {
+        *entry = store->entries[last];
+        IdMap_Put(&store->index, entry->id, idx);
     }
+    store->count--;
 }
 
 
-// --- Attribute/class utilities ---
-static const char *get_class_name(int class_id) {
-    for (int i = 0; i < g_ctx.num_classes; ++i) {
-        if (video_object_detection_subscriber_det_class_id(g_ctx.det_classes[i]) == class_id) {
-            const char *name = video_object_detection_subscriber_det_class_name(g_ctx.det_classes[i]);
-            if (name && strlen(name) > 0) return name;
-        }
-    }
-    LOG_WARN("%s: Invalid class id %d\n", __func__,class_id);
-    return "Unknown";
+// --- Bounding box transformation ---
+static void transform_bbox(float left, float top, float right, float bottom, int *x, int *y, int *w, int *h) {
+    int x1 = (int)(left * 4096) + 4096;
+    int y1 = 4096 - (int)(top * 4096);
+    int x2 = (int)(right * 4096) + 4096;
+    int y2 = 4096 - (int)(bottom * 4096);
+    *x = (x1 * 1000) / 8192;
+    *y = (y1 * 1000) / 8192;
+    *w = ((x2 - x1) * 1000) / 8192;
+    *h = ((y2 - y1) * 1000) / 8192;
 }
 
 
-static VOD__AttributeType *find_attr_type(uint32_t type_id) {
-    if (!g_ctx.det_info) return NULL;
-    for (size_t i = 0; i < g_ctx.det_info->n_attribute_types; ++i) {
-        if (g_ctx.det_info->attribute_types[i] && g_ctx.det_info->attribute_types[i]->id == type_id)
-            return g_ctx.det_info->attribute_types[i];
+static gint now_seconds(void) {
+    return (gint)(g_get_monotonic_time() / G_USEC_PER_SEC);
+}
+
+
+// --- Frame time base ---
+// Scene.timestamp is mapped to epoch ms once per frame on the subscriber
+// thread. The offset to the device clock is the smallest receive-minus-
+// capture difference seen, so the fastest delivered frame has zero
+// latency. It is re-taken when the capture clock steps back or the mapping
+// drifts more than FRAME_TIME_RESYNC_MS from the device clock (detector
+// restart, clock adjustment).
+#define FRAME_TIME_RESYNC_MS 2000.0
+
+static double map_frame_time(vod_channel_ctx_t *ctx, uint64_t timestamp) {
+    double wall = ACAP_DEVICE_Timestamp();
+    if (timestamp == 0) return wall;
+    double capture = timestamp / 1000.0;
+    double delay = wall - (capture + ctx->frame_time_offset);
+    if (ctx->frame_time_last == 0 || timestamp < ctx->frame_time_last ||
+        delay > FRAME_TIME_RESYNC_MS || delay < -FRAME_TIME_RESYNC_MS) {
+        if (ctx->frame_time_last)
+            g_atomic_int_inc(&ctx->frame_time_resyncs);
+        ctx->frame_time_offset = wall - capture;
+    } else if (delay < 0) {
+        ctx->frame_time_offset += delay;
     }
+    ctx->frame_time_last = timestamp;
+    return capture + ctx->frame_time_offset;
+}
+
+
+// Input frame rate in frame time, measured before the queue so neither
+// dropped frames nor decimation change it. Missing-object expiry and the
+// decimation controller are based on it.
+static void track_frame_interval(vod_channel_ctx_t *ctx, double time_ms) {
+    double delta = time_ms - ctx->frame_time_prev;
+    ctx->frame_time_prev = time_ms;
+    if (delta <= 0 || delta > 10000.0)
+        return;
+    gint interval = (gint)(delta * 1000.0);
+    gint average = g_atomic_int_get(&ctx->frame_interval_us);
+    g_atomic_int_set(&ctx->frame_interval_us, average ? (average * 7 + interval) / 8 : interval);
+}
+
+
+static double frame_interval_ms(vod_channel_ctx_t *ctx) {
+    gint interval = g_atomic_int_get(&ctx->frame_interval_us);
+    return (interval > 0 ? interval : VOD_DEFAULT_FRAME_INTERVAL_US) / 1000.0;
+}
+
+
+static double channel_time(vod_channel_ctx_t *ctx) {
+    pthread_mutex_lock(&ctx->clock_mutex);
+    double frame_ms = ctx->clock_frame_ms;
+    gint64 frame_mono = ctx->clock_frame_mono;
+    pthread_mutex_unlock(&ctx->clock_mutex);
+    if (frame_ms == 0)
+        return ACAP_DEVICE_Timestamp();
+    if (current_ctx == ctx)
+        return frame_ms;
+    return frame_ms + (g_get_monotonic_time() - frame_mono) / 1000.0;
+}
+
+
+static vod_channel_ctx_t *find_channel(int channel) {
+    for (int i = 0; i < vod_num_channels; ++i)
+        if (vod_channels[i].channel == channel)
+            return &vod_channels[i];
     return NULL;
 }
 
 
-static const char *get_attr_type_name(uint32_t type_id) {
-    VOD__AttributeType *type = find_attr_type(type_id);
-    if (type && type->name && strlen(type->name) > 0)
-        return type->name;
-    return "UnknownType";
+double VOD_Time(void) {
+    if (current_ctx)
+        return channel_time(current_ctx);
+    if (vod_num_channels == 0)
+        return ACAP_DEVICE_Timestamp();
+    return channel_time(&vod_channels[0]);
 }
 
 
-static const char *get_attr_class_name(uint32_t type_id, uint32_t class_id) {
-    VOD__AttributeType *type = find_attr_type(type_id);
-    if (!type) return "UnknownClass";
-    for (size_t i = 0; i < type->n_classes; ++i) {
-        if (type->classes[i] && type->classes[i]->id == class_id) {
-            if (type->classes[i]->name && strlen(type->classes[i]->name) > 0)
-                return type->classes[i]->name;
-            break;
-        }
-    }
-    return "UnknownClass";
+double VOD_Channel_Time(int channel) {
+    vod_channel_ctx_t *ctx = find_channel(channel);
+    return ctx ? channel_time(ctx) : VOD_Time();
 }
 
 
-// --- Bounding box transformation ---
-static void transform_bbox(float left, float top, float right, float bottom, int *x, int *y, int *w, int *h) {
-    int x1 = (int)(left * 4096) + 4096;
-    int y1 = 4096 - (int)(top * 4096);
-    int x2 = (int)(right * 4096) + 4096;
-    int y2 = 4096 - (int)(bottom * 4096);
-    *x = (x1 * 1000) / 8192;
-    *y = (y1 * 1000) / 8192;
-    *w = ((x2 - x1) * 1000) / 8192;
-    *h = ((y2 - y1) * 1000) / 8192;
+void VOD_Wake(int channel) {
+    vod_channel_ctx_t *ctx = find_channel(channel);
+    if (ctx && ctx->worker_running)
+        FrameQueue_Wake(&ctx->queue);
 }
 
 
 // --- VOD Recovery Function ---
 // Note: This function should be called with vod_mutex held
-static int vod_recover_subscription(void) {
-    LOG_WARN("VOD: Attempting to recover subscription...");
+static int vod_recover_subscription(vod_channel_ctx_t *ctx) {
+    LOG_WARN("VOD: Attempting to recover subscription on channel %d...", ctx->channel);
     
-    if (recovery_in_progress) {
+    if (ctx->recovery_in_progress) {
         LOG_WARN("VOD: Recovery already in progress, skipping");
         return -1;
     }
     
-    recovery_in_progress = true;
+    ctx->recovery_in_progress = true;
     
     // Step 1: Unsubscribe
-    if (subscriber) {
+    if (ctx->subscriber) {
         LOG("VOD: Unsubscribing...");
         // Unlock mutex during blocking operations
         pthread_mutex_unlock(&vod_mutex);
-        int ret = video_object_detection_subscriber_unsubscribe(subscriber);
+        int ret = video_object_detection_subscriber_unsubscribe(ctx->subscriber);
         if (ret != VIDEO_OBJECT_DETECTION_SUBSCRIBER_SUCCESS) {
             LOG_WARN("VOD: Unsubscribe failed with error %d", ret);
         }
@@ -220,27 +402,27 @@ static int vod_recover_subscription(void) {
     }
     
     // Step 2: Re-subscribe
-    if (subscriber) {
+    if (ctx->subscriber) {
         LOG("VOD: Re-subscribing...");
         // Unlock mutex during blocking operations
         pthread_mutex_unlock(&vod_mutex);
-        int ret = video_object_detection_subscriber_subscribe(subscriber);
+        int ret = video_object_detection_subscriber_subscribe(ctx->subscriber);
         pthread_mutex_lock(&vod_mutex);
         
         if (ret == VIDEO_OBJECT_DETECTION_SUBSCRIBER_SUCCESS) {
             LOG("VOD: Subscription recovered successfully");
-            last_detection_time = g_get_real_time() / 1000000.0;
-            consecutive_timeouts = 0;
-            recovery_in_progress = false;
+            g_atomic_int_set(&ctx->last_detection_time, now_seconds());
+            ctx->consecutive_timeouts = 0;
+            ctx->recovery_in_progress = false;
             return 0;
         } else {
             LOG_WARN("VOD: Re-subscribe failed with error %d", ret);
-            recovery_in_progress = false;
+            ctx->recovery_in_progress = false;
             return ret;
         }
     }
     
-    recovery_in_progress = false;
+    ctx->recovery_in_progress = false;
     return -1;
 }
 
@@ -249,33 +431,36 @@ static int vod_recover_subscription(void) {
 static gboolean vod_watchdog_timer(gpointer user_data) {
     pthread_mutex_lock(&vod_mutex);
     
-    double now = g_get_real_time() / 1000000.0;
-    
-    if (last_detection_time > 0 && !recovery_in_progress) {
-        double elapsed = now - last_detection_time;
-        
+    gint now = now_seconds();
+    for (int i = 0; i < vod_num_channels; ++i) {
+        vod_channel_ctx_t *ctx = &vod_channels[i];
+        gint last = g_atomic_int_get(&ctx->last_detection_time);
+        if (last <= 0 || ctx->recovery_in_progress)
+            continue;
+
+        double elapsed = now - last;
         if (elapsed > DETECTION_TIMEOUT_SECONDS) {
-            consecutive_timeouts++;
+            ctx->consecutive_timeouts++;
             
-            LOG_WARN("VOD: No detection data received for %.1f seconds (timeout #%d/%d)", 
-                     elapsed, consecutive_timeouts, MAX_CONSECUTIVE_TIMEOUTS);
+            LOG_WARN("VOD: No detection data received on channel %d for %.1f seconds (timeout #%d/%d)", 
+                     ctx->channel, elapsed, ctx->consecutive_timeouts, MAX_CONSECUTIVE_TIMEOUTS);
             
-            if (consecutive_timeouts >= MAX_CONSECUTIVE_TIMEOUTS) {
+            if (ctx->consecutive_timeouts >= MAX_CONSECUTIVE_TIMEOUTS) {
                 LOG_WARN("VOD: Maximum consecutive timeouts reached, triggering recovery");
                 
                 // Attempt recovery
-                int ret = vod_recover_subscription();
+                int ret = vod_recover_subscription(ctx);
                 if (ret != 0) {
                     LOG_WARN("VOD: Recovery failed, will retry on next timeout");
                 } else {
-                    consecutive_timeouts = 0;
+                    ctx->consecutive_timeouts = 0;
                 }
             }
         } else {
             // Data received, reset timeout counter
-            if (consecutive_timeouts > 0) {
-                LOG("VOD: Data flow resumed, resetting timeout counter");
-                consecutive_timeouts = 0;
+            if (ctx->consecutive_timeouts > 0) {
+                LOG("VOD: Data flow resumed on channel %d, resetting timeout counter", ctx->channel);
+                ctx->consecutive_timeouts = 0;
             }
         }
     }
@@ -285,97 +470,135 @@ static gboolean vod_watchdog_timer(gpointer user_data) {
 }
 
 
-// --- Main detection callback ---
+// --- Main detection callback (subscriber thread) ---
+// Only decodes and queues the frame; processing runs on the channel's
+// worker thread so a slow consumer never back-pressures the detection service.
 static void detection_callback(const uint8_t *data, size_t size, void *user_data) {
-    pthread_mutex_lock(&vod_mutex);
-    
+    vod_channel_ctx_t *ctx = (vod_channel_ctx_t *)user_data;
+    gint64 received = g_get_monotonic_time();
+
     // Update watchdog timestamp
-    last_detection_time = g_get_real_time() / 1000000.0;
-    
-    // Reset timeout counter when data is received
-    if (consecutive_timeouts > 0) {
-        consecutive_timeouts = 0;
-    }
-    
-    VOD__Scene *scene = vod__scene__unpack(NULL, size, data);
+    g_atomic_int_set(&ctx->last_detection_time, now_seconds());
+
+    // Recordings hold a single channel
+    if (ctx == &vod_channels[0])
+        Recorder_Scene(data, size, received);
+
+    scene_frame_t *scene = FrameQueue_Acquire(&ctx->queue);
     if (!scene) {
+        LOG_TRACE("%s: No free frame, dropping incoming frame\n", __func__);
+        return;
+    }
+    int rc = Scene_Decode(scene, data, size);
+    if (rc == SCENE_DECODE_FALLBACK) {
+        ctx->decode_fallbacks++;
+        rc = Scene_Decode_Protobuf(scene, data, size);
+    }
+    ctx->decode_time_us += g_get_monotonic_time() - received;
+    if (rc != SCENE_DECODE_OK) {
+        ctx->decode_errors++;
         LOG_WARN("%s: Failed to unpack detection protobuf data", __func__);
-        pthread_mutex_unlock(&vod_mutex);
         return;
     }
+    scene->time_ms = map_frame_time(ctx, scene->timestamp);
+    track_frame_interval(ctx, scene->time_ms);
+    ctx->decoded_frames++;
+    FrameQueue_Push(&ctx->queue, received);
+}
+
+
+// --- Frame processing (worker thread) ---
+static void set_channel_clock(vod_channel_ctx_t *ctx, double time_ms) {
+    pthread_mutex_lock(&ctx->clock_mutex);
+    ctx->clock_frame_ms = time_ms;
+    ctx->clock_frame_mono = g_get_monotonic_time();
+    pthread_mutex_unlock(&ctx->clock_mutex);
+}
+
+
+// True if an active object is due to expire. Called with ctx->lock held.
+static bool has_expired(vod_channel_ctx_t *ctx, uint32_t frame, double now, double missing_ms) {
+    if (missing_ms <= 0)
+        return false;
+    const object_store_t *store = &ctx->objects;
+    for (uint32_t i = 0; i < store->count; ++i) {
+        const tracked_object_t *track = &store->entries[i].obj;
+        if (track->active && track->seen_frame != frame && now - track->seen_ms >= missing_ms)
+            return true;
+    }
+    return false;
+}
+
+
+static void process_frame(vod_channel_ctx_t *ctx, const scene_frame_t *scene) {
+    gint64 started = g_get_monotonic_time();
+    pthread_mutex_lock(&ctx->lock);
+    bool deaths = false;
 
 
     // 1. Handle DeleteOperation events
-    for (size_t e = 0; e < scene->n_events; ++e) {
-        VOD__Event *ev = scene->events[e];
-        if (!ev) continue;
-        if (ev->action == VOD__EVENT_ACTION__EVENT_DELETE) {
-            tracked_object_t *track = get_or_create_tracked((uint32_t)ev->object_id);
+    for (uint32_t e = 0; e < scene->num_events; ++e) {
+        if (scene->event_action[e] == VOD__EVENT_ACTION__EVENT_DELETE) {
+            tracked_object_t *track = get_or_create_tracked(ctx, (uint32_t)scene->event_ids[e]);
             if (track) {
                 track->active = false;
-                track->missing_frames = 0;
+                deaths = true;
             } else {
-                LOG_WARN("Delete event for unknown object id=%d", ev->object_id);
+                LOG_WARN("Delete event for unknown object id=%d", scene->event_ids[e]);
             }
         }
     }
 
 
-    // 2. Mark all objects as not detected this frame
-    for (object_map_entry_t *entry = g_ctx.object_map; entry; entry = entry->next) {
-        entry->obj.detected_this_frame = false;
-    }
+    // 2. New frame sequence; objects not stamped with it were not detected
+    uint32_t frame = ++ctx->frame;
+    int num_classes = g_atomic_int_get(&vod_num_classes);
+    uint32_t known = ctx->objects.count;
 
 
     // 3. Process detections with validation
-    for (size_t i = 0; i < scene->n_detections; ++i) {
+    for (uint32_t d = 0; d < scene->num_detections; ++d) {
         
-        VOD__Detection *det = scene->detections[i];
-        if (!det) continue;
-        if (det->detection_status != VOD__DETECTION__DETECTION_STATUS__TRACKED_CONFIDENT && vod_predictions==0) continue;
+        uint32_t det_id = scene->ids[d];
+        uint32_t det_class = scene->classes[d];
+        uint32_t det_score = scene->scores[d];
+        if (scene->status[d] != VOD__DETECTION__DETECTION_STATUS__TRACKED_CONFIDENT && vod_predictions==0) continue;
 
 
-        bool valid_class = (det->det_class >= 0) && (det->det_class < g_ctx.num_classes);
-        bool valid_score = (det->score > 0);
+        bool valid_class = (int)det_class >= 0 && (int)det_class < num_classes;
+        bool valid_score = (det_score > 0);
         if (!valid_class || !valid_score) {
-            LOG_WARN("Skipping detection id=%u: invalid class_id=%d or score=%u", det->id, det->det_class, det->score);
+            LOG_WARN("Skipping detection id=%u: invalid class_id=%d or score=%u", det_id, (int)det_class, det_score);
             continue;
         }
 
 
-        tracked_object_t *track = get_or_create_tracked(det->id);
+        tracked_object_t *track = get_or_create_tracked(ctx, det_id);
         if (!track) continue;
 
 
-        track->confidence = det->score;
-        track->type = det->det_class;
-        const char *cls_name = get_class_name(det->det_class);
-        if (cls_name && strlen(cls_name) > 0) {
-            strncpy(track->class_name, cls_name, sizeof(track->class_name) - 1);
-            track->class_name[sizeof(track->class_name) - 1] = '\0';
-        } else {
-            strncpy(track->class_name, "Unknown", sizeof(track->class_name) - 1);
-            track->class_name[sizeof(track->class_name) - 1] = '\0';
-            LOG_WARN("%s: Invalid track->class_name", __func__);
-        }
+        track->confidence = det_score;
+        track->type = det_class;
+        track->class_code = Dictionary_Class(det_class);
 
 
-        transform_bbox(det->left, det->top, det->right, det->bottom, &track->x, &track->y, &track->w, &track->h);
+        transform_bbox(scene->left[d], scene->top[d], scene->right[d], scene->bottom[d], &track->x, &track->y, &track->w, &track->h);
 
 
         // Attributes: Only process those with valid score
-        for (size_t a = 0; a < det->n_attributes; ++a) {
-            VOD__Attribute *attr = det->attributes[a];
-            if (!attr) continue;
-            if (attr->has_score_case != VOD__ATTRIBUTE__HAS_SCORE_SCORE) continue;
+        uint32_t attr_end = scene->attr_first[d] + scene->attr_count[d];
+        for (uint32_t a = scene->attr_first[d]; a < attr_end; ++a) {
+            if (!(scene->attr_flags[a] & SCENE_ATTR_HAS_SCORE)) continue;
+            uint32_t attr_type = scene->attr_type[a];
+            uint32_t attr_class = scene->attr_class[a];
+            uint32_t attr_score = scene->attr_score[a];
 
 
             size_t idx = 0;
-            while (idx < track->num_attributes && track->attributes[idx].type_id != attr->type) idx++;
+            while (idx < track->num_attributes && track->attributes[idx].type_id != attr_type) idx++;
 
 
-            const char *type_name = get_attr_type_name(attr->type);
-            const char *class_name = get_attr_class_name(attr->type, attr->attr_class);
+            dict_code_t class_code = Dictionary_Attribute_Class(attr_type, attr_class);
 
 
             if (idx == track->num_attributes) {
@@ -385,134 +608,273 @@ static void detection_callback(const uint8_t *data, size_t size, void *user_data
                     continue;
                 }
                 track->attributes = new_attrs;
-                track->attributes[idx].type_id = attr->type;
-                strncpy(track->attributes[idx].type_name, type_name, sizeof(track->attributes[idx].type_name) - 1);
-                track->attributes[idx].type_name[sizeof(track->attributes[idx].type_name) - 1] = '\0';
-                track->attributes[idx].class_id = attr->attr_class;
-                strncpy(track->attributes[idx].class_name, class_name, sizeof(track->attributes[idx].class_name) - 1);
-                track->attributes[idx].class_name[sizeof(track->attributes[idx].class_name) - 1] = '\0';
-                track->attributes[idx].score = attr->score;
+                track->attributes[idx].type_id = attr_type;
+                track->attributes[idx].type_code = Dictionary_Attribute_Type(attr_type);
+                track->attributes[idx].class_id = attr_class;
+                track->attributes[idx].class_code = class_code;
+                track->attributes[idx].score = attr_score;
                 track->num_attributes++;
-            } else if (attr->score > track->attributes[idx].score) {
-                track->attributes[idx].class_id = attr->attr_class;
-                strncpy(track->attributes[idx].class_name, class_name, sizeof(track->attributes[idx].class_name) - 1);
-                track->attributes[idx].class_name[sizeof(track->attributes[idx].class_name) - 1] = '\0';
-                track->attributes[idx].score = attr->score;
+            } else if (attr_score > track->attributes[idx].score) {
+                track->attributes[idx].class_id = attr_class;
+                track->attributes[idx].class_code = class_code;
+                track->attributes[idx].score = attr_score;
             }
         }
 
 
         track->active = true;
-        track->missing_frames = 0;
-        track->detected_this_frame = true;
+        track->seen_frame = frame;
+        track->seen_ms = scene->time_ms;
     }
 
 
-    // 4. Increment missing_frames for objects not detected this frame
-    for (object_map_entry_t *entry = g_ctx.object_map; entry; entry = entry->next) {
-        tracked_object_t *track = &entry->obj;
-        if (!track->detected_this_frame) {
-            if (track->active && track->missing_frames >= 5) {
-                track->active = false;
-            }
-        }
+    // 4. Decimation: a frame that only moves known objects may be skipped.
+    //    Births, deletions and expiries are always delivered; missing
+    //    objects are expired by time so skipped frames do not count.
+    object_store_t *store = &ctx->objects;
+    double missing_ms = missing_frames > 0 ? missing_frames * frame_interval_ms(ctx) : 0;
+    gint stride = g_atomic_int_get(&ctx->stride);
+    if (stride > 1 && frame % stride != 0 && !deaths && store->count == known &&
+        !has_expired(ctx, frame, scene->time_ms, missing_ms)) {
+        pthread_mutex_unlock(&ctx->lock);
+        set_channel_clock(ctx, scene->time_ms);
+        g_atomic_int_inc(&ctx->decimated);
+        return;
     }
 
 
-    // 5. Prepare ALL objects in cache for callback
-    size_t count = 0;
-    for (object_map_entry_t *entry = g_ctx.object_map; entry; entry = entry->next)
-        count++;
+    // 5. Single pass over the live entries: expire missing objects, copy
+    //    every object for the callback and drop inactive ones from the cache
+    size_t count = store->count;
 
+    void *user_data_copy = ctx->user_data;
+    vod_callback_t callback = ctx->cb;
+
+    frame_buffer_t *buffer = &ctx->frame_buffer;
     vod_object_t *out_objs = NULL;
+    vod_attribute_t *out_attrs = NULL;
     size_t out_count = 0;
-    void *user_data_copy = g_ctx.user_data;
-    vod_callback_t callback = g_ctx.cb;
+    size_t attr_count = 0;
 
     if (count > 0 && callback) {
-        out_objs = calloc(count, sizeof(vod_object_t));
-        if (!out_objs) {
+        size_t attr_total = 0;
+        for (uint32_t j = 0; j < store->count; ++j)
+            attr_total += store->entries[j].obj.num_attributes;
+        if (reserve_frame_buffer(buffer, count, attr_total)) {
+            out_objs = buffer->objects;
+            out_attrs = buffer->attributes;
+        } else {
             LOG_WARN("%s: Memory allocation failed for output objects", __func__);
-            vod__scene__free_unpacked(scene, NULL);
-            pthread_mutex_unlock(&vod_mutex);
-            LOG_TRACE("Error VOD>");
-            return;
         }
-        for (object_map_entry_t *entry = g_ctx.object_map; entry; entry = entry->next) {
-            tracked_object_t *track = &entry->obj;
+    }
+
+    uint32_t i = 0;
+    while (i < store->count) {
+        object_map_entry_t *entry = &store->entries[i];
+        tracked_object_t *track = &entry->obj;
+        if (missing_ms > 0 && track->active && track->seen_frame != frame &&
+            scene->time_ms - track->seen_ms >= missing_ms)
+            track->active = false;
+        if (out_objs) {
             vod_object_t *obj = &out_objs[out_count++];
-            snprintf(obj->id, sizeof(obj->id), "%u", entry->id);
+            obj->id = entry->id;
             obj->confidence = track->confidence;
             obj->type = track->type;
-            if (track->class_name && strlen(track->class_name) > 0) {
-                strncpy(obj->class_name, track->class_name, sizeof(obj->class_name) - 1);
-                obj->class_name[sizeof(obj->class_name) - 1] = '\0';
-            } else {
-                snprintf(obj->class_name, sizeof(obj->class_name), "Invalid");
-                LOG_WARN("%s: obj->class_name invalid for id %u", __func__, entry->id);
-            }
+            obj->class_code = track->class_code;
             obj->x = track->x;
             obj->y = track->y;
             obj->w = track->w;
             obj->h = track->h;
             obj->active = track->active;
             obj->num_attributes = track->num_attributes;
-            if (obj->num_attributes > 0) {
-                obj->attributes = calloc(obj->num_attributes, sizeof(vod_attribute_t));
-                if (!obj->attributes) {
-                    LOG_WARN("%s: Memory allocation failed for attributes in output object id %u", __func__, entry->id);
-                    obj->num_attributes = 0;
-                } else {
-                    for (size_t j = 0; j < obj->num_attributes; ++j) {
-                        obj->attributes[j].name = strdup(track->attributes[j].type_name);
-                        obj->attributes[j].value = strdup(track->attributes[j].class_name);
-                        if (!obj->attributes[j].name || !obj->attributes[j].value) {
-                            LOG_WARN("%s: strdup failed for attribute in output object id %u", __func__, entry->id);
-                            free(obj->attributes[j].name);
-                            free(obj->attributes[j].value);
-                            obj->attributes[j].name = NULL;
-                            obj->attributes[j].value = NULL;
-                        }
-                    }
-                }
-            } else {
-                obj->attributes = NULL;
+            obj->attributes = obj->num_attributes ? &out_attrs[attr_count] : NULL;
+            for (size_t j = 0; j < track->num_attributes; ++j) {
+                out_attrs[attr_count].type = track->attributes[j].type_code;
+                out_attrs[attr_count].value = track->attributes[j].class_code;
+                attr_count++;
             }
         }
+        // Removal moves the last entry into slot i; re-visit it
+        if (!track->active)
+            remove_tracked_at(ctx, i);
+        else
+            i++;
     }
 
-    // 6. Remove all inactive objects from cache
-    remove_inactive_objects_from_cache();
-
-    vod__scene__free_unpacked(scene, NULL);
+    buffer->view.channel = ctx->channel;
+    buffer->view.sequence = frame;
+    buffer->view.timestamp = scene->time_ms;
+    buffer->view.objects = out_objs;
+    buffer->view.num_objects = out_count;
     LOG_TRACE("VOD>");
 
-    pthread_mutex_unlock(&vod_mutex);
+    pthread_mutex_unlock(&ctx->lock);
+    set_channel_clock(ctx, scene->time_ms);
 
     // Now call callback WITHOUT holding the mutex
     if (callback && out_objs) {
-        callback(out_objs, out_count, user_data_copy);
-        for (size_t i = 0; i < out_count; ++i) {
-            if (out_objs[i].attributes) {
-                for (size_t j = 0; j < out_objs[i].num_attributes; ++j) {
-                    free(out_objs[i].attributes[j].name);
-                    free(out_objs[i].attributes[j].value);
-                }
-                free(out_objs[i].attributes);
-            }
+        current_ctx = ctx;
+        callback(&buffer->view, user_data_copy);
+        current_ctx = NULL;
+    }
+
+    double latency = (ACAP_DEVICE_Timestamp() - scene->time_ms) * 1000.0;
+    gint latency_value = latency < 0 ? 0 : (latency > G_MAXINT ? G_MAXINT : (gint)latency);
+    g_atomic_int_set(&ctx->latency_us, latency_value);
+    if (latency_value > g_atomic_int_get(&ctx->max_latency_us))
+        g_atomic_int_set(&ctx->max_latency_us, latency_value);
+
+    gint elapsed = (gint)MIN(g_get_monotonic_time() - started, (gint64)G_USEC_PER_SEC);
+    gint average = g_atomic_int_get(&ctx->process_us);
+    g_atomic_int_set(&ctx->process_us, average ? (average * 7 + elapsed) / 8 : elapsed);
+}
+
+
+static void *vod_worker(void *arg) {
+    vod_channel_ctx_t *ctx = (vod_channel_ctx_t *)arg;
+    scene_frame_t *scene;
+    for (;;) {
+        scene = FrameQueue_Pop(&ctx->queue);
+        if (scene) {
+            process_frame(ctx, scene);
+            FrameQueue_Release(&ctx->queue);
         }
-        free(out_objs);
+        if (FrameQueue_Woken(&ctx->queue)) {
+            // Requested by VOD_Wake; the callback gets no frame
+            if (ctx->cb)
+                ctx->cb(NULL, ctx->user_data);
+        } else if (!scene) {
+            break;
+        }
+    }
+    return NULL;
+}
+
+
+// --- Decimation controller (main loop, with the status update) ---
+// A channel may use its budget, in percent of one core, for processing.
+// The budget shrinks in proportion when the device load per core is above
+// the CPU limit. The stride needed to fit the measured cost into the
+// budget is applied at once; a lower stride is approached one step per
+// update so a short dip in cost does not make it oscillate.
+static double device_load(void) {
+    int cores = get_nprocs();
+    return ACAP_DEVICE_CPU_Average() * 100.0 / (cores > 0 ? cores : 1);
+}
+
+
+static void update_stride(vod_channel_ctx_t *ctx, double load) {
+    double budget = decimation_budget;
+    if (decimation_cpu_limit > 0 && load > decimation_cpu_limit)
+        budget *= decimation_cpu_limit / load;
+    ctx->budget = budget;
+    gint current = g_atomic_int_get(&ctx->stride);
+    gint process_us = g_atomic_int_get(&ctx->process_us);
+    if (decimation_max_stride <= 1 || budget <= 0) {
+        g_atomic_int_set(&ctx->stride, 1);
+        return;
+    }
+    if (process_us <= 0)
+        return;
+    double needed = 100.0 * process_us / (frame_interval_ms(ctx) * 1000.0);
+    gint stride = (gint)ceil(needed / budget);
+    stride = CLAMP(stride, 1, decimation_max_stride);
+    if (stride < current)
+        stride = current - 1;
+    if (stride != current)
+        LOG_TRACE("%s: Channel %d stride %d -> %d (%.1f%% needed, %.1f%% budget)\n",
+                  __func__, ctx->channel, current, stride, needed, budget);
+    g_atomic_int_set(&ctx->stride, stride);
+}
+
+
+// --- Queue counters for /status, one group per channel ---
+static gboolean vod_status_timer(gpointer user_data) {
+    double load = device_load();
+    pthread_mutex_lock(&vod_mutex);
+    for (int i = 0; i < vod_num_channels; ++i) {
+        vod_channel_ctx_t *ctx = &vod_channels[i];
+        update_stride(ctx, load);
+        const char *group = ctx->status_group;
+        frame_queue_stats_t stats;
+        FrameQueue_Stats(&ctx->queue, &stats);
+        FrameQueue_Reset_Max_Lag(&ctx->queue);
+        ACAP_STATUS_SetNumber(group, "channel", ctx->channel);
+        ACAP_STATUS_SetNumber(group, "queueDepth", stats.depth);
+        ACAP_STATUS_SetNumber(group, "queued", stats.queued);
+        ACAP_STATUS_SetNumber(group, "highWater", stats.high_water);
+        ACAP_STATUS_SetNumber(group, "frames", stats.processed);
+        ACAP_STATUS_SetNumber(group, "dropped", stats.dropped);
+        ACAP_STATUS_SetNumber(group, "coalesced", stats.coalesced);
+        ACAP_STATUS_SetNumber(group, "rejected", stats.rejected);
+        ACAP_STATUS_SetNumber(group, "lag", stats.lag_us / 1000.0);
+        ACAP_STATUS_SetNumber(group, "maxLag", stats.max_lag_us / 1000.0);
+        ACAP_STATUS_SetNumber(group, "latency", g_atomic_int_get(&ctx->latency_us) / 1000.0);
+        ACAP_STATUS_SetNumber(group, "maxLatency", g_atomic_int_get(&ctx->max_latency_us) / 1000.0);
+        g_atomic_int_set(&ctx->max_latency_us, 0);
+        ACAP_STATUS_SetNumber(group, "timeResyncs", g_atomic_int_get(&ctx->frame_time_resyncs));
+        ACAP_STATUS_SetNumber(group, "frameInterval", frame_interval_ms(ctx));
+        ACAP_STATUS_SetNumber(group, "processTime", g_atomic_int_get(&ctx->process_us) / 1000.0);
+        ACAP_STATUS_SetNumber(group, "budget", ctx->budget);
+        ACAP_STATUS_SetNumber(group, "load", load);
+        ACAP_STATUS_SetNumber(group, "stride", g_atomic_int_get(&ctx->stride));
+        ACAP_STATUS_SetNumber(group, "decimated", g_atomic_int_get(&ctx->decimated));
     }
+    pthread_mutex_unlock(&vod_mutex);
+    return G_SOURCE_CONTINUE;
+}
+
+
+int VOD_Backlog(void) {
+    int backlog = 0;
+    for (int i = 0; i < vod_num_channels; ++i) {
+        frame_queue_stats_t stats;
+        FrameQueue_Stats(&vod_channels[i].queue, &stats);
+        backlog += (int)(stats.pushed - stats.processed - stats.dropped - stats.coalesced);
+    }
+    return backlog;
+}
+
+
+void VOD_Queue_Config(int depth, const char *overflow) {
+    queue_depth = depth > 0 ? (guint)depth : FRAME_QUEUE_DEFAULT_DEPTH;
+    queue_policy = FrameQueue_Policy(overflow);
+}
+
+
+void VOD_Decimation_Config(int budget, int cpu_limit, int max_stride) {
+    decimation_budget = budget > 0 ? budget : 0;
+    decimation_cpu_limit = cpu_limit > 0 ? cpu_limit : 0;
+    decimation_max_stride = max_stride > 1 ? max_stride : 1;
+}
+
+
+void VOD_Expiry_Config(int frames) {
+    missing_frames = frames > 0 ? frames : 0;
 }
 
 
 // --- Optional: Periodic debug function ---
 gboolean VOD_Debug_timer(gpointer user_data) {
     pthread_mutex_lock(&vod_mutex);
-    int count = 0;
-    for (object_map_entry_t *entry = g_ctx.object_map; entry; entry = entry->next)
-        count++;
-    LOG_TRACE("VOD Cache: %d\n", count);
+    for (int i = 0; i < vod_num_channels; ++i) {
+        vod_channel_ctx_t *ctx = &vod_channels[i];
+        pthread_mutex_lock(&ctx->lock);
+        const object_store_t *store = &ctx->objects;
+        const idmap_t *index = &store->index;
+        LOG_TRACE("VOD Cache %d: %u (capacity %u, slots %u, lookups %llu, probes/lookup %.2f, inserts %llu, removes %llu, grows %u)\n",
+                  ctx->channel, store->count, store->capacity, index->values ? index->mask + 1 : 0,
+                  (unsigned long long)index->lookups,
+                  index->lookups ? (double)index->probes / index->lookups : 0.0,
+                  (unsigned long long)index->inserts, (unsigned long long)index->removes, index->grows);
+        LOG_TRACE("VOD Decode %d: %llu frames, %.1f us/frame, %llu fallbacks, %llu errors, %u pooled frames\n",
+                  ctx->channel, (unsigned long long)ctx->decoded_frames,
+                  ctx->decoded_frames ? (double)ctx->decode_time_us / ctx->decoded_frames : 0.0,
+                  (unsigned long long)ctx->decode_fallbacks, (unsigned long long)ctx->decode_errors,
+                  ctx->queue.pool_size);
+        (void)store; (void)index;   // Only referenced when LOG_TRACE is enabled
+        pthread_mutex_unlock(&ctx->lock);
+    }
     pthread_mutex_unlock(&vod_mutex);
     return G_SOURCE_CONTINUE;
 }
@@ -660,38 +1022,48 @@ cJSON* VOD_Detector_Information() {
 }
 
 
-
-// --- Initialization and shutdown ---
-int VOD_Init(int channel, vod_callback_t cb, void *user_data, int predictions) {
+cJSON* VOD_Scene_Description(uint8_t **info, size_t *info_size) {
+    *info = NULL;
+    *info_size = 0;
     pthread_mutex_lock(&vod_mutex);
-    LOG_TRACE("%s: Entry\n", __func__);
-    if (!cb) {
-        LOG_WARN("%s: Callback function is NULL", __func__);
+    video_object_detection_subscriber_class_t **det_classes = NULL;
+    int num_classes = video_object_detection_subscriber_det_classes_get(&det_classes);
+    if (num_classes <= 0) {
         pthread_mutex_unlock(&vod_mutex);
-        return -1;
+        return NULL;
     }
-    memset(&g_ctx, 0, sizeof(g_ctx));
-    g_ctx.cb = cb;
-    g_ctx.user_data = user_data;
-
-
-
-    int major,minor;
-    if (video_object_detection_subscriber_get_version(&major,&minor) != VIDEO_OBJECT_DETECTION_SUBSCRIBER_SUCCESS) {
-        LOG_WARN("%s: No version detected", __func__);
+    if (video_object_detection_subscriber_get_detector_information(info, info_size) != 0 || !*info) {
+        video_object_detection_subscriber_det_classes_free(det_classes, num_classes);
         pthread_mutex_unlock(&vod_mutex);
+        *info = NULL;
+        *info_size = 0;
+        return NULL;
     }
-    LOG("%s: Version = %d.%d\n",__func__,major,minor);
 
+    cJSON *description = cJSON_CreateObject();
+    cJSON_AddNumberToObject(description, "channel", vod_num_channels ? vod_channels[0].channel : 0);
+    cJSON_AddBoolToObject(description, "predictions", vod_predictions);
+    cJSON *classes = cJSON_AddArrayToObject(description, "classes");
+    for (int i = 0; i < num_classes; ++i) {
+        const char *name = video_object_detection_subscriber_det_class_name(det_classes[i]);
+        cJSON *cls = cJSON_CreateObject();
+        cJSON_AddNumberToObject(cls, "id", video_object_detection_subscriber_det_class_id(det_classes[i]));
+        cJSON_AddStringToObject(cls, "name", name ? name : "");
+        cJSON_AddItemToArray(classes, cls);
+    }
+    video_object_detection_subscriber_det_classes_free(det_classes, num_classes);
+    pthread_mutex_unlock(&vod_mutex);
+    return description;
+}
 
-    vod_predictions = predictions;
-    if (vod_predictions)
-        LOG("Predicted positions enabled");
-    
-    g_ctx.num_classes = video_object_detection_subscriber_det_classes_get(&g_ctx.det_classes);
-    if (g_ctx.num_classes <= 0) {
+
+// --- Load detector classes and attributes into the dictionary ---
+// Note: This function should be called with vod_mutex held
+static int load_dictionary(void) {
+    video_object_detection_subscriber_class_t **det_classes = NULL;
+    int num_classes = video_object_detection_subscriber_det_classes_get(&det_classes);
+    if (num_classes <= 0) {
         LOG_WARN("%s: No detection classes found", __func__);
-        pthread_mutex_unlock(&vod_mutex);
         return -2;
     }
 
@@ -700,57 +1072,157 @@ int VOD_Init(int channel, vod_callback_t cb, void *user_data, int predictions) {
     size_t size = 0;
     if (video_object_detection_subscriber_get_detector_information(&buffer, &size) != 0) {
         LOG_WARN("%s: Failed to get detector information", __func__);
-        pthread_mutex_unlock(&vod_mutex);
+        video_object_detection_subscriber_det_classes_free(det_classes, num_classes);
         return -3;
     }
-    g_ctx.det_info = vod__detector_information__unpack(NULL, size, buffer);
+    VOD__DetectorInformation *det_info = vod__detector_information__unpack(NULL, size, buffer);
     free(buffer);
-    if (!g_ctx.det_info) {
+    if (!det_info) {
         LOG_WARN("%s: Failed to unpack detector information", __func__);
-        pthread_mutex_unlock(&vod_mutex);
+        video_object_detection_subscriber_det_classes_free(det_classes, num_classes);
         return -4;
     }
 
+    int ret = Dictionary_Build(det_classes, num_classes, det_info) < 0 ? -4 : 0;
+    if (ret == 0)
+        g_atomic_int_set(&vod_num_classes, num_classes);
+    vod__detector_information__free_unpacked(det_info, NULL);
+    video_object_detection_subscriber_det_classes_free(det_classes, num_classes);
+    return ret;
+}
 
 
-    if (video_object_detection_subscriber_create(&subscriber, NULL, channel) != 0) {
-        LOG_WARN("%s: Failed to create subscriber", __func__);
+// --- Initialization and shutdown ---
+// Undo a partially initialized channel. Called with vod_mutex held.
+static void release_channel(vod_channel_ctx_t *ctx) {
+    if (ctx->subscriber) {
+        video_object_detection_subscriber_unsubscribe(ctx->subscriber);
+        video_object_detection_subscriber_delete(&ctx->subscriber);
+        ctx->subscriber = NULL;
+    }
+    // The worker takes its channel lock per frame; stop it without holding vod_mutex
+    if (ctx->worker_running) {
         pthread_mutex_unlock(&vod_mutex);
-        return -5;
+        FrameQueue_Stop(&ctx->queue);
+        pthread_join(ctx->worker, NULL);
+        pthread_mutex_lock(&vod_mutex);
+        ctx->worker_running = false;
     }
+    FrameQueue_Free(&ctx->queue);
+    pthread_mutex_lock(&ctx->lock);
+    free_object_map(ctx);
+    pthread_mutex_unlock(&ctx->lock);
+    free_frame_buffer(ctx);
+    pthread_mutex_destroy(&ctx->lock);
+    pthread_mutex_destroy(&ctx->clock_mutex);
+}
 
 
-    if (video_object_detection_subscriber_set_get_detection_callback(subscriber, detection_callback) != 0) {
-        LOG_WARN("%s: Failed to set detection callback", __func__);
+int VOD_Init(int channel, vod_callback_t cb, void *user_data, int predictions) {
+    pthread_mutex_lock(&vod_mutex);
+    LOG_TRACE("%s: Entry\n", __func__);
+    if (!cb) {
+        LOG_WARN("%s: Callback function is NULL", __func__);
         pthread_mutex_unlock(&vod_mutex);
-        return -6;
+        return -1;
+    }
+    if (find_channel(channel)) {
+        LOG_WARN("%s: Channel %d is already subscribed", __func__, channel);
+        pthread_mutex_unlock(&vod_mutex);
+        return -1;
     }
+    if (vod_num_channels == VOD_MAX_CHANNELS) {
+        LOG_WARN("%s: At most %d channels are supported", __func__, VOD_MAX_CHANNELS);
+        pthread_mutex_unlock(&vod_mutex);
+        return -1;
+    }
+    vod_channel_ctx_t *ctx = &vod_channels[vod_num_channels];
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->channel = channel;
+    ctx->cb = cb;
+    ctx->user_data = user_data;
+    ctx->stride = 1;
+    ctx->budget = decimation_budget;
+    if (vod_num_channels == 0)
+        snprintf(ctx->status_group, sizeof(ctx->status_group), "pipeline");
+    else
+        snprintf(ctx->status_group, sizeof(ctx->status_group), "pipeline_%d", channel);
+    pthread_mutex_init(&ctx->lock, NULL);
+    pthread_mutex_init(&ctx->clock_mutex, NULL);
+
+
+    // The detector, and so the dictionary, is shared by all channels
+    if (vod_num_channels == 0) {
+        int major,minor;
+        if (video_object_detection_subscriber_get_version(&major,&minor) != VIDEO_OBJECT_DETECTION_SUBSCRIBER_SUCCESS) {
+            LOG_WARN("%s: No version detected", __func__);
+        }
+        LOG("%s: Version = %d.%d\n",__func__,major,minor);
 
 
-    if (video_object_detection_subscriber_set_receive_empty_hits(subscriber, detection_callback) != 0) {
-        LOG_WARN("%s: Failed to set empty hits", __func__);
+        vod_predictions = predictions;
+        if (vod_predictions)
+            LOG("Predicted positions enabled");
+        
+        int ret = load_dictionary();
+        if (ret != 0) {
+            release_channel(ctx);
+            pthread_mutex_unlock(&vod_mutex);
+            return ret;
+        }
+    }
+
+
+    if (!FrameQueue_Init(&ctx->queue, queue_depth, queue_policy)) {
+        LOG_WARN("%s: Failed to allocate frame queue", __func__);
+        release_channel(ctx);
+        pthread_mutex_unlock(&vod_mutex);
+        return -9;
+    }
+    if (pthread_create(&ctx->worker, NULL, vod_worker, ctx) != 0) {
+        LOG_WARN("%s: Failed to start processing thread", __func__);
+        release_channel(ctx);
         pthread_mutex_unlock(&vod_mutex);
-        return -7;
+        return -9;
     }
+    ctx->worker_running = true;
+    LOG("VOD frame queue channel %d: depth %u, overflow %s\n", channel, ctx->queue.depth,
+        queue_policy == FRAME_QUEUE_COALESCE ? "coalesce" : "drop-oldest");
 
 
-    
-    if (video_object_detection_subscriber_subscribe(subscriber) != 0) {
+    int ret = 0;
+    if (video_object_detection_subscriber_create(&ctx->subscriber, ctx, channel) != 0) {
+        LOG_WARN("%s: Failed to create subscriber", __func__);
+        ret = -5;
+    } else if (video_object_detection_subscriber_set_get_detection_callback(ctx->subscriber, detection_callback) != 0) {
+        LOG_WARN("%s: Failed to set detection callback", __func__);
+        ret = -6;
+    } else if (video_object_detection_subscriber_set_receive_empty_hits(ctx->subscriber, detection_callback) != 0) {
+        LOG_WARN("%s: Failed to set empty hits", __func__);
+        ret = -7;
+    } else if (video_object_detection_subscriber_subscribe(ctx->subscriber) != 0) {
         LOG_WARN("%s: Failed to subscribe to detection service", __func__);
+        ret = -8;
+    }
+    if (ret != 0) {
+        release_channel(ctx);
         pthread_mutex_unlock(&vod_mutex);
-        return -8;
+        return ret;
     }
+    vod_num_channels++;
     
     // Initialize watchdog
-    last_detection_time = g_get_real_time() / 1000000.0;
-    consecutive_timeouts = 0;
-    recovery_in_progress = false;
+    g_atomic_int_set(&ctx->last_detection_time, now_seconds());
+    ctx->consecutive_timeouts = 0;
+    ctx->recovery_in_progress = false;
     
     if (watchdog_timer_id == 0) {
         watchdog_timer_id = g_timeout_add_seconds(5, vod_watchdog_timer, NULL);
         LOG("VOD watchdog timer started (timeout: %.0f seconds, max retries: %d)", 
             DETECTION_TIMEOUT_SECONDS, MAX_CONSECUTIVE_TIMEOUTS);
     }
+    if (status_timer_id == 0)
+        status_timer_id = g_timeout_add_seconds(2, vod_status_timer, NULL);
     
     LOG("Object detection successful on channel %d", channel);
     pthread_mutex_unlock(&vod_mutex);
@@ -768,26 +1240,18 @@ void VOD_Shutdown(void) {
         LOG("VOD watchdog timer stopped");
     }
     
-    // Reset watchdog state
-    last_detection_time = 0;
-    consecutive_timeouts = 0;
-    recovery_in_progress = false;
-    
-    if (subscriber) {
-        video_object_detection_subscriber_unsubscribe(subscriber);
-        video_object_detection_subscriber_delete(&subscriber);
-        subscriber = NULL;
+    if (status_timer_id != 0) {
+        g_source_remove(status_timer_id);
+        status_timer_id = 0;
     }
-    if (g_ctx.det_classes) {
-        video_object_detection_subscriber_det_classes_free(g_ctx.det_classes, g_ctx.num_classes);
-        g_ctx.det_classes = NULL;
-        g_ctx.num_classes = 0;
-    }
-    if (g_ctx.det_info) {
-        vod__detector_information__free_unpacked(g_ctx.det_info, NULL);
-        g_ctx.det_info = NULL;
-    }
-    clear_object_map();
+    
+    int channels = vod_num_channels;
+    vod_num_channels = 0;
+    for (int i = 0; i < channels; ++i)
+        release_channel(&vod_channels[i]);
+
+    g_atomic_int_set(&vod_num_classes, 0);
+    Dictionary_Clear();
     closelog();
     LOG("VOD_Shutdown completed\n");
     pthread_mutex_unlock(&vod_mutex);
@@ -797,20 +1261,23 @@ void VOD_Shutdown(void) {
 void VOD_Reset(void) {
     pthread_mutex_lock(&vod_mutex);
     LOG("VOD cache reset\n");
-    clear_object_map();
-    if (g_ctx.det_classes) {
-        video_object_detection_subscriber_det_classes_free(g_ctx.det_classes, g_ctx.num_classes);
-        g_ctx.det_classes = NULL;
-        g_ctx.num_classes = 0;
-    }
-    if (g_ctx.det_info) {
-        vod__detector_information__free_unpacked(g_ctx.det_info, NULL);
-        g_ctx.det_info = NULL;
+    // Hold every channel lock so no frame is processed while the
+    // dictionary is rebuilt
+    for (int i = 0; i < vod_num_channels; ++i) {
+        pthread_mutex_lock(&vod_channels[i].lock);
+        clear_object_map(&vod_channels[i]);
     }
+    // Detector may have been reconfigured; refresh the class/attribute codes
+    if (load_dictionary() != 0)
+        LOG_WARN("VOD_Reset: Dictionary rebuild failed\n");
     
     // Reset watchdog state
-    consecutive_timeouts = 0;
-    last_detection_time = g_get_real_time() / 1000000.0;
+    for (int i = 0; i < vod_num_channels; ++i) {
+        vod_channel_ctx_t *ctx = &vod_channels[i];
+        ctx->consecutive_timeouts = 0;
+        g_atomic_int_set(&ctx->last_detection_time, now_seconds());
+        pthread_mutex_unlock(&ctx->lock);
+    }
     
     LOG("VOD_Reset: All caches cleared\n");
     pthread_mutex_unlock(&vod_mutex);
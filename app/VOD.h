@@ -3,33 +3,51 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include "cJSON.h"
+#include "Dictionary.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+#define VOD_MAX_CHANNELS 4     // Channels that can be subscribed at the same time
+
 typedef struct {
-    char *name;   // Attribute type name
-    char *value;  // Attribute value (class name)
+    dict_code_t type;   // Attribute type name
+    dict_code_t value;  // Attribute value (class name)
 } vod_attribute_t;
 
 typedef struct {
-    char id[32];        // String version of unique id
+    uint32_t id;        // Unique tracker id
     float confidence;   // Maximum class score during tracking
     int type;           // Class type (id) of maximum confidence
-    char class_name[64];// Class name of the type
+    dict_code_t class_code; // Class name of the type
     int x, y, w, h;     // [0..1000] coordinates, top-left origo
-    vod_attribute_t *attributes; // Array of attributes (type/value pairs)
+    const vod_attribute_t *attributes; // Attributes (type/value pairs), points into the frame
     size_t num_attributes;
     bool active;        // True if tracked, false if deleted
 } vod_object_t;
 
-// Callback signature: called with list of current objects
-typedef void (*vod_callback_t)(const vod_object_t *objects, size_t num_objects, void *user_data);
+// All current objects of one detection frame. Owned by VOD and recycled
+// once the callback returns; consumers must copy what they keep.
+typedef struct {
+    int channel;                    // Channel the frame was detected on
+    uint32_t sequence;              // Frame sequence number
+    double timestamp;               // Frame time, epoch ms (see VOD_Time)
+    const vod_object_t *objects;
+    size_t num_objects;
+} vod_frame_t;
+
+// Callback signature: called with the current frame, or with NULL on
+// VOD_Wake
+typedef void (*vod_callback_t)(const vod_frame_t *frame, void *user_data);
 
 /**
- * Initialize the VOD object detection wrapper.
+ * Subscribe to a channel. Call once per channel, up to VOD_MAX_CHANNELS;
+ * each channel gets its own queue and processing thread, so callbacks for
+ * different channels run concurrently. The first channel is the primary:
+ * it is the one recorded and keeps the plain "pipeline" status group.
  * @param channel    Channel to subscribe to.
  * @param cb         Callback to receive detected objects.
  * @param user_data  User pointer passed to callback.
@@ -38,8 +56,65 @@ typedef void (*vod_callback_t)(const vod_object_t *objects, size_t num_objects,
 int VOD_Init(int channel, vod_callback_t cb, void *user_data, int predictions);
 cJSON*	VOD_Detector_Information();
 cJSON*	VOD_Label_List();
+
+/**
+ * Describe the running detector for the scene recorder.
+ * @param info       Receives the raw DetectorInformation protobuf; caller frees it.
+ * @param info_size  Receives its size.
+ * @return {channel, predictions, classes:[{id,name}]}, caller deletes; NULL if unavailable.
+ */
+cJSON*	VOD_Scene_Description(uint8_t **info, size_t *info_size);
 void	VOD_Reset();
 
+/**
+ * Configure the queue between the subscriber and the processing thread.
+ * Must be called before VOD_Init.
+ * @param depth     Frames that may wait for processing.
+ * @param overflow  "drop-oldest" or "coalesce" (skip to the latest frame).
+ */
+void	VOD_Queue_Config(int depth, const char *overflow);
+
+/**
+ * Configure load-aware decimation. Frames that only move known objects
+ * are thinned so processing stays within the budget; frames with births,
+ * deletions or expiries are always delivered. Must be called before VOD_Init.
+ * @param budget     Processing time per channel, percent of one core.
+ * @param cpu_limit  Device load per core, percent, above which the budget shrinks.
+ * @param max_stride Deliver at least every max_stride-th frame; 1 disables decimation.
+ */
+void	VOD_Decimation_Config(int budget, int cpu_limit, int max_stride);
+
+/**
+ * Expire objects the detector stops reporting without deleting them.
+ * Must be called before VOD_Init.
+ * @param missing_frames Input frame intervals an object may be missing;
+ *                       0 (default) keeps objects until they are deleted.
+ */
+void	VOD_Expiry_Config(int missing_frames);
+
+// Frames received but not yet processed, dropped or coalesced, all channels
+int	VOD_Backlog(void);
+
+/**
+ * Pipeline clock in epoch ms, derived from Scene.timestamp.
+ * While a frame callback runs this is exactly that frame's time, so all
+ * ages, idle times and path times of a frame share one value. Elsewhere
+ * it is the latest frame time advanced by the monotonic time since.
+ * Falls back to the device clock before the first frame. Outside a
+ * callback this is the clock of the primary channel.
+ */
+double	VOD_Time(void);
+
+// Pipeline clock of a channel; VOD_Time if the channel is not subscribed
+double	VOD_Channel_Time(int channel);
+
+/**
+ * Call the channel's callback with a NULL frame on its processing thread,
+ * between frames. Wakes made before the callback runs are merged into one.
+ * Lets the consumer keep per-channel state private to that thread.
+ */
+void	VOD_Wake(int channel);
+
 /**
  * Shutdown and free all resources.
  */
@@ -0,0 +1,218 @@
+/*------------------------------------------------------------------
+ *  Zone.c
+ *  Fred Juhlin (2025)
+ *------------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <glib.h>
+#include "Zone.h"
+
+#define ZONE_CELL  (1000 / ZONE_GRID)  // View units per cell
+#define CELL_EDGE  255                  // Crossed by an edge; test exactly
+
+typedef struct {
+    int x1, y1, x2, y2;         // Rectangle, or the bounds of the polygon
+    int num_points;             // 0 for a rectangle
+    int *x, *y;
+} zone_t;
+
+struct zone_set {
+    volatile gint refs;
+    bool inclusive;
+    int num_zones;
+    zone_t *zones;
+    uint8_t cells[ZONE_GRID * ZONE_GRID];   // 0 = none, else first zone + 1
+};
+
+static bool on_segment(int x, int y, int ax, int ay, int bx, int by) {
+    if ((int64_t)(bx - ax) * (y - ay) != (int64_t)(by - ay) * (x - ax))
+        return false;
+    return x >= MIN(ax, bx) && x <= MAX(ax, bx) && y >= MIN(ay, by) && y <= MAX(ay, by);
+}
+
+static bool zone_test(const zone_t *zone, bool inclusive, int x, int y) {
+    if (inclusive) {
+        if (x < zone->x1 || x > zone->x2 || y < zone->y1 || y > zone->y2)
+            return false;
+    } else if (x <= zone->x1 || x >= zone->x2 || y <= zone->y1 || y >= zone->y2) {
+        return false;
+    }
+    if (!zone->num_points)
+        return true;
+
+    // Border points first, then even-odd crossings
+    bool inside = false;
+    for (int i = 0, j = zone->num_points - 1; i < zone->num_points; j = i++) {
+        int ax = zone->x[j], ay = zone->y[j], bx = zone->x[i], by = zone->y[i];
+        if (on_segment(x, y, ax, ay, bx, by))
+            return inclusive;
+        if ((ay > y) != (by > y)) {
+            double cross = ax + (double)(y - ay) * (bx - ax) / (by - ay);
+            if (x < cross)
+                inside = !inside;
+        }
+    }
+    return inside;
+}
+
+static int find_exact(const zone_set_t *set, int x, int y) {
+    for (int i = 0; i < set->num_zones; ++i)
+        if (zone_test(&set->zones[i], set->inclusive, x, y))
+            return i;
+    return ZONE_NONE;
+}
+
+static inline int cell_index(double v) {
+    int cell = (int)floor(v / ZONE_CELL);
+    return cell < 0 ? 0 : (cell >= ZONE_GRID ? ZONE_GRID - 1 : cell);
+}
+
+// Mark every cell within one view unit of the segment. Samples are at
+// most one unit apart on each axis, so none of those cells is missed.
+static void mark_segment(uint8_t *cells, double ax, double ay, double bx, double by) {
+    int steps = (int)ceil(MAX(fabs(bx - ax), fabs(by - ay))) + 1;
+    for (int i = 0; i <= steps; ++i) {
+        double x = ax + (bx - ax) * i / steps;
+        double y = ay + (by - ay) * i / steps;
+        for (int dy = -1; dy <= 1; dy += 2)
+            for (int dx = -1; dx <= 1; dx += 2)
+                cells[cell_index(y + dy) * ZONE_GRID + cell_index(x + dx)] = CELL_EDGE;
+    }
+}
+
+static void mark_edges(uint8_t *cells, const zone_t *zone) {
+    if (!zone->num_points) {
+        mark_segment(cells, zone->x1, zone->y1, zone->x2, zone->y1);
+        mark_segment(cells, zone->x2, zone->y1, zone->x2, zone->y2);
+        mark_segment(cells, zone->x2, zone->y2, zone->x1, zone->y2);
+        mark_segment(cells, zone->x1, zone->y2, zone->x1, zone->y1);
+        return;
+    }
+    for (int i = 0, j = zone->num_points - 1; i < zone->num_points; j = i++)
+        mark_segment(cells, zone->x[j], zone->y[j], zone->x[i], zone->y[i]);
+}
+
+static int number(const cJSON *item, const char *name, int fallback) {
+    const cJSON *value = cJSON_GetObjectItem(item, name);
+    return cJSON_IsNumber(value) ? value->valueint : fallback;
+}
+
+static bool parse_zone(const cJSON *item, const zone_rect_t *defaults, zone_t *zone) {
+    memset(zone, 0, sizeof(*zone));
+    if (!cJSON_IsObject(item))
+        return false;
+    const cJSON *polygon = cJSON_GetObjectItem(item, "polygon");
+    if (!cJSON_IsArray(polygon)) {
+        zone->x1 = number(item, "x1", defaults->x1);
+        zone->y1 = number(item, "y1", defaults->y1);
+        zone->x2 = number(item, "x2", defaults->x2);
+        zone->y2 = number(item, "y2", defaults->y2);
+        return true;
+    }
+
+    int size = cJSON_GetArraySize(polygon);
+    zone->x = malloc(size * sizeof(int));
+    zone->y = malloc(size * sizeof(int));
+    if (!zone->x || !zone->y)
+        return false;
+    const cJSON *point;
+    cJSON_ArrayForEach(point, polygon) {
+        if (!cJSON_IsNumber(cJSON_GetObjectItem(point, "x")) || !cJSON_IsNumber(cJSON_GetObjectItem(point, "y")))
+            continue;
+        int x = number(point, "x", 0), y = number(point, "y", 0);
+        if (!zone->num_points || x < zone->x1) zone->x1 = x;
+        if (!zone->num_points || x > zone->x2) zone->x2 = x;
+        if (!zone->num_points || y < zone->y1) zone->y1 = y;
+        if (!zone->num_points || y > zone->y2) zone->y2 = y;
+        zone->x[zone->num_points] = x;
+        zone->y[zone->num_points] = y;
+        zone->num_points++;
+    }
+    return zone->num_points >= 3;
+}
+
+static void free_zone(zone_t *zone) {
+    free(zone->x);
+    free(zone->y);
+}
+
+static void free_set(zone_set_t *set) {
+    for (int i = 0; i < set->num_zones; ++i)
+        free_zone(&set->zones[i]);
+    free(set->zones);
+    free(set);
+}
+
+zone_set_t* Zone_Compile(const cJSON *zones, bool inclusive, zone_rect_t defaults) {
+    int count = cJSON_IsArray(zones) ? cJSON_GetArraySize(zones) : (cJSON_IsObject(zones) ? 1 : 0);
+    if (count > ZONE_MAX) count = ZONE_MAX;
+    if (!count)
+        return NULL;
+    zone_set_t *set = calloc(1, sizeof(zone_set_t));
+    if (!set)
+        return NULL;
+    set->refs = 1;
+    set->inclusive = inclusive;
+    set->zones = calloc(count, sizeof(zone_t));
+    if (!set->zones) {
+        free(set);
+        return NULL;
+    }
+
+    const cJSON *item = cJSON_IsArray(zones) ? zones->child : zones;
+    for (; item && set->num_zones < count; item = cJSON_IsArray(zones) ? item->next : NULL) {
+        zone_t *zone = &set->zones[set->num_zones];
+        if (parse_zone(item, &defaults, zone))
+            set->num_zones++;
+        else
+            free_zone(zone);
+    }
+    if (!set->num_zones) {
+        free_set(set);
+        return NULL;
+    }
+
+    // Edges first; every other cell lies wholly inside or outside each
+    // zone, so its center decides for all of its points
+    for (int i = 0; i < set->num_zones; ++i)
+        mark_edges(set->cells, &set->zones[i]);
+    for (int cy = 0; cy < ZONE_GRID; ++cy) {
+        for (int cx = 0; cx < ZONE_GRID; ++cx) {
+            uint8_t *cell = &set->cells[cy * ZONE_GRID + cx];
+            if (*cell == CELL_EDGE)
+                continue;
+            int zone = find_exact(set, cx * ZONE_CELL + ZONE_CELL / 2, cy * ZONE_CELL + ZONE_CELL / 2);
+            *cell = (uint8_t)(zone + 1);
+        }
+    }
+    return set;
+}
+
+zone_set_t* Zone_Ref(zone_set_t *set) {
+    if (set)
+        g_atomic_int_inc(&set->refs);
+    return set;
+}
+
+void Zone_Unref(zone_set_t *set) {
+    if (set && g_atomic_int_dec_and_test(&set->refs))
+        free_set(set);
+}
+
+int Zone_Find(const zone_set_t *set, int x, int y) {
+    if (!set)
+        return ZONE_NONE;
+    if (x < 0 || y < 0 || x >= ZONE_GRID * ZONE_CELL || y >= ZONE_GRID * ZONE_CELL)
+        return find_exact(set, x, y);
+    uint8_t cell = set->cells[(y / ZONE_CELL) * ZONE_GRID + x / ZONE_CELL];
+    if (cell == CELL_EDGE)
+        return find_exact(set, x, y);
+    return (int)cell - 1;
+}
+
+int Zone_Count(const zone_set_t *set) {
+    return set ? set->num_zones : 0;
+}
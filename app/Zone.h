@@ -0,0 +1,67 @@
+/*------------------------------------------------------------------
+ *  Zone.h
+ *  Areas of the [0..1000] view space: the area of interest, cut-off,
+ *  stitch and anomaly areas. A zone is a rectangle {x1,y1,x2,y2} or a
+ *  polygon {"polygon":[{"x":..,"y":..},...]}; a setting holds one zone
+ *  or an array of them.
+ *
+ *  A zone set is compiled once per settings change into a raster of
+ *  ZONE_GRID x ZONE_GRID cells holding the first zone that covers each
+ *  cell. Cells crossed by a zone edge are marked and tested exactly, so
+ *  a lookup is one raster read for nearly every point and never differs
+ *  from testing each zone.
+ *
+ *  A compiled set is immutable and may be read from any thread. Holders
+ *  share it by reference.
+ *
+ *  Fred Juhlin (2025)
+ *------------------------------------------------------------------*/
+
+#ifndef ZONE_H
+#define ZONE_H
+
+#include <stdbool.h>
+#include "cJSON.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ZONE_GRID   250     // Cells per axis, 4 x 4 view units each
+#define ZONE_MAX    254     // Zones per set
+#define ZONE_NONE   -1
+
+typedef struct zone_set zone_set_t;
+
+// Corners a rectangle zone takes for a missing x1, y1, x2 or y2
+typedef struct {
+    int x1, y1, x2, y2;
+} zone_rect_t;
+
+#define ZONE_VIEW ((zone_rect_t){ 0, 0, 1000, 1000 })
+
+/**
+ * Compile a zone setting.
+ * @param zones      A zone object or an array of zones.
+ * @param inclusive  Whether points on a zone's border are inside it.
+ * @param defaults   Corners for those a rectangle does not set.
+ * @return The set with one reference, NULL if it has no zones or on
+ *         allocation failure.
+ */
+zone_set_t* Zone_Compile(const cJSON *zones, bool inclusive, zone_rect_t defaults);
+zone_set_t* Zone_Ref(zone_set_t *set);
+void        Zone_Unref(zone_set_t *set);
+
+// Index of the first zone containing the point, ZONE_NONE if none
+int         Zone_Find(const zone_set_t *set, int x, int y);
+int         Zone_Count(const zone_set_t *set);
+
+static inline bool Zone_Contains(const zone_set_t *set, int x, int y) {
+    return Zone_Find(set, x, y) != ZONE_NONE;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ZONE_H
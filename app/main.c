@@ -32,6 +32,9 @@
 #include "ObjectDetection.h"
 #include "GeoSpace.h"
 #include "Stitch.h"
+#include "Recorder.h"
+#include "TimerWheel.h"
+#include "Zone.h"
 // VOD.h removed - label list sourced from ObjectDetection_Labels()
 
 #define APP_PACKAGE "DataQ"
@@ -44,7 +47,6 @@
 cJSON* activeTrackers = 0;
 cJSON* PreviousPosition = 0;
 cJSON* lastPublishedTracker = 0;
-cJSON* PathCache = 0;
 cJSON* occupancyDetectionCounter = 0;
 cJSON* classCounterArrays = 0;
 cJSON* previousOccupancy = 0;
@@ -56,10 +58,15 @@ int publishTracker = 1;
 int publishPath = 1;
 int publishOccupancy = 0;
 int publishStatus = 1;
+// detections topic: full list every cycle (default), or deltas between keyframes
+int detectionsDelta = 0;
+double detectionsKeyframe = 10000;  // ms between keyframes, 0 = only on request
+int detectionsThreshold = 10;       // Box change in view units that makes an update
+double detectionsInterval = 0;      // ms between messages, 0 = every frame
 int publishGeospace = 0;
 int publishImage = 0;
 int mqttConnected = 0;
-static guint image_noon_timer_id = 0;
+static timer_id_t image_noon_timer_id = 0;
 int shouldReset = 0;
 
 #define MAX_OCCUPANCY_HISTORY 64  // Adjust if your max burst rate is super high
@@ -69,44 +76,85 @@ typedef struct {
     cJSON* counter;   ///< cJSON object: { "Human":3, "Car":5, ... }
 } OccupancySample;
 
-OccupancySample occupancy_history[MAX_OCCUPANCY_HISTORY];
-int occupancy_history_start = 0;
-int occupancy_history_count = 0;
+// Box of an object as last published in delta mode
+typedef struct {
+    int x, y, w, h;
+    unsigned seen;      // Sequence number of the last message that had the object
+} DetectionBox;
+
+// Path, occupancy and detection state of one channel. Channels are
+// processed on their own threads and share none of it.
+typedef struct {
+    int ready;
+    int channel;
+    char topic[16];     // Topic suffix: "" for the primary channel, "/<channel>" otherwise
+    char status[16];    // Status group suffix: "" or "_<channel>"
+    cJSON* PathCache;
+    OccupancySample occupancy_history[MAX_OCCUPANCY_HISTORY];
+    int occupancy_history_start;
+    int occupancy_history_count;
+    cJSON* last_occupancy;
+    int detections_was_empty;
+    GHashTable* detections_sent;        // Delta mode: id -> DetectionBox
+    unsigned detections_seq;
+    double detections_keyframe;         // Time of the last keyframe
+    int detections_keyframe_request;    // Set from other threads
+    double detections_next;             // Rate limit: earliest time of the next message
+    cJSON* detections_deaths;           // Ended objects from frames that were not published
+} ChannelState;
+
+static ChannelState channel_states[OBJECTDETECTION_MAX_CHANNELS];
+
+static ChannelState* Channel_State(int channel) {
+    int index = ObjectDetection_Channel_Index(channel);
+    if (index < 0)
+        index = 0;
+    ChannelState* state = &channel_states[index];
+    if (!state->ready) {
+        state->channel = channel;
+        if (index == 0) {
+            state->topic[0] = 0;
+            state->status[0] = 0;
+        } else {
+            snprintf(state->topic, sizeof(state->topic), "/%d", channel);
+            snprintf(state->status, sizeof(state->status), "_%d", channel);
+        }
+        state->ready = 1;
+    }
+    return state;
+}
+
+static const char* Channel_Group(ChannelState* state, const char* group, char* buffer, size_t size) {
+    snprintf(buffer, size, "%s%s", group, state->status);
+    return buffer;
+}
 
 
-cJSON* ProcessPaths(cJSON* tracker) {
-    if (!PathCache)
-        PathCache = cJSON_CreateObject();
+cJSON* ProcessPaths(ChannelState* state, const tracker_event_t* tracker) {
+    if (!state->PathCache)
+        state->PathCache = cJSON_CreateObject();
+    cJSON* PathCache = state->PathCache;
     
-    const char* id = cJSON_GetObjectItem(tracker, "id") ? 
-                     cJSON_GetObjectItem(tracker, "id")->valuestring : 0;
-    if (!id) return 0;
+    const char* id = tracker->id;
+    if (!id[0]) return 0;
 
-    const char* class = cJSON_GetObjectItem(tracker, "class") ? 
-                        cJSON_GetObjectItem(tracker, "class")->valuestring : 0;
-    if (!class) return 0;
+    const char* class = tracker->label;
+    if (!class || !class[0]) return 0;
 
-    int active = cJSON_GetObjectItem(tracker, "active") ? 
-                 cJSON_GetObjectItem(tracker, "active")->type == cJSON_True : 0;
+    int active = tracker->active;
 
-    int confidence = cJSON_GetObjectItem(tracker, "confidence") ? 
-                     cJSON_GetObjectItem(tracker, "confidence")->valueint : 0;
+    int confidence = tracker->confidence;
     if (!confidence) return 0;
 
-    double age = cJSON_GetObjectItem(tracker, "age") ? 
-                 cJSON_GetObjectItem(tracker, "age")->valuedouble : 0;
+    double age = tracker->age;
     if (!age) return 0;
 
-    double distance = cJSON_GetObjectItem(tracker, "distance") ? 
-                      cJSON_GetObjectItem(tracker, "distance")->valuedouble : 0;
+    double distance = tracker->distance;
     if (!distance) return 0;
 
-    // Get timestamps from tracker (passed from ObjectDetection.c)
-    double currentTimestamp = cJSON_GetObjectItem(tracker, "timestamp") ? 
-                              cJSON_GetObjectItem(tracker, "timestamp")->valuedouble : 0;
-    
-    double previousTimestamp = cJSON_GetObjectItem(tracker, "previousTimestamp") ? 
-                               cJSON_GetObjectItem(tracker, "previousTimestamp")->valuedouble : currentTimestamp;
+    // Timestamps of this and the previous position update
+    double currentTimestamp = tracker->timestamp;
+    double previousTimestamp = tracker->previousTimestamp;
 
     cJSON* path = cJSON_GetObjectItem(PathCache, id);
     
@@ -120,43 +168,33 @@ cJSON* ProcessPaths(cJSON* tracker) {
         cJSON_AddNumberToObject(path, "age", age);
         cJSON_AddNumberToObject(path, "distance", distance);
         
-        if (cJSON_GetObjectItem(tracker, "color"))
-            cJSON_AddStringToObject(path, "color", cJSON_GetObjectItem(tracker, "color")->valuestring);
-        if (cJSON_GetObjectItem(tracker, "color2"))
-            cJSON_AddStringToObject(path, "color2", cJSON_GetObjectItem(tracker, "color2")->valuestring);
-        
-        cJSON* dxItem = cJSON_GetObjectItem(tracker, "dx");
-        cJSON* dyItem = cJSON_GetObjectItem(tracker, "dy");
-        cJSON* bxItem = cJSON_GetObjectItem(tracker, "bx");
-        cJSON* byItem = cJSON_GetObjectItem(tracker, "by");
+        if (tracker->color)
+            cJSON_AddStringToObject(path, "color", tracker->color);
+        if (tracker->color2)
+            cJSON_AddStringToObject(path, "color2", tracker->color2);
         
-        cJSON_AddNumberToObject(path, "dx", dxItem ? dxItem->valuedouble : 0);
-        cJSON_AddNumberToObject(path, "dy", dyItem ? dyItem->valuedouble : 0);
-        cJSON_AddNumberToObject(path, "bx", bxItem ? bxItem->valuedouble : 0);
-        cJSON_AddNumberToObject(path, "by", byItem ? byItem->valuedouble : 0);
+        cJSON_AddNumberToObject(path, "dx", tracker->dx);
+        cJSON_AddNumberToObject(path, "dy", tracker->dy);
+        cJSON_AddNumberToObject(path, "bx", tracker->bx);
+        cJSON_AddNumberToObject(path, "by", tracker->by);
         
-        double birthTime = cJSON_GetObjectItem(tracker, "birth") ?
-                          cJSON_GetObjectItem(tracker, "birth")->valuedouble : currentTimestamp;
+        double birthTime = tracker->birth ? tracker->birth : currentTimestamp;
         cJSON_AddNumberToObject(path, "timestamp", birthTime);
         cJSON_AddNumberToObject(path, "dwell", 0);
         cJSON_AddStringToObject(path, "id", id);
 
-        cJSON* face = cJSON_GetObjectItem(tracker, "face");
-        if (face) cJSON_AddBoolToObject(path, "face", cJSON_IsTrue(face));
-        cJSON* hat = cJSON_GetObjectItem(tracker, "hat");
-        if (hat) cJSON_AddStringToObject(path, "hat", hat->valuestring);
+        if (tracker->face >= 0) cJSON_AddBoolToObject(path, "face", tracker->face);
+        if (tracker->hat) cJSON_AddStringToObject(path, "hat", tracker->hat);
 
         double blat = 0, blon = 0;
-        int geo_success_birth = 0;
-        if (bxItem && byItem)
-            geo_success_birth = GeoSpace_transform(bxItem->valueint, byItem->valueint, &blat, &blon);
+        int geo_success_birth = GeoSpace_transform(tracker->bx, tracker->by, &blat, &blon);
 
         cJSON* pathArr = cJSON_CreateArray();
         
         // Position 0: Birth position (bx, by)
         cJSON* pos1 = cJSON_CreateObject();
-        cJSON_AddNumberToObject(pos1, "x", bxItem ? bxItem->valuedouble : 0);
-        cJSON_AddNumberToObject(pos1, "y", byItem ? byItem->valuedouble : 0);
+        cJSON_AddNumberToObject(pos1, "x", tracker->bx);
+        cJSON_AddNumberToObject(pos1, "y", tracker->by);
         cJSON_AddNumberToObject(pos1, "d", 0);  // Will be updated on first tracker update
         cJSON_AddNumberToObject(pos1, "t", birthTime / 1000.0);  // Epoch seconds for stitch matching
         if (geo_success_birth) {
@@ -166,14 +204,11 @@ cJSON* ProcessPaths(cJSON* tracker) {
         cJSON_AddItemToArray(pathArr, pos1);
 
         // Position 1: Current position (cx, cy)
-        cJSON* cxNew = cJSON_GetObjectItem(tracker, "cx");
-        cJSON* cyNew = cJSON_GetObjectItem(tracker, "cy");
-        if (!cxNew || !cyNew) return 0;
         double clat = 0, clon = 0;
-        int geo_success_current = GeoSpace_transform(cxNew->valueint, cyNew->valueint, &clat, &clon);
+        int geo_success_current = GeoSpace_transform(tracker->cx, tracker->cy, &clat, &clon);
         cJSON* pos2 = cJSON_CreateObject();
-        cJSON_AddNumberToObject(pos2, "x", cxNew->valuedouble);
-        cJSON_AddNumberToObject(pos2, "y", cyNew->valuedouble);
+        cJSON_AddNumberToObject(pos2, "x", tracker->cx);
+        cJSON_AddNumberToObject(pos2, "y", tracker->cy);
         cJSON_AddNumberToObject(pos2, "d", 0);  // Will be updated on next tracker update
         cJSON_AddNumberToObject(pos2, "t", currentTimestamp / 1000.0);  // Epoch seconds for stitch matching
         if (geo_success_current) {
@@ -194,23 +229,21 @@ cJSON* ProcessPaths(cJSON* tracker) {
         // ============================================================
         // UPDATE EXISTING PATH - Tracker still active
         // ============================================================
-        cJSON_ReplaceItemInObject(path, "class", cJSON_Duplicate(cJSON_GetObjectItem(tracker, "class"), 1));
-        cJSON_ReplaceItemInObject(path, "confidence", cJSON_Duplicate(cJSON_GetObjectItem(tracker, "confidence"), 1));
-        cJSON_ReplaceItemInObject(path, "age", cJSON_Duplicate(cJSON_GetObjectItem(tracker, "age"), 1));
-        cJSON_ReplaceItemInObject(path, "distance", cJSON_Duplicate(cJSON_GetObjectItem(tracker, "distance"), 1));
+        cJSON_ReplaceItemInObject(path, "class", cJSON_CreateString(class));
+        cJSON_ReplaceItemInObject(path, "confidence", cJSON_CreateNumber(confidence));
+        cJSON_ReplaceItemInObject(path, "age", cJSON_CreateNumber(age));
+        cJSON_ReplaceItemInObject(path, "distance", cJSON_CreateNumber(distance));
         
-        if (cJSON_GetObjectItem(tracker, "color"))
-            cJSON_ReplaceItemInObject(path, "color", cJSON_Duplicate(cJSON_GetObjectItem(tracker, "color"), 1));
-        if (cJSON_GetObjectItem(tracker, "color2"))
-            cJSON_ReplaceItemInObject(path, "color2", cJSON_Duplicate(cJSON_GetObjectItem(tracker, "color2"), 1));
+        if (tracker->color)
+            cJSON_ReplaceItemInObject(path, "color", cJSON_CreateString(tracker->color));
+        if (tracker->color2)
+            cJSON_ReplaceItemInObject(path, "color2", cJSON_CreateString(tracker->color2));
         
-        cJSON_ReplaceItemInObject(path, "dx", cJSON_Duplicate(cJSON_GetObjectItem(tracker, "dx"), 1));
-        cJSON_ReplaceItemInObject(path, "dy", cJSON_Duplicate(cJSON_GetObjectItem(tracker, "dy"), 1));
+        cJSON_ReplaceItemInObject(path, "dx", cJSON_CreateNumber(tracker->dx));
+        cJSON_ReplaceItemInObject(path, "dy", cJSON_CreateNumber(tracker->dy));
 
-        cJSON* face = cJSON_GetObjectItem(tracker, "face");
-        if (face) cJSON_ReplaceItemInObject(path, "face", cJSON_Duplicate(face, 1));
-        cJSON* hat = cJSON_GetObjectItem(tracker, "hat");
-        if (hat) cJSON_ReplaceItemInObject(path, "hat", cJSON_Duplicate(hat, 1));
+        if (tracker->face >= 0) cJSON_ReplaceItemInObject(path, "face", cJSON_CreateBool(tracker->face));
+        if (tracker->hat) cJSON_ReplaceItemInObject(path, "hat", cJSON_CreateString(tracker->hat));
 
         cJSON* pathArr = cJSON_GetObjectItem(path, "path");
         int pathLen = cJSON_GetArraySize(pathArr);
@@ -238,14 +271,11 @@ cJSON* ProcessPaths(cJSON* tracker) {
             cJSON_SetNumberValue(dwell_item, maxDwell);
 
         // Add NEW position with d=0 (will be calculated on next update or exit)
-        cJSON* cxUpd = cJSON_GetObjectItem(tracker, "cx");
-        cJSON* cyUpd = cJSON_GetObjectItem(tracker, "cy");
-        if (!cxUpd || !cyUpd) return 0;
         double lat = 0, lon = 0;
-        int geo_success_upd = GeoSpace_transform(cxUpd->valueint, cyUpd->valueint, &lat, &lon);
+        int geo_success_upd = GeoSpace_transform(tracker->cx, tracker->cy, &lat, &lon);
         cJSON* pos = cJSON_CreateObject();
-        cJSON_AddNumberToObject(pos, "x", cxUpd->valuedouble);
-        cJSON_AddNumberToObject(pos, "y", cyUpd->valuedouble);
+        cJSON_AddNumberToObject(pos, "x", tracker->cx);
+        cJSON_AddNumberToObject(pos, "y", tracker->cy);
         cJSON_AddNumberToObject(pos, "d", 0);  // Always 0 for newest position
         cJSON_AddNumberToObject(pos, "t", currentTimestamp / 1000.0);  // Epoch seconds for stitch matching
         if (geo_success_upd) {
@@ -291,12 +321,9 @@ cJSON* ProcessPaths(cJSON* tracker) {
             cJSON_ReplaceItemInObject(path, "distance", cJSON_CreateNumber(distance));
 
             // Update other final metadata
-            cJSON* pathAnomalyItem = cJSON_GetObjectItem(tracker, "anomaly");
-            if (pathAnomalyItem && pathAnomalyItem->valuestring)
-                cJSON_AddStringToObject(path, "anomaly", pathAnomalyItem->valuestring);
-            cJSON* pathMaxSpeedItem = cJSON_GetObjectItem(tracker, "maxSpeed");
-            if (pathMaxSpeedItem)
-                cJSON_AddNumberToObject(path, "maxSpeed", pathMaxSpeedItem->valuedouble);
+            if (tracker->anomaly[0])
+                cJSON_AddStringToObject(path, "anomaly", tracker->anomaly);
+            cJSON_AddNumberToObject(path, "maxSpeed", tracker->maxSpeed);
             // maxIdle is redundant — dwell already holds that value
 
             // NO PreviousTimestamp cache cleanup needed anymore!
@@ -314,36 +341,84 @@ cJSON* ProcessPaths(cJSON* tracker) {
 }
 
 
-static guint anomaly_timeout_id = 0;
+// Anomaly areas of one group, compiled when the anomaly settings change
+typedef struct {
+    zone_set_t* common;         // Entry and exit must be in one of these
+    zone_set_t* restricted;     // Positions must be in one of these
+    int restricted_off;         // First restricted area has distance < 20; matches nothing
+} AnomalyAreas;
+
+static GRWLock anomaly_areas_lock;  // Trackers read the areas from every channel thread
+static AnomalyAreas anomaly_humans = {0};
+static AnomalyAreas anomaly_vehicles = {0};
 
-static gboolean
-Clear_Anomaly(gpointer user_data) {
-    ACAP_EVENTS_Fire_State("anomaly", 0);
-    anomaly_timeout_id = 0; // Reset timeout id
-    return FALSE; // Do not reschedule
+static void
+Anomaly_Compile_Areas(AnomalyAreas* areas, cJSON* group) {
+    cJSON* restricted = cJSON_GetObjectItem(group, "restricted");
+    cJSON* first = restricted ? restricted->child : NULL;
+    cJSON* distance = first ? cJSON_GetObjectItem(first, "distance") : NULL;
+    // Areas are open, as the former per-tracker tests were
+    areas->common = Zone_Compile(cJSON_GetObjectItem(group, "common"), false, ZONE_VIEW);
+    areas->restricted = Zone_Compile(restricted, false, ZONE_VIEW);
+    areas->restricted_off = distance && distance->valueint < 20;
+}
+
+static void
+Anomaly_Settings(cJSON* anomaly) {
+    AnomalyAreas humans = {0}, vehicles = {0};
+    Anomaly_Compile_Areas(&humans, cJSON_GetObjectItem(anomaly, "humans"));
+    Anomaly_Compile_Areas(&vehicles, cJSON_GetObjectItem(anomaly, "vehicles"));
+
+    g_rw_lock_writer_lock(&anomaly_areas_lock);
+    AnomalyAreas previous[2] = { anomaly_humans, anomaly_vehicles };
+    anomaly_humans = humans;
+    anomaly_vehicles = vehicles;
+    g_rw_lock_writer_unlock(&anomaly_areas_lock);
+
+    for (int i = 0; i < 2; i++) {
+        Zone_Unref(previous[i].common);
+        Zone_Unref(previous[i].restricted);
+    }
+}
+
+static timer_id_t anomaly_timeout_id = 0;
+static guint anomaly_sequence = 0;  // Identifies the timeout that may clear
+static GMutex anomaly_mutex;    // Anomalies fire from every channel thread
+
+static void
+Clear_Anomaly(void* user_data) {
+    g_mutex_lock(&anomaly_mutex);
+    // A newer anomaly has replaced this timeout while it was being delivered
+    if (GPOINTER_TO_UINT(user_data) == anomaly_sequence) {
+        ACAP_EVENTS_Fire_State("anomaly", 0);
+        anomaly_timeout_id = 0; // Reset timeout id
+    }
+    g_mutex_unlock(&anomaly_mutex);
 }
 
 void
 Fire_Anomaly() {
+    g_mutex_lock(&anomaly_mutex);
     ACAP_EVENTS_Fire_State("anomaly", 1);
 
     // Cancel any pending timeout
     if (anomaly_timeout_id != 0) {
-        g_source_remove(anomaly_timeout_id);
+        TimerWheel_Main_Cancel(anomaly_timeout_id);
         anomaly_timeout_id = 0;
     }
-    // Set a new 2-second timeout (2000 ms)
-    anomaly_timeout_id = g_timeout_add(4000, Clear_Anomaly, NULL);
+    // Clear the anomaly state after 4 seconds without a new one
+    anomaly_sequence++;
+    anomaly_timeout_id = TimerWheel_Main_Schedule(4000, Clear_Anomaly, GUINT_TO_POINTER(anomaly_sequence));
+    g_mutex_unlock(&anomaly_mutex);
 }
 
 
 void
-Check_Anomaly(cJSON* tracker) {
+Check_Anomaly(ChannelState* state, tracker_event_t* tracker) {
 
     int is_human = 0, is_vehicle = 0;
-    cJSON* classItem = cJSON_GetObjectItem(tracker, "class");
-    if (!classItem || !classItem->valuestring) return;
-    const char* label = classItem->valuestring;
+    const char* label = tracker->label;
+    if (!label) return;
     if (strcmp("Human", label) == 0) is_human = 1;
     // If vehicle-like class
     if (strcmp("Car", label) == 0 || strcmp("Truck", label) == 0 ||
@@ -352,63 +427,17 @@ Check_Anomaly(cJSON* tracker) {
         is_vehicle = 1;
 
     // Save stats
-    cJSON* activeCheck = cJSON_GetObjectItem(tracker, "active");
-    if (activeCheck && activeCheck->type == cJSON_False) {
-        char* group_label = is_human ? "humans" : "vehicles";
-        cJSON* stats;
-
-        stats = ACAP_STATUS_Object(group_label, "directions");
-        if(!stats) stats = cJSON_CreateArray();
-        while( cJSON_GetArraySize(stats) > 200 )
-            cJSON_DeleteItemFromArray(stats, 0);
-        cJSON* dirItem = cJSON_GetObjectItem(tracker, "directions");
-        cJSON_AddItemToArray(stats, cJSON_CreateNumber(dirItem ? dirItem->valueint : 0));
-        ACAP_STATUS_SetObject(group_label, "directions", stats);
-
-        stats = ACAP_STATUS_Object(group_label, "age");
-        if(!stats) stats = cJSON_CreateArray();
-        cJSON* ageStatItem = cJSON_GetObjectItem(tracker, "age");
-        cJSON_AddItemToArray(stats, cJSON_CreateNumber(ageStatItem ? ageStatItem->valuedouble : 0));
-        while( cJSON_GetArraySize(stats) > 200 )
-            cJSON_DeleteItemFromArray(stats, 0);
-        ACAP_STATUS_SetObject(group_label, "age", stats);
-
-        stats = ACAP_STATUS_Object(group_label, "idle");
-        if(!stats) stats = cJSON_CreateArray();
-        cJSON* maxIdleStatItem = cJSON_GetObjectItem(tracker, "maxIdle");
-        cJSON_AddItemToArray(stats, cJSON_CreateNumber(maxIdleStatItem ? maxIdleStatItem->valuedouble : 0));
-        while( cJSON_GetArraySize(stats) > 200 )
-            cJSON_DeleteItemFromArray(stats, 0);
-        ACAP_STATUS_SetObject(group_label, "idle", stats);
-
-        stats = ACAP_STATUS_Object(group_label, "speed");
-        if(!stats) stats = cJSON_CreateArray();
-        cJSON* maxSpeedStatItem = cJSON_GetObjectItem(tracker, "maxSpeed");
-        double speed = maxSpeedStatItem ? maxSpeedStatItem->valuedouble : 0;
-        if (speed > 0) {
-            cJSON_AddItemToArray(stats, cJSON_CreateNumber(speed));
-            while( cJSON_GetArraySize(stats) > 200 )
-                cJSON_DeleteItemFromArray(stats, 0);
-            ACAP_STATUS_SetObject(group_label, "speed", stats);
-        }
-
-        stats = ACAP_STATUS_Object(group_label, "horizontal");
-        if(!stats) stats = cJSON_CreateArray();
-        cJSON* dxStatItem = cJSON_GetObjectItem(tracker, "dx");
-        int dx = dxStatItem ? dxStatItem->valueint : 0;
-        cJSON_AddItemToArray(stats, cJSON_CreateNumber(dx));
-        while( cJSON_GetArraySize(stats) > 200 )
-            cJSON_DeleteItemFromArray(stats, 0);
-        ACAP_STATUS_SetObject(group_label, "horizontal", stats);
-
-        stats = ACAP_STATUS_Object(group_label, "vertical");
-        if(!stats) stats = cJSON_CreateArray();
-        cJSON* dyStatItem = cJSON_GetObjectItem(tracker, "dy");
-        int dy = dyStatItem ? dyStatItem->valueint : 0;
-        cJSON_AddItemToArray(stats, cJSON_CreateNumber(dy));
-        while( cJSON_GetArraySize(stats) > 200 )
-            cJSON_DeleteItemFromArray(stats, 0);
-        ACAP_STATUS_SetObject(group_label, "vertical", stats);
+    if (!tracker->active) {
+        char group_label[32];
+        Channel_Group(state, is_human ? "humans" : "vehicles", group_label, sizeof(group_label));
+        // Runs on the channel's processing thread; append under the status lock
+        ACAP_STATUS_Append(group_label, "directions", cJSON_CreateNumber(tracker->directions), 200);
+        ACAP_STATUS_Append(group_label, "age", cJSON_CreateNumber(tracker->age), 200);
+        ACAP_STATUS_Append(group_label, "idle", cJSON_CreateNumber(tracker->maxIdle), 200);
+        if (tracker->maxSpeed > 0)
+            ACAP_STATUS_Append(group_label, "speed", cJSON_CreateNumber(tracker->maxSpeed), 200);
+        ACAP_STATUS_Append(group_label, "horizontal", cJSON_CreateNumber(tracker->dx), 200);
+        ACAP_STATUS_Append(group_label, "vertical", cJSON_CreateNumber(tracker->dy), 200);
     }
 
 	if(!publishAnomaly) return;
@@ -425,88 +454,41 @@ Check_Anomaly(cJSON* tracker) {
     if (!group) return;
 
 
-    // Extract area arrays for the current group
-    cJSON* common = cJSON_GetObjectItem(group, "common");
-    cJSON* restricted = cJSON_GetObjectItem(group, "restricted");
-
-    cJSON* cxItem_a = cJSON_GetObjectItem(tracker, "cx");
-    cJSON* cyItem_a = cJSON_GetObjectItem(tracker, "cy");
-    cJSON* bxItem_a = cJSON_GetObjectItem(tracker, "bx");
-    cJSON* byItem_a = cJSON_GetObjectItem(tracker, "by");
-    if (!cxItem_a || !cyItem_a || !bxItem_a || !byItem_a) return;
-    int cx = cxItem_a->valueint;
-    int cy = cyItem_a->valueint;
-    int bx = bxItem_a->valueint;
-    int by = byItem_a->valueint;
+    int cx = tracker->cx;
+    int cy = tracker->cy;
+    int bx = tracker->bx;
+    int by = tracker->by;
 
     // AREA VALIDATION
 
-    // Check common entry/exit (use "bx/by" and "cx/cy" as your logic needs, typically both should match one common area)
-    int found_common = 0;
-    if (common && cJSON_GetArraySize(common)) {
-        cJSON* item = common->child;
-        while(item && !found_common) {
-            int x1 = cJSON_GetObjectItem(item,"x1")->valueint;
-            int x2 = cJSON_GetObjectItem(item,"x2")->valueint;
-            int y1 = cJSON_GetObjectItem(item,"y1")->valueint;
-            int y2 = cJSON_GetObjectItem(item,"y2")->valueint;
-            if (bx > x1 && bx < x2 && by > y1 && by < y2) {
-                found_common = 1;
-            }
-            item = item->next;
-        }
-        if (!found_common) {
-            LOG("Invalid entry");
-            Fire_Anomaly();
-            cJSON_AddStringToObject(tracker, "anomaly", "Invalid entry");
-            return;
-        }
+    // Birth and, on the final update, the exit position must both be in a
+    // common area; every position must be in a restricted area
+    g_rw_lock_reader_lock(&anomaly_areas_lock);
+    const AnomalyAreas* areas = is_vehicle ? &anomaly_vehicles : &anomaly_humans;
+    int invalid_entry = areas->common && !Zone_Contains(areas->common, bx, by);
+    int invalid_exit = areas->common && !tracker->active && !Zone_Contains(areas->common, cx, cy);
+    int outside_restricted = areas->restricted &&
+        (areas->restricted_off || !Zone_Contains(areas->restricted, cx, cy));
+    g_rw_lock_reader_unlock(&anomaly_areas_lock);
+
+    if (invalid_entry) {
+        LOG("Invalid entry");
+        Fire_Anomaly();
+        snprintf(tracker->anomaly, sizeof(tracker->anomaly), "Invalid entry");
+        return;
     }
 
-    found_common = 0;
-    cJSON* activeExitCheck = cJSON_GetObjectItem(tracker, "active");
-    if (common && cJSON_GetArraySize(common) && activeExitCheck && activeExitCheck->type == cJSON_False) {
-        cJSON* item = common->child;
-        while(item && !found_common) {
-            int x1 = cJSON_GetObjectItem(item,"x1")->valueint;
-            int x2 = cJSON_GetObjectItem(item,"x2")->valueint;
-            int y1 = cJSON_GetObjectItem(item,"y1")->valueint;
-            int y2 = cJSON_GetObjectItem(item,"y2")->valueint;
-            if (cx > x1 && cx < x2 && cy > y1 && cy < y2) {
-                found_common = 1;
-            }
-            item = item->next;
-        }
-        if (!found_common) {
-            //LOG("Invalid exit");
-            Fire_Anomaly();
-            cJSON_AddStringToObject(tracker, "anomaly", "Invalid exit");
-            return;
-        }
+    if (invalid_exit) {
+        //LOG("Invalid exit");
+        Fire_Anomaly();
+        snprintf(tracker->anomaly, sizeof(tracker->anomaly), "Invalid exit");
+        return;
     }
 
-    // Check restricted area (using "cx/cy" typically)
-    int found_restricted = 0;
-    if (restricted && cJSON_GetArraySize(restricted)) {
-        cJSON* item = restricted->child;
-        cJSON* distCheck = item ? cJSON_GetObjectItem(item, "distance") : NULL;
-        if (distCheck && distCheck->valueint < 20)
-            item = 0;
-        while(item && !found_restricted) {
-            int x1 = cJSON_GetObjectItem(item,"x1")->valueint;
-            int x2 = cJSON_GetObjectItem(item,"x2")->valueint;
-            int y1 = cJSON_GetObjectItem(item,"y1")->valueint;
-            int y2 = cJSON_GetObjectItem(item,"y2")->valueint;
-            if (cx > x1 && cx < x2 && cy > y1 && cy < y2) {
-                found_restricted = 1;
-            }
-            item = item->next;
-        }
-        if (!found_restricted) {
-            Fire_Anomaly();
-            cJSON_AddStringToObject(tracker, "anomaly", "Restricted Area");
-            return;
-        }
+    if (outside_restricted) {
+        Fire_Anomaly();
+        snprintf(tracker->anomaly, sizeof(tracker->anomaly), "Restricted Area");
+        return;
     }
 
     // GET settings block for the group
@@ -515,139 +497,123 @@ Check_Anomaly(cJSON* tracker) {
 	char text[64];
 
     int maxDirections = cJSON_GetObjectItem(normal, "directions") ? cJSON_GetObjectItem(normal, "directions")->valueint : 0;
-	cJSON* directionsItem = cJSON_GetObjectItem(tracker, "directions");
-	int directions = directionsItem ? directionsItem->valueint : 0;
+	int directions = tracker->directions;
     if (maxDirections && directions > maxDirections) {
 		snprintf(text, sizeof(text), "Directions: %d > %d", directions , maxDirections);
 		//LOG("%s",text);
-        cJSON_AddStringToObject(tracker, "anomaly", text);
+        snprintf(tracker->anomaly, sizeof(tracker->anomaly), "%s", text);
         Fire_Anomaly();
         return;
     }
 
     float maxAge = cJSON_GetObjectItem(normal, "age") ? cJSON_GetObjectItem(normal, "age")->valuedouble : 0;
-    cJSON* ageItem = cJSON_GetObjectItem(tracker, "age");
-    float age = ageItem ? ageItem->valuedouble : 0;
+    float age = tracker->age;
     if (maxAge && age > maxAge) {
 		snprintf(text, sizeof(text), "Age: %d>%d", (int)age , (int)maxAge);
 		//LOG("%s",text);		
-        cJSON_AddStringToObject(tracker, "anomaly", text);
+        snprintf(tracker->anomaly, sizeof(tracker->anomaly), "%s", text);
         Fire_Anomaly();
         return;
     }
 
     float maxIdle = cJSON_GetObjectItem(normal, "idle") ? cJSON_GetObjectItem(normal, "idle")->valuedouble : 0;
-    cJSON* idleItem = cJSON_GetObjectItem(tracker, "maxIdle");
-    float idle = idleItem ? idleItem->valuedouble : 0;
+    float idle = tracker->maxIdle;
     if (maxIdle && idle > maxIdle) {
 		snprintf(text, sizeof(text), "Idle: %d>%d", (int)idle , (int)maxIdle);
 		//LOG("%s",text);
-        cJSON_AddStringToObject(tracker, "anomaly", text);
+        snprintf(tracker->anomaly, sizeof(tracker->anomaly), "%s", text);
         Fire_Anomaly();
         return;
     }
 
     float speedLimit = cJSON_GetObjectItem(normal, "maxSpeed") ? cJSON_GetObjectItem(normal, "maxSpeed")->valuedouble : 0;
-    cJSON* maxSpeedItem = cJSON_GetObjectItem(tracker, "maxSpeed");
-    float maxSpeed = maxSpeedItem ? maxSpeedItem->valuedouble : 0;
+    float maxSpeed = tracker->maxSpeed;
     if (speedLimit && maxSpeed > speedLimit) {
 		snprintf(text, sizeof(text), "Speed: %d>%d", (int)maxSpeed , (int)speedLimit);
 		//LOG("%s",text);
-        cJSON_AddStringToObject(tracker, "anomaly", text);
+        snprintf(tracker->anomaly, sizeof(tracker->anomaly), "%s", text);
         Fire_Anomaly();
         return;
     }
 
     // Direction checks (horizontal/vertical)
     char* horizontal = cJSON_GetObjectItem(normal, "horizontal") ? cJSON_GetObjectItem(normal, "horizontal")->valuestring : NULL;
-    int dx = cJSON_GetObjectItem(tracker, "dx") ? cJSON_GetObjectItem(tracker, "dx")->valueint : 0;
+    int dx = tracker->dx;
     if (horizontal && strcmp(horizontal, "Left") == 0 && dx > 0) {
 		//LOG("%s",text);
         Fire_Anomaly();
-        cJSON_AddStringToObject(tracker, "anomaly", "Wrong way");
+        snprintf(tracker->anomaly, sizeof(tracker->anomaly), "Wrong way");
         return;
     }
     if (horizontal && strcmp(horizontal, "Right") == 0 && dx < 0) {
 		//LOG("%s",text);
         Fire_Anomaly();
-        cJSON_AddStringToObject(tracker, "anomaly", "Wrong way");
+        snprintf(tracker->anomaly, sizeof(tracker->anomaly), "Wrong way");
         return;
     }
 
     char* vertical = cJSON_GetObjectItem(normal, "vertical") ? cJSON_GetObjectItem(normal, "vertical")->valuestring : NULL;
-    int dy = cJSON_GetObjectItem(tracker, "dy") ? cJSON_GetObjectItem(tracker, "dy")->valueint : 0;
+    int dy = tracker->dy;
     if (vertical && strcmp(vertical, "Up") == 0 && dy > 0) {
         //LOG("Wrong way: Down");
         Fire_Anomaly();
-        cJSON_AddStringToObject(tracker, "anomaly", "Wrong way");
+        snprintf(tracker->anomaly, sizeof(tracker->anomaly), "Wrong way");
         return;
     }
     if (vertical && strcmp(vertical, "Down") == 0 && dy < 0) {
         //LOG("Wrong way: Up");
         Fire_Anomaly();
-        cJSON_AddStringToObject(tracker, "anomaly", "Wrong way");
+        snprintf(tracker->anomaly, sizeof(tracker->anomaly), "Wrong way");
         return;
     }
 }
 
-void Tracker_Data(cJSON *tracker, int timer) {
+void Tracker_Data(tracker_event_t *tracker, int timer, int channel) {
     if (!tracker) return;
     char topic[128];
+    ChannelState* state = Channel_State(channel);
 
-	Check_Anomaly( tracker );
-
-    if (publishPath && !timer && tracker)
-		Stitch_Path(ProcessPaths(tracker));
+	Check_Anomaly( state, tracker );
 
-    cJSON_DeleteItemFromObject(tracker, "previousTimestamp");
-    cJSON_DeleteItemFromObject(tracker, "maxIdle");
+    if (publishPath && !timer)
+		Stitch_Path(ProcessPaths(state, tracker), channel);
 
     if (publishTracker) {
-        snprintf(topic, sizeof(topic), "tracker/%s", ACAP_DEVICE_Prop("serial"));
-        MQTT_Publish_JSON(topic, tracker, 0, 0);
+        json_writer_t* payload = JsonWriter_Thread();
+        ObjectDetection_Tracker_Write(payload, tracker);
+        snprintf(topic, sizeof(topic), "tracker/%s%s", ACAP_DEVICE_Prop("serial"), state->topic);
+        MQTT_Publish_Writer(topic, payload, 0, 0);
     }
 
     if (publishGeospace && ACAP_STATUS_Bool("geospace", "active")) {
-        cJSON* geoCx = cJSON_GetObjectItem(tracker, "cx");
-        cJSON* geoCy = cJSON_GetObjectItem(tracker, "cy");
-        if (!geoCx || !geoCy) goto skip_geospace;
         double lat = 0, lon = 0;
-        cJSON* geoActive = cJSON_GetObjectItem(tracker, "active");
-        int is_active = geoActive && cJSON_IsTrue(geoActive);
-        int geo_ok = GeoSpace_transform(geoCx->valueint, geoCy->valueint, &lat, &lon);
+        int geo_ok = GeoSpace_transform(tracker->cx, tracker->cy, &lat, &lon);
         // Publish if transform succeeded (active objects) OR always when object leaves (to clean up map markers)
-        if (geo_ok || !is_active) {
-            cJSON* geospaceObject = cJSON_CreateObject();
-            cJSON* geoId = cJSON_GetObjectItem(tracker, "id");
-            if (geoId && geoId->valuestring) cJSON_AddStringToObject(geospaceObject, "id", geoId->valuestring);
-            if (geoActive) cJSON_AddItemToObject(geospaceObject, "active", cJSON_Duplicate(geoActive, 1));
+        if (geo_ok || !tracker->active) {
+            json_writer_t* geospaceObject = JsonWriter_Thread();
+            JsonWriter_Object_Begin(geospaceObject);
+            JSON_WRITE_STRING(geospaceObject, "id", tracker->id);
+            JSON_WRITE_BOOL(geospaceObject, "active", tracker->active);
             if (geo_ok) {
-                cJSON_AddNumberToObject(geospaceObject, "lat", round(lat * 1e6) / 1e6);
-                cJSON_AddNumberToObject(geospaceObject, "lon", round(lon * 1e6) / 1e6);
-                cJSON* geoClass = cJSON_GetObjectItem(tracker, "class");
-                if (geoClass && geoClass->valuestring)
-                    cJSON_AddStringToObject(geospaceObject, "class", geoClass->valuestring);
-                cJSON* geoAge = cJSON_GetObjectItem(tracker, "age");
-                cJSON* geoIdle = cJSON_GetObjectItem(tracker, "idle");
-                cJSON* geoConfidence = cJSON_GetObjectItem(tracker, "confidence");
-                cJSON* geoDistance = cJSON_GetObjectItem(tracker, "distance");
-                if (geoAge) cJSON_AddNumberToObject(geospaceObject, "age", geoAge->valuedouble);
-                if (geoIdle) cJSON_AddNumberToObject(geospaceObject, "idle", geoIdle->valuedouble);
-                if (geoConfidence) cJSON_AddNumberToObject(geospaceObject, "confidence", geoConfidence->valuedouble);
-                if (geoDistance) cJSON_AddNumberToObject(geospaceObject, "distance", geoDistance->valuedouble);
+                JSON_WRITE_FIXED6(geospaceObject, "lat", round(lat * 1e6) / 1e6);
+                JSON_WRITE_FIXED6(geospaceObject, "lon", round(lon * 1e6) / 1e6);
+                if (tracker->label)
+                    JSON_WRITE_STRING(geospaceObject, "class", tracker->label);
+                JSON_WRITE_FIXED1(geospaceObject, "age", tracker->age);
+                JSON_WRITE_NUMBER(geospaceObject, "idle", tracker->idle);
+                JSON_WRITE_INT(geospaceObject, "confidence", tracker->confidence);
+                JSON_WRITE_INT(geospaceObject, "distance", tracker->distance);
             }
-            snprintf(topic, sizeof(topic), "geospace/%s", ACAP_DEVICE_Prop("serial"));
-            MQTT_Publish_JSON(topic, geospaceObject, 0, 0);
-            cJSON_Delete(geospaceObject);
+            JsonWriter_Object_End(geospaceObject);
+            snprintf(topic, sizeof(topic), "geospace/%s%s", ACAP_DEVICE_Prop("serial"), state->topic);
+            MQTT_Publish_Writer(topic, geospaceObject, 0, 0);
         }
     }
-    skip_geospace:
-
-    cJSON_Delete(tracker);
 }
 
-void Publish_Path( cJSON* path ){
+void Publish_Path( cJSON* path, int channel ){
 	if( !path ) return;
+	ChannelState* state = Channel_State(channel);
 	// Discard paths with fewer than 3 sampled positions
 	cJSON* pathArray = cJSON_GetObjectItem(path, "path");
 	if( !pathArray || cJSON_GetArraySize(pathArray) < 3 ) {
@@ -658,20 +624,14 @@ void Publish_Path( cJSON* path ){
 	for (cJSON* pt = pathArray->child; pt != NULL; pt = pt->next)
 		cJSON_DeleteItemFromObject(pt, "t");
     char topic[128];
-	snprintf(topic, sizeof(topic), "path/%s", ACAP_DEVICE_Prop("serial"));
+	snprintf(topic, sizeof(topic), "path/%s%s", ACAP_DEVICE_Prop("serial"), state->topic);
 	MQTT_Publish_JSON(topic, path, 0, 0);
 	
-    cJSON* statusPaths = ACAP_STATUS_Object("detections", "paths");
-	if (statusPaths) {
-		cJSON_AddItemToArray(statusPaths, cJSON_Duplicate(path, 1));
-		while (cJSON_GetArraySize(statusPaths) > 10)
-			cJSON_DeleteItemFromArray(statusPaths, 0);
-	}
-	cJSON_Delete(path);
+    char group[32];
+    Channel_Group(state, "detections", group, sizeof(group));
+    ACAP_STATUS_Append(group, "paths", path, 10);
 }
 
-static cJSON* last_occupancy = NULL;
-
 int Check_Counters_Equal(cJSON* counter1, cJSON* counter2) {
     if (counter1 == NULL && counter2 == NULL)
         return 1;
@@ -700,39 +660,39 @@ int Check_Counters_Equal(cJSON* counter1, cJSON* counter2) {
     return 1;
 }
 
-static void push_occupancy_sample(double timestamp_ms, cJSON* counter) {
+static void push_occupancy_sample(ChannelState* state, double timestamp_ms, cJSON* counter) {
     // Remove oldest if buffer is full
-    if (occupancy_history_count == MAX_OCCUPANCY_HISTORY) {
-        cJSON_Delete(occupancy_history[occupancy_history_start].counter);
-        occupancy_history_start = (occupancy_history_start + 1) % MAX_OCCUPANCY_HISTORY;
-        occupancy_history_count--;
+    if (state->occupancy_history_count == MAX_OCCUPANCY_HISTORY) {
+        cJSON_Delete(state->occupancy_history[state->occupancy_history_start].counter);
+        state->occupancy_history_start = (state->occupancy_history_start + 1) % MAX_OCCUPANCY_HISTORY;
+        state->occupancy_history_count--;
     }
-    int idx = (occupancy_history_start + occupancy_history_count) % MAX_OCCUPANCY_HISTORY;
-    occupancy_history[idx].timestamp_ms = timestamp_ms;
-    occupancy_history[idx].counter = cJSON_Duplicate(counter, 1);
-    occupancy_history_count++;
+    int idx = (state->occupancy_history_start + state->occupancy_history_count) % MAX_OCCUPANCY_HISTORY;
+    state->occupancy_history[idx].timestamp_ms = timestamp_ms;
+    state->occupancy_history[idx].counter = cJSON_Duplicate(counter, 1);
+    state->occupancy_history_count++;
 }
 
-static void push_occupancy_zero_sample(double timestamp_ms) {
+static void push_occupancy_zero_sample(ChannelState* state, double timestamp_ms) {
     cJSON* empty = cJSON_CreateObject();
-    push_occupancy_sample(timestamp_ms, empty);
+    push_occupancy_sample(state, timestamp_ms, empty);
     cJSON_Delete(empty);
 }
 
 cJSON*
-compute_stabilized_occupancy(double now, double integration_time) {
+compute_stabilized_occupancy(ChannelState* state, double now, double integration_time) {
     // Remove outdated entries
-    while (occupancy_history_count > 0 &&
-           occupancy_history[occupancy_history_start].timestamp_ms < now - integration_time) {
-        cJSON_Delete(occupancy_history[occupancy_history_start].counter);
-        occupancy_history_start = (occupancy_history_start + 1) % MAX_OCCUPANCY_HISTORY;
-        occupancy_history_count--;
+    while (state->occupancy_history_count > 0 &&
+           state->occupancy_history[state->occupancy_history_start].timestamp_ms < now - integration_time) {
+        cJSON_Delete(state->occupancy_history[state->occupancy_history_start].counter);
+        state->occupancy_history_start = (state->occupancy_history_start + 1) % MAX_OCCUPANCY_HISTORY;
+        state->occupancy_history_count--;
     }
     // Aggregate all counters
     cJSON* result = cJSON_CreateObject();
     int n = 0;
-    for (int i = 0, idx = occupancy_history_start; i < occupancy_history_count; ++i, idx = (idx + 1) % MAX_OCCUPANCY_HISTORY) {
-        cJSON* counter = occupancy_history[idx].counter;
+    for (int i = 0, idx = state->occupancy_history_start; i < state->occupancy_history_count; ++i, idx = (idx + 1) % MAX_OCCUPANCY_HISTORY) {
+        cJSON* counter = state->occupancy_history[idx].counter;
         cJSON* item = counter->child;
         while (item) {
             cJSON* sum = cJSON_GetObjectItem(result, item->string);
@@ -756,7 +716,7 @@ compute_stabilized_occupancy(double now, double integration_time) {
     return result;
 }
 
-cJSON* ProcessOccupancy(cJSON* list) {
+cJSON* ProcessOccupancy(ChannelState* state, cJSON* list) {
     cJSON* settings = ACAP_Get_Config("settings");
     if (!settings)
         return 0;
@@ -773,18 +733,18 @@ cJSON* ProcessOccupancy(cJSON* list) {
     if (listSize == 0) {
         cJSON* empty = cJSON_CreateObject();
         int changed = 1;
-        if (last_occupancy && Check_Counters_Equal(last_occupancy, empty))
+        if (state->last_occupancy && Check_Counters_Equal(state->last_occupancy, empty))
             changed = 0;
         if (!changed) {
             cJSON_Delete(empty);
             return 0;
         }
         // Only add to history and report on change
-        double now = ACAP_DEVICE_Timestamp();
-        push_occupancy_zero_sample(now);
-        if (last_occupancy)
-            cJSON_Delete(last_occupancy);
-        last_occupancy = cJSON_Duplicate(empty, 1);
+        double now = ObjectDetection_Time();
+        push_occupancy_zero_sample(state, now);
+        if (state->last_occupancy)
+            cJSON_Delete(state->last_occupancy);
+        state->last_occupancy = cJSON_Duplicate(empty, 1);
         return empty;
     }
 
@@ -830,43 +790,255 @@ cJSON* ProcessOccupancy(cJSON* list) {
     }
 
     // Compare with the last reported occupancy before history/report
-    if (last_occupancy && Check_Counters_Equal(last_occupancy, counters)) {
+    if (state->last_occupancy && Check_Counters_Equal(state->last_occupancy, counters)) {
         cJSON_Delete(counters); // Clean up if not sending
         return 0;
     }
 
     // Only now do we push to history and report
-    double now = ACAP_DEVICE_Timestamp();
-    push_occupancy_sample(now, counters);
+    double now = ObjectDetection_Time();
+    push_occupancy_sample(state, now, counters);
 
-    if (last_occupancy)
-        cJSON_Delete(last_occupancy);
-    last_occupancy = cJSON_Duplicate(counters, 1);
-    ACAP_STATUS_SetObject("occupancy", "counter", counters);
+    if (state->last_occupancy)
+        cJSON_Delete(state->last_occupancy);
+    state->last_occupancy = cJSON_Duplicate(counters, 1);
+    char group[32];
+    ACAP_STATUS_SetObject(Channel_Group(state, "occupancy", group, sizeof(group)), "counter", counters);
 
     return counters;
 }
 
-int lasty_detections_was_empty = 0;
+// Next delta message carries the full list on every channel
+static void Detections_Request_Keyframe(void) {
+    for (int i = 0; i < OBJECTDETECTION_MAX_CHANNELS; ++i)
+        g_atomic_int_set(&channel_states[i].detections_keyframe_request, 1);
+}
+
+static const char* Detection_Id(cJSON* item) {
+    cJSON* id = cJSON_GetObjectItem(item, "id");
+    if (!cJSON_IsString(id) || cJSON_IsFalse(cJSON_GetObjectItem(item, "active")))
+        return NULL;
+    return id->valuestring;
+}
 
-void Detections_Data(cJSON *list) {
-    char topic[128];
-    if (publishDetections) {
-        if (cJSON_GetArraySize(list) > 0 || !lasty_detections_was_empty) {
-            snprintf(topic, sizeof(topic), "detections/%s", ACAP_DEVICE_Prop("serial"));
-            cJSON* payload = cJSON_CreateObject();
-            cJSON_AddItemReferenceToObject(payload, "list", list);
-            MQTT_Publish_JSON(topic, payload, 0, 0);
-            cJSON_Delete(payload);
+static DetectionBox Detection_Box(cJSON* item) {
+    DetectionBox box;
+    box.x = cJSON_GetObjectItem(item, "x") ? cJSON_GetObjectItem(item, "x")->valueint : 0;
+    box.y = cJSON_GetObjectItem(item, "y") ? cJSON_GetObjectItem(item, "y")->valueint : 0;
+    box.w = cJSON_GetObjectItem(item, "w") ? cJSON_GetObjectItem(item, "w")->valueint : 0;
+    box.h = cJSON_GetObjectItem(item, "h") ? cJSON_GetObjectItem(item, "h")->valueint : 0;
+    box.seen = 0;
+    return box;
+}
+
+static int Detection_Box_Moved(const DetectionBox* a, const DetectionBox* b) {
+    return abs(a->x - b->x) > detectionsThreshold || abs(a->y - b->y) > detectionsThreshold ||
+           abs(a->w - b->w) > detectionsThreshold || abs(a->h - b->h) > detectionsThreshold;
+}
+
+/*
+ * Delta mode. Objects that are new since the last message are listed in
+ * "added", objects whose box moved more than the threshold in "updated"
+ * and objects that ended or left in "removed". A keyframe lists every
+ * active object and replaces the consumer's state. "seq" increases by
+ * one per message so a consumer that sees a gap knows to wait for the
+ * next keyframe (or request one on command/{serial}).
+ */
+static int Detections_Publish_Delta(ChannelState* state, cJSON* list, const char* topic, double now) {
+    if (!state->detections_sent)
+        state->detections_sent = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+    GHashTable* sent = state->detections_sent;
+    unsigned seq = state->detections_seq + 1;
+    int changes = 0;
+    cJSON* item;
+
+    int keyframe = g_atomic_int_compare_and_exchange(&state->detections_keyframe_request, 1, 0);
+    if (state->detections_seq == 0 || now < state->detections_keyframe ||
+        (detectionsKeyframe > 0 && now - state->detections_keyframe >= detectionsKeyframe))
+        keyframe = 1;
+
+    json_writer_t* payload = JsonWriter_Thread();
+    JsonWriter_Object_Begin(payload);
+    JsonWriter_Key(payload, "seq");
+    JsonWriter_Number(payload, seq);
+    JsonWriter_Key(payload, "keyframe");
+    JsonWriter_Bool(payload, keyframe);
+
+    if (keyframe) {
+        g_hash_table_remove_all(sent);
+        JsonWriter_Key(payload, "list");
+        JsonWriter_Array_Begin(payload);
+        cJSON_ArrayForEach(item, list) {
+            const char* id = Detection_Id(item);
+            if (!id || g_hash_table_contains(sent, id))
+                continue;
+            DetectionBox* box = g_new(DetectionBox, 1);
+            *box = Detection_Box(item);
+            box->seen = seq;
+            g_hash_table_insert(sent, g_strdup(id), box);
+            JsonWriter_JSON(payload, item);
+        }
+        JsonWriter_Array_End(payload);
+        state->detections_keyframe = now;
+    } else {
+        JsonWriter_Key(payload, "added");
+        JsonWriter_Array_Begin(payload);
+        cJSON_ArrayForEach(item, list) {
+            const char* id = Detection_Id(item);
+            if (!id)
+                continue;
+            DetectionBox* box = g_hash_table_lookup(sent, id);
+            if (box) {
+                box->seen = seq;
+                continue;
+            }
+            box = g_new(DetectionBox, 1);
+            *box = Detection_Box(item);
+            box->seen = seq;
+            g_hash_table_insert(sent, g_strdup(id), box);
+            JsonWriter_JSON(payload, item);
+            changes++;
+        }
+        JsonWriter_Array_End(payload);
+
+        JsonWriter_Key(payload, "updated");
+        JsonWriter_Array_Begin(payload);
+        cJSON_ArrayForEach(item, list) {
+            const char* id = Detection_Id(item);
+            DetectionBox* box = id ? g_hash_table_lookup(sent, id) : NULL;
+            if (!box)
+                continue;
+            DetectionBox current = Detection_Box(item);
+            if (!Detection_Box_Moved(box, &current))
+                continue;
+            current.seen = seq;
+            *box = current;
+            JsonWriter_JSON(payload, item);
+            changes++;
+        }
+        JsonWriter_Array_End(payload);
+
+        JsonWriter_Key(payload, "removed");
+        JsonWriter_Array_Begin(payload);
+        GHashTableIter iter;
+        gpointer key, value;
+        g_hash_table_iter_init(&iter, sent);
+        while (g_hash_table_iter_next(&iter, &key, &value)) {
+            if (((DetectionBox*)value)->seen == seq)
+                continue;
+            JsonWriter_String(payload, key);
+            g_hash_table_iter_remove(&iter);
+            changes++;
         }
+        JsonWriter_Array_End(payload);
     }
-    lasty_detections_was_empty = cJSON_GetArraySize(list) == 0;
+    JsonWriter_Key(payload, "timestamp");
+    JsonWriter_Number(payload, now);
+    JsonWriter_Object_End(payload);
+
+    if (!keyframe && !changes)
+        return 0;
+    state->detections_seq = seq;
+    MQTT_Publish_Writer(topic, payload, 0, 0);
+    return 1;
+}
+
+// Full list, with objects that ended in frames skipped by the rate limit
+static int Detections_Publish_Full(ChannelState* state, cJSON* list, const char* topic) {
+    int deaths = cJSON_GetArraySize(state->detections_deaths);
+    int empty = cJSON_GetArraySize(list) == 0 && deaths == 0;
+    if (empty && state->detections_was_empty)
+        return 0;
+    json_writer_t* payload = JsonWriter_Thread();
+    JsonWriter_Object_Begin(payload);
+    JsonWriter_Key(payload, "list");
+    JsonWriter_Array_Begin(payload);
+    cJSON* item;
+    cJSON_ArrayForEach(item, list)
+        JsonWriter_JSON(payload, item);
+    cJSON_ArrayForEach(item, state->detections_deaths)
+        JsonWriter_JSON(payload, item);
+    JsonWriter_Array_End(payload);
+    JsonWriter_Object_End(payload);
+    MQTT_Publish_Writer(topic, payload, 0, 0);
+    if (deaths) {
+        cJSON_Delete(state->detections_deaths);
+        state->detections_deaths = NULL;
+    }
+    state->detections_was_empty = empty;
+    return 1;
+}
+
+/*
+ * With detections.maxRate, frames between two messages are only looked at
+ * for objects that ended, so that every "active": false reaches the topic.
+ * Everything else is coalesced into the state of the frame that is
+ * published; delta mode compares against the last message, not the last
+ * frame, and needs no help.
+ */
+// Frames inside the detections.maxRate interval are not published
+static int Detections_Held(ChannelState* state, double now) {
+    // A requested keyframe is not held back; consumers that asked have no state
+    if (detectionsDelta && g_atomic_int_get(&state->detections_keyframe_request))
+        return 0;
+    return detectionsInterval > 0 && now >= state->detections_next - detectionsInterval &&
+           now < state->detections_next;
+}
+
+static void Detections_Publish(ChannelState* state, cJSON* list) {
+    double now = ObjectDetection_Time();
+    if (Detections_Held(state, now)) {
+        if (detectionsDelta)
+            return;
+        cJSON* item;
+        cJSON_ArrayForEach(item, list) {
+            if (!cJSON_IsFalse(cJSON_GetObjectItem(item, "active")))
+                continue;
+            if (!state->detections_deaths)
+                state->detections_deaths = cJSON_CreateArray();
+            cJSON_AddItemToArray(state->detections_deaths, cJSON_Duplicate(item, 1));
+        }
+        return;
+    }
+    char topic[128];
+    snprintf(topic, sizeof(topic), "detections/%s%s", ACAP_DEVICE_Prop("serial"), state->topic);
+    int published = detectionsDelta ? Detections_Publish_Delta(state, list, topic, now)
+                                    : Detections_Publish_Full(state, list, topic);
+    if (!published || detectionsInterval <= 0)
+        return;
+    // Keep the average rate when frames do not line up with the interval
+    state->detections_next += detectionsInterval;
+    if (state->detections_next <= now || state->detections_next > now + detectionsInterval)
+        state->detections_next = now + detectionsInterval;
+}
+
+// Whether Detections_Data uses the coming frame's list. ObjectDetection
+// skips building it when not, unless an object ends in that frame.
+int Detections_Due(int channel) {
+    ChannelState* state = Channel_State(channel);
+    if (publishOccupancy)
+        return 1;
+    if (!publishDetections) {
+        // Unknown while unpublished; the first list after resuming is sent
+        state->detections_was_empty = 0;
+        return 0;
+    }
+    return !Detections_Held(state, ObjectDetection_Time());
+}
+
+void Detections_Data(cJSON *list, int channel) {
+    char topic[128];
+    ChannelState* state = Channel_State(channel);
+    if (publishDetections)
+        Detections_Publish(state, list);
+    else
+        state->detections_was_empty = cJSON_GetArraySize(list) == 0;
 
     if (publishOccupancy) {
         // Process actual occupancy, update buffers
-        cJSON* counter = ProcessOccupancy(list);
+        cJSON* counter = ProcessOccupancy(state, list);
 		if(counter ) {
-			double now = ACAP_DEVICE_Timestamp();
+			double now = ObjectDetection_Time();
 
 			// Fetch settings (allow fallback if not found)
 			cJSON* settings = ACAP_Get_Config("settings");
@@ -877,14 +1049,17 @@ void Detections_Data(cJSON *list) {
 			}
 
 			// Compute stabilized output
-			cJSON* stabilized = compute_stabilized_occupancy(now, integrationTime);
+			cJSON* stabilized = compute_stabilized_occupancy(state, now, integrationTime);
 			if (stabilized) {
-				cJSON* payload = cJSON_CreateObject();
-				cJSON_AddItemToObject(payload, "occupancy", stabilized);
-				cJSON_AddNumberToObject(payload, "timestamp", now);
-				snprintf(topic, sizeof(topic), "occupancy/%s", ACAP_DEVICE_Prop("serial"));
-				MQTT_Publish_JSON(topic, payload, 0, 0);
-				cJSON_Delete(payload);
+				json_writer_t* payload = JsonWriter_Thread();
+				JsonWriter_Object_Begin(payload);
+				JsonWriter_Key(payload, "occupancy");
+				JsonWriter_JSON(payload, stabilized);
+				JSON_WRITE_NUMBER(payload, "timestamp", now);
+				JsonWriter_Object_End(payload);
+				snprintf(topic, sizeof(topic), "occupancy/%s%s", ACAP_DEVICE_Prop("serial"), state->topic);
+				MQTT_Publish_Writer(topic, payload, 0, 0);
+				cJSON_Delete(stabilized);
 			}
 			cJSON_Delete(counter); // Unstabilized, only for transition/compat use
 		}
@@ -1077,12 +1252,12 @@ static gboolean Image_Idle_Capture(gpointer user_data) {
 
 /* Noon timer: fires once per day at 12:00 local time.
  * Rescheduled after each shot for exactly 24 h.          */
-static gboolean Noon_Image_Timer(gpointer user_data);
+static void Noon_Image_Timer(void* user_data);
 
 static void Schedule_Noon_Image(void) {
     /* Cancel any existing timer */
     if (image_noon_timer_id) {
-        g_source_remove(image_noon_timer_id);
+        TimerWheel_Main_Cancel(image_noon_timer_id);
         image_noon_timer_id = 0;
     }
     /* Seconds from now until next 12:00 */
@@ -1090,17 +1265,16 @@ static void Schedule_Noon_Image(void) {
     int noon = 12 * 3600;
     int delay = noon - sec_since_midnight;
     if (delay <= 0) delay += 24 * 3600;   /* already past noon today */
-    image_noon_timer_id = g_timeout_add_seconds((guint)delay, Noon_Image_Timer, NULL);
+    image_noon_timer_id = TimerWheel_Main_Schedule(delay * 1000.0, Noon_Image_Timer, NULL);
     LOG("Next image scheduled in %d min\n", delay / 60);
 }
 
-static gboolean Noon_Image_Timer(gpointer user_data) {
+static void Noon_Image_Timer(void* user_data) {
     (void)user_data;
     image_noon_timer_id = 0;
     if (publishImage)
         g_idle_add(Image_Idle_Capture, NULL);
     Schedule_Noon_Image();          /* reschedule for tomorrow */
-    return G_SOURCE_REMOVE;
 }
 
 static gboolean MQTT_Publish_Device_Status(gpointer user_data) {
@@ -1121,6 +1295,15 @@ static gboolean MQTT_Publish_Device_Status(gpointer user_data) {
     return G_SOURCE_CONTINUE;
 }
 
+// The session is clean, so the broker forgets the subscription whenever
+// the connection drops; renewed on every connect and reconnect
+static void Main_Subscribe_Commands(void) {
+    char topic[64];
+    snprintf(topic, sizeof(topic), "command/%s", ACAP_DEVICE_Prop("serial"));
+    if (!MQTT_Subscribe(topic))
+        LOG_WARN("%s: Unable to subscribe to %s\n", __func__, topic);
+}
+
 void Main_MQTT_Status(int state) {
     char topic[64];
     cJSON* message = 0;
@@ -1152,6 +1335,8 @@ void Main_MQTT_Status(int state) {
             MQTT_Publish_JSON(topic, message, 0, 1);
             cJSON_Delete(message);
             MQTT_Publish_Device_Status(0);
+            Detections_Request_Keyframe();
+            Main_Subscribe_Commands();
             if (publishImage) {
                 g_idle_add(Image_Idle_Capture, NULL);
                 Schedule_Noon_Image();
@@ -1169,6 +1354,9 @@ void Main_MQTT_Status(int state) {
         case MQTT_RECONNECTED:
             LOG("%s: Reconnected\n", __func__);
             mqttConnected = 1;
+            Main_Subscribe_Commands();
+            // Consumers may have lost their state while the broker was away
+            Detections_Request_Keyframe();
             break;
         case MQTT_DISCONNECTED:
             LOG("%s: Disconnect\n", __func__);
@@ -1177,8 +1365,29 @@ void Main_MQTT_Status(int state) {
     }
 }
 
+// Commands are applied on the main loop; the MQTT client calls from its own thread
+static gboolean Main_Command_Idle(gpointer user_data) {
+    char *payload = user_data;
+    cJSON *command = cJSON_Parse(payload);
+    if (!command) {
+        LOG_WARN("Invalid command: %s\n", payload);
+    } else {
+        cJSON *recorder = cJSON_GetObjectItem(command, "recorder");
+        if (recorder)
+            Recorder_Command(recorder);
+        cJSON *detections = cJSON_GetObjectItem(command, "detections");
+        if (cJSON_IsTrue(cJSON_GetObjectItem(detections, "keyframe")))
+            Detections_Request_Keyframe();
+        cJSON_Delete(command);
+    }
+    g_free(payload);
+    return G_SOURCE_REMOVE;
+}
+
 void Main_MQTT_Subscription_Message(const char *topic, const char *payload) {
     LOG("Message arrived: %s %s\n", topic, payload);
+    if (topic && payload && strstr(topic, "command/"))
+        g_idle_add(Main_Command_Idle, g_strdup(payload));
 }
 
 static GMainLoop *main_loop = NULL;
@@ -1218,11 +1427,24 @@ void Settings_Updated_Callback(const char* service, cJSON* data) {
         } else if (!newImage && publishImage) {
             /* Disabled — cancel noon timer */
             if (image_noon_timer_id) {
-                g_source_remove(image_noon_timer_id);
+                TimerWheel_Main_Cancel(image_noon_timer_id);
                 image_noon_timer_id = 0;
             }
         }
         publishImage = newImage;
+        Detections_Request_Keyframe();
+    }
+
+    if (strcmp(service, "detections") == 0) {
+        cJSON* mode = cJSON_GetObjectItem(data, "mode");
+        cJSON* keyframe = cJSON_GetObjectItem(data, "keyframe");
+        cJSON* threshold = cJSON_GetObjectItem(data, "threshold");
+        detectionsDelta = cJSON_IsString(mode) && strcmp(mode->valuestring, "delta") == 0;
+        detectionsKeyframe = cJSON_IsNumber(keyframe) && keyframe->valuedouble > 0 ? keyframe->valuedouble * 1000 : 0;
+        detectionsThreshold = cJSON_IsNumber(threshold) && threshold->valueint > 0 ? threshold->valueint : 0;
+        cJSON* maxRate = cJSON_GetObjectItem(data, "maxRate");
+        detectionsInterval = cJSON_IsNumber(maxRate) && maxRate->valuedouble > 0 ? 1000.0 / maxRate->valuedouble : 0;
+        Detections_Request_Keyframe();
     }
 
     if (strcmp(service, "scene") == 0)
@@ -1231,8 +1453,14 @@ void Settings_Updated_Callback(const char* service, cJSON* data) {
     if (strcmp(service, "matrix") == 0)
         GeoSpace_Matrix(data);
 
+    if (strcmp(service, "anomaly") == 0)
+        Anomaly_Settings(data);
+
     if (strcmp(service, "stitch") == 0)
         Stitch_Settings(data);	
+
+    if (strcmp(service, "recorder") == 0)
+        Recorder_Settings(data);
 }
 
 void HandleVersionUpdateConfigurations(cJSON* settings) {
@@ -1311,6 +1539,7 @@ int main(void) {
         subscription = subscription->next;
     }
 
+    ObjectDetection_Detections_Due(Detections_Due);
     if (ObjectDetection_Init(Detections_Data, Tracker_Data)) {
         ACAP_STATUS_SetBool("objectdetection", "connected", 1);
         ACAP_STATUS_SetString("objectdetection", "status", "OK");
@@ -1328,6 +1557,7 @@ int main(void) {
     }
 
     GeoSpace_Init();
+    Recorder_Init(cJSON_GetObjectItem(settings, "recorder"));
     g_timeout_add_seconds(15 * 60, MQTT_Publish_Device_Status, NULL);
 
 	Stitch_Init(Publish_Path);
@@ -1355,6 +1585,7 @@ int main(void) {
     LOG("Terminating and cleaning up %s\n", APP_PACKAGE);
     Main_MQTT_Status(MQTT_DISCONNECTING);
     MQTT_Cleanup();
+    Recorder_Cleanup();
     ACAP_Cleanup();
     closelog();
     return 0;
@@ -0,0 +1,377 @@
+/*------------------------------------------------------------------
+ *  Replay.c
+ *  Runs a scene recording through the full DataQ pipeline without a
+ *  camera: subscriber callback -> VOD -> VOD_Data -> Tracker_Data /
+ *  Detections_Data -> ProcessPaths -> Stitch_Path -> publish.
+ *
+ *  dataq-replay [-r] [-a] [-s settings.json] [-o messages.jsonl] file.dqr ...
+ *    -r  Replay at recorded speed (default: as fast as possible)
+ *    -a  Publish all streams regardless of the publish settings
+ *    -s  Settings file (default settings/settings.json)
+ *    -o  Write every published message as a JSON line
+ *
+ *  Prints frames/s, per-stage CPU time and a digest of all published
+ *  messages. Several files are replayed as one recording.
+ *  Fred Juhlin (2025)
+ *------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include <glib.h>
+#include "cJSON.h"
+#include "ACAP.h"
+#include "MQTT.h"
+#include "VOD.h"
+#include "ObjectDetection.h"
+#include "GeoSpace.h"
+#include "Stitch.h"
+#include "Recorder.h"
+#include "FrameQueue.h"
+#include "Replay.h"
+
+// main.c, built with -Dmain=DataQ_Main
+void Tracker_Data(tracker_event_t *tracker, int timer, int channel);
+void Detections_Data(cJSON *list, int channel);
+int Detections_Due(int channel);
+void Publish_Path(cJSON *path, int channel);
+void Settings_Updated_Callback(const char *service, cJSON *data);
+void HandleVersionUpdateConfigurations(cJSON *settings);
+
+/*-----------------------------------------------------
+ * Stage timing
+ *-----------------------------------------------------*/
+
+#define STAGE_MAX_DEPTH 8
+
+typedef struct {
+    replay_stage_t stage;
+    int64_t start;
+    int64_t children;
+} stage_frame_t;
+
+static const char *stage_names[STAGE_COUNT] = {
+    "ingest", "vod", "objectdetection", "tracker", "detections", "stitch", "publish"
+};
+static __thread stage_frame_t stage_stack[STAGE_MAX_DEPTH];
+static __thread int stage_depth = 0;
+static pthread_mutex_t stage_mutex = PTHREAD_MUTEX_INITIALIZER;
+static int64_t stage_ns[STAGE_COUNT];
+static uint64_t stage_calls[STAGE_COUNT];
+
+int64_t Replay_Thread_CPU(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+void Replay_Stage_Add(replay_stage_t stage, int64_t ns) {
+    pthread_mutex_lock(&stage_mutex);
+    stage_ns[stage] += ns;
+    stage_calls[stage]++;
+    pthread_mutex_unlock(&stage_mutex);
+}
+
+void Replay_Stage_Enter(replay_stage_t stage) {
+    if (stage_depth < STAGE_MAX_DEPTH)
+        stage_stack[stage_depth] = (stage_frame_t){ stage, Replay_Thread_CPU(), 0 };
+    stage_depth++;
+}
+
+void Replay_Stage_Exit(replay_stage_t stage) {
+    if (stage_depth <= 0) return;
+    stage_depth--;
+    if (stage_depth >= STAGE_MAX_DEPTH) return;
+    stage_frame_t *frame = &stage_stack[stage_depth];
+    int64_t elapsed = Replay_Thread_CPU() - frame->start;
+    Replay_Stage_Add(frame->stage, elapsed - frame->children);
+    if (stage_depth > 0)
+        stage_stack[stage_depth - 1].children += elapsed;
+}
+
+/*-----------------------------------------------------
+ * Pipeline hooks
+ *-----------------------------------------------------*/
+
+static vod_callback_t vod_data = NULL;
+static __thread int64_t worker_cpu = 0;
+
+// VOD thread: CPU spent since the previous callback returned is VOD's own
+static void replay_vod_data(const vod_frame_t *frame, void *user_data) {
+    int64_t now = Replay_Thread_CPU();
+    if (worker_cpu)
+        Replay_Stage_Add(STAGE_VOD, now - worker_cpu);
+    Replay_Stage_Enter(STAGE_OBJECTDETECTION);
+    vod_data(frame, user_data);
+    Replay_Stage_Exit(STAGE_OBJECTDETECTION);
+    worker_cpu = Replay_Thread_CPU();
+}
+
+// Linked with -Wl,--wrap=VOD_Init,--wrap=Stitch_Path
+int __real_VOD_Init(int channel, vod_callback_t cb, void *user_data, int predictions);
+void __real_Stitch_Path(cJSON *path, int channel);
+
+int __wrap_VOD_Init(int channel, vod_callback_t cb, void *user_data, int predictions) {
+    vod_data = cb;
+    return __real_VOD_Init(channel, replay_vod_data, user_data, predictions);
+}
+
+void __wrap_Stitch_Path(cJSON *path, int channel) {
+    Replay_Stage_Enter(STAGE_STITCH);
+    __real_Stitch_Path(path, channel);
+    Replay_Stage_Exit(STAGE_STITCH);
+}
+
+static void replay_tracker(tracker_event_t *tracker, int timer, int channel) {
+    Replay_Stage_Enter(STAGE_TRACKER);
+    Tracker_Data(tracker, timer, channel);
+    Replay_Stage_Exit(STAGE_TRACKER);
+}
+
+static void replay_detections(cJSON *list, int channel) {
+    Replay_Stage_Enter(STAGE_DETECTIONS);
+    Detections_Data(list, channel);
+    Replay_Stage_Exit(STAGE_DETECTIONS);
+}
+
+/*-----------------------------------------------------
+ * Recording reader
+ *-----------------------------------------------------*/
+
+typedef struct {
+    char **files;
+    int num_files;
+    int index;
+    FILE *file;
+    uint8_t *payload;
+    size_t capacity;
+} reader_t;
+
+static int reader_open_next(reader_t *reader) {
+    if (reader->file) fclose(reader->file);
+    reader->file = NULL;
+    while (reader->index < reader->num_files) {
+        const char *name = reader->files[reader->index++];
+        reader->file = fopen(name, "rb");
+        char magic[RECORDER_MAGIC_SIZE];
+        if (reader->file && fread(magic, sizeof(magic), 1, reader->file) == 1 &&
+            memcmp(magic, RECORDER_MAGIC, sizeof(magic)) == 0)
+            return 1;
+        fprintf(stderr, "Replay: %s is not a scene recording\n", name);
+        if (reader->file) fclose(reader->file);
+        reader->file = NULL;
+    }
+    return 0;
+}
+
+// Next record across all files. A truncated record ends its file.
+static int reader_next(reader_t *reader, recorder_record_t *header) {
+    for (;;) {
+        if (!reader->file && !reader_open_next(reader)) return 0;
+        if (fread(header, sizeof(*header), 1, reader->file) == 1) {
+            if (header->length > reader->capacity) {
+                uint8_t *grown = realloc(reader->payload, header->length);
+                if (!grown) return 0;
+                reader->payload = grown;
+                reader->capacity = header->length;
+            }
+            if (header->length == 0 || fread(reader->payload, header->length, 1, reader->file) == 1)
+                return 1;
+            fprintf(stderr, "Replay: Truncated record in %s\n", reader->files[reader->index - 1]);
+        }
+        fclose(reader->file);
+        reader->file = NULL;
+    }
+}
+
+/*-----------------------------------------------------
+ * Main
+ *-----------------------------------------------------*/
+
+static void usage(const char *name) {
+    fprintf(stderr, "Usage: %s [-r] [-a] [-s settings.json] [-o messages.jsonl] file.dqr ...\n"
+                    "  -r  Replay at recorded speed (default: as fast as possible)\n"
+                    "  -a  Publish all streams regardless of the publish settings\n"
+                    "  -s  Settings file (default settings/settings.json)\n"
+                    "  -o  Write every published message as a JSON line\n", name);
+}
+
+static void set_string(cJSON *object, const char *name, const char *value) {
+    if (cJSON_GetObjectItem(object, name))
+        cJSON_ReplaceItemInObject(object, name, cJSON_CreateString(value));
+    else
+        cJSON_AddStringToObject(object, name, value);
+}
+
+int main(int argc, char **argv) {
+    int realtime = 0, publish_all = 0, opt;
+    const char *settings_file = "settings/settings.json";
+    const char *output_file = NULL;
+    while ((opt = getopt(argc, argv, "ras:o:h")) != -1) {
+        switch (opt) {
+            case 'r': realtime = 1; break;
+            case 'a': publish_all = 1; break;
+            case 's': settings_file = optarg; break;
+            case 'o': output_file = optarg; break;
+            default: usage(argv[0]); return 2;
+        }
+    }
+    if (optind >= argc) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    reader_t reader = { .files = &argv[optind], .num_files = argc - optind };
+    recorder_record_t header;
+    cJSON *info = NULL;
+    uint8_t *detector = NULL;
+    size_t detector_size = 0;
+
+    // Every file starts with INFO and DETECTOR
+    while (!(info && detector) && reader_next(&reader, &header)) {
+        if (header.type == RECORDER_INFO) {
+            char *json = strndup((const char *)reader.payload, header.length);
+            info = json ? cJSON_Parse(json) : NULL;
+            free(json);
+        } else if (header.type == RECORDER_DETECTOR) {
+            detector = malloc(header.length ? header.length : 1);
+            memcpy(detector, reader.payload, header.length);
+            detector_size = header.length;
+        }
+    }
+    if (!info || !detector) {
+        fprintf(stderr, "Replay: Recording has no detector header\n");
+        return 1;
+    }
+
+    cJSON *serial = cJSON_GetObjectItem(info, "serial");
+    cJSON *started = cJSON_GetObjectItem(info, "timestamp");
+    double start_ms = cJSON_IsNumber(started) ? started->valuedouble : 0;
+    Replay_Subscriber_Setup(cJSON_GetObjectItem(info, "classes"), detector, detector_size);
+    Replay_ACAP_Setup(settings_file, cJSON_IsString(serial) ? serial->valuestring : NULL);
+    Replay_ACAP_Set_Time(start_ms);
+
+    FILE *output = NULL;
+    if (output_file) {
+        output = fopen(output_file, "w");
+        if (!output) {
+            fprintf(stderr, "Replay: Unable to create %s\n", output_file);
+            return 1;
+        }
+        Replay_MQTT_Output(output);
+    }
+
+    // Same start-up order as main.c
+    cJSON *settings = ACAP_Init("DataQ", Settings_Updated_Callback);
+    HandleVersionUpdateConfigurations(settings);
+    cJSON *pipeline = cJSON_GetObjectItem(settings, "pipeline");
+    if (!pipeline)
+        pipeline = cJSON_AddObjectToObject(settings, "pipeline");
+    if (!realtime) {  // Back-pressure below replaces overflow handling
+        set_string(pipeline, "overflow", "drop-oldest");
+        // Decimation follows host load; keep fast replays reproducible
+        cJSON *decimation = cJSON_GetObjectItem(pipeline, "decimation");
+        if (!decimation)
+            decimation = cJSON_AddObjectToObject(pipeline, "decimation");
+        cJSON_DeleteItemFromObject(decimation, "maxStride");
+        cJSON_AddNumberToObject(decimation, "maxStride", 1);
+    }
+    // A recording holds one channel; replay it as the primary channel
+    cJSON *channel = cJSON_GetObjectItem(info, "channel");
+    cJSON *channels = cJSON_CreateArray();
+    cJSON_AddItemToArray(channels, cJSON_CreateNumber(cJSON_IsNumber(channel) ? channel->valueint : 0));
+    if (cJSON_GetObjectItem(pipeline, "channels"))
+        cJSON_ReplaceItemInObject(pipeline, "channels", channels);
+    else
+        cJSON_AddItemToObject(pipeline, "channels", channels);
+    cJSON *depth = cJSON_GetObjectItem(pipeline, "queueDepth");
+    int backlog_limit = (cJSON_IsNumber(depth) && depth->valueint > 0 ? depth->valueint : FRAME_QUEUE_DEFAULT_DEPTH) - 1;
+    if (backlog_limit < 1) backlog_limit = 1;
+
+    if (publish_all) {
+        cJSON *publish = cJSON_Parse("{\"events\":true,\"detections\":true,\"tracker\":true,\"path\":true,"
+                                     "\"occupancy\":true,\"status\":false,\"geospace\":true,"
+                                     "\"anomaly\":true,\"image\":false}");
+        Settings_Updated_Callback("publish", publish);
+        cJSON_Delete(publish);
+    }
+
+    cJSON *paths = cJSON_CreateArray();
+    ACAP_STATUS_SetObject("detections", "paths", paths);
+    cJSON_Delete(paths);
+    MQTT_Init(NULL, NULL);
+    ObjectDetection_Detections_Due(Detections_Due);
+    if (!ObjectDetection_Init(replay_detections, replay_tracker)) {
+        fprintf(stderr, "Replay: Pipeline initialization failed\n");
+        return 1;
+    }
+    GeoSpace_Init();
+    Stitch_Init(Publish_Path);
+    cJSON *stitch = cJSON_GetObjectItem(settings, "stitch");
+    if (stitch)
+        Stitch_Settings(stitch);
+    ACAP_EVENTS_Add_Event("anomaly", "DataQ: Anomaly", 1);
+
+    uint64_t frames = 0;
+    int64_t first_us = -1, last_us = 0;
+    gint64 wall_start = g_get_monotonic_time();
+    while (reader_next(&reader, &header)) {
+        if (header.type != RECORDER_SCENE) continue;
+        if (first_us < 0) first_us = header.time_us;
+        last_us = header.time_us;
+
+        if (realtime) {
+            gint64 target = wall_start + (header.time_us - first_us);
+            gint64 remaining;
+            while ((remaining = target - g_get_monotonic_time()) > 0) {
+                if (!g_main_context_iteration(NULL, FALSE))
+                    g_usleep(remaining < 1000 ? remaining : 1000);
+            }
+        } else {
+            while (VOD_Backlog() >= backlog_limit)
+                g_usleep(20);
+            g_main_context_iteration(NULL, FALSE);
+        }
+
+        Replay_ACAP_Set_Time(start_ms + header.time_us / 1000.0);
+        Replay_Stage_Enter(STAGE_INGEST);
+        Replay_Subscriber_Deliver(reader.payload, header.length);
+        Replay_Stage_Exit(STAGE_INGEST);
+        frames++;
+    }
+    while (VOD_Backlog() > 0)
+        g_usleep(100);
+    while (g_main_context_iteration(NULL, FALSE));
+    double wall = (g_get_monotonic_time() - wall_start) / 1e6;
+    double recorded = first_us < 0 ? 0 : (last_us - first_us) / 1e6;
+    VOD_Shutdown();
+
+    fprintf(stderr, "\nReplay: %llu frames in %.2f s, %.0f frames/s (recorded %.1f s, %.1fx)\n",
+            (unsigned long long)frames, wall, wall > 0 ? frames / wall : 0.0,
+            recorded, wall > 0 ? recorded / wall : 0.0);
+    fprintf(stderr, "%-18s %10s %12s %10s\n", "Stage", "calls", "cpu ms", "us/call");
+    int64_t total_ns = 0;
+    for (int i = 0; i < STAGE_COUNT; ++i) {
+        total_ns += stage_ns[i];
+        fprintf(stderr, "%-18s %10llu %12.1f %10.2f\n", stage_names[i],
+                (unsigned long long)stage_calls[i], stage_ns[i] / 1e6,
+                stage_calls[i] ? stage_ns[i] / 1e3 / stage_calls[i] : 0.0);
+    }
+    fprintf(stderr, "%-18s %10s %12.1f %10.2f per frame\n", "total", "", total_ns / 1e6,
+            frames ? total_ns / 1e3 / frames : 0.0);
+    fprintf(stderr, "ACAP events fired: %d\n", Replay_ACAP_Events_Fired());
+    Replay_MQTT_Report(stderr);
+
+    if (output) fclose(output);
+    if (reader.file) fclose(reader.file);
+    free(reader.payload);
+    free(detector);
+    cJSON_Delete(info);
+    Replay_Subscriber_Cleanup();
+    MQTT_Cleanup();
+    ACAP_Cleanup();
+    return 0;
+}
@@ -0,0 +1,62 @@
+/*------------------------------------------------------------------
+ *  Replay.h
+ *  Offline replay of scene recordings (see Recorder.h).
+ *
+ *  The replay binary links the DataQ pipeline unchanged and replaces
+ *  the camera services with local stand-ins:
+ *    ReplaySubscriber.c  video-object-detection subscriber, fed from the file
+ *    ReplayACAP.c        ACAP wrapper: settings, status, device, events
+ *    ReplayMQTT.c        broker: published messages go to a digest
+ *  Fred Juhlin (2025)
+ *------------------------------------------------------------------*/
+
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include "cJSON.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Pipeline stages timed by the replay. Times are thread CPU time,
+// exclusive of nested stages.
+typedef enum {
+    STAGE_INGEST,           // Subscriber callback: record tap, decode, queue
+    STAGE_VOD,              // VOD processing thread outside VOD_Data
+    STAGE_OBJECTDETECTION,  // VOD_Data
+    STAGE_TRACKER,          // Tracker_Data incl. anomaly and ProcessPaths
+    STAGE_DETECTIONS,       // Detections_Data incl. occupancy
+    STAGE_STITCH,           // Stitch_Path
+    STAGE_PUBLISH,          // Payload serialization
+    STAGE_COUNT
+} replay_stage_t;
+
+void     Replay_Stage_Enter(replay_stage_t stage);
+void     Replay_Stage_Exit(replay_stage_t stage);
+void     Replay_Stage_Add(replay_stage_t stage, int64_t ns);
+int64_t  Replay_Thread_CPU(void);
+
+// ReplaySubscriber.c
+void     Replay_Subscriber_Setup(cJSON *classes, const uint8_t *detector, size_t detector_size);
+int      Replay_Subscriber_Deliver(const uint8_t *data, size_t size);
+void     Replay_Subscriber_Cleanup(void);
+
+// ReplayACAP.c
+void     Replay_ACAP_Setup(const char *settings_file, const char *serial);
+void     Replay_ACAP_Set_Time(double epoch_ms);
+int      Replay_ACAP_Events_Fired(void);
+
+// ReplayMQTT.c
+void     Replay_MQTT_Output(FILE *file);     // Optional JSON lines log of all messages
+void     Replay_MQTT_Message(const char *topic, const char *payload);
+void     Replay_MQTT_Report(FILE *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // REPLAY_H
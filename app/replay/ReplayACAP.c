@@ -0,0 +1,407 @@
+/*------------------------------------------------------------------
+ *  ReplayACAP.c
+ *  Stand-in for the ACAP wrapper when replaying a recording.
+ *  Settings come from a local file, status is kept in memory, HTTP and
+ *  VAPIX are inert, and device time follows the recording.
+ *  Fred Juhlin (2025)
+ *------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <glib.h>
+#include "ACAP.h"
+#include "Replay.h"
+
+static cJSON *app = NULL;
+static cJSON *status_container = NULL;
+static cJSON *device = NULL;
+static pthread_mutex_t status_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t time_mutex = PTHREAD_MUTEX_INITIALIZER;
+static char settings_path[256] = "settings/settings.json";
+static double replay_time_ms = 0;
+static double replay_start_ms = 0;
+static ACAP_EVENTS_Callback events_callback = NULL;
+static volatile gint events_fired = 0;
+
+void Replay_ACAP_Setup(const char *settings_file, const char *serial) {
+    if (settings_file)
+        snprintf(settings_path, sizeof(settings_path), "%s", settings_file);
+    cJSON_Delete(device);
+    device = cJSON_CreateObject();
+    cJSON_AddStringToObject(device, "serial", serial && serial[0] ? serial : "REPLAY");
+    cJSON_AddStringToObject(device, "model", "Replay");
+    cJSON_AddStringToObject(device, "IPv4", "127.0.0.1");
+    cJSON_AddStringToObject(device, "aspect", "16:9");
+}
+
+void Replay_ACAP_Set_Time(double epoch_ms) {
+    pthread_mutex_lock(&time_mutex);
+    if (replay_start_ms == 0) replay_start_ms = epoch_ms;
+    replay_time_ms = epoch_ms;
+    pthread_mutex_unlock(&time_mutex);
+}
+
+int Replay_ACAP_Events_Fired(void) {
+    return g_atomic_int_get(&events_fired);
+}
+
+/*-----------------------------------------------------
+ * Core
+ *-----------------------------------------------------*/
+
+const char* ACAP_Version(void) { return ACAP_VERSION; }
+const char* ACAP_Name(void) { return "DataQ"; }
+
+cJSON* ACAP_Init(const char* package, ACAP_Config_Update updateCallback) {
+    app = cJSON_CreateObject();
+    cJSON* settings = ACAP_FILE_Read(settings_path);
+    if (!settings) {
+        fprintf(stderr, "Replay: Unable to read %s, using empty settings\n", settings_path);
+        settings = cJSON_CreateObject();
+    }
+    cJSON_AddItemToObject(app, "settings", settings);
+    status_container = cJSON_CreateObject();
+    if (!device) Replay_ACAP_Setup(NULL, NULL);
+
+    if (updateCallback) {
+        for (cJSON* setting = settings->child; setting; setting = setting->next)
+            updateCallback(setting->string, setting);
+    }
+    return settings;
+}
+
+int ACAP_Set_Config(const char* service, cJSON* serviceSettings) {
+    if (!app || !service) return 0;
+    if (cJSON_GetObjectItem(app, service))
+        cJSON_ReplaceItemInObject(app, service, serviceSettings);
+    else
+        cJSON_AddItemToObject(app, service, serviceSettings);
+    return 1;
+}
+
+cJSON* ACAP_Get_Config(const char* service) {
+    return app ? cJSON_GetObjectItem(app, service) : NULL;
+}
+
+void ACAP_Cleanup(void) {
+    cJSON_Delete(app);
+    cJSON_Delete(status_container);
+    cJSON_Delete(device);
+    app = status_container = device = NULL;
+}
+
+/*-----------------------------------------------------
+ * HTTP, inert
+ *-----------------------------------------------------*/
+
+int ACAP_HTTP_Node(const char* nodename, ACAP_HTTP_Callback callback) { return 1; }
+const char* ACAP_HTTP_Get_Method(const ACAP_HTTP_Request request) { return NULL; }
+const char* ACAP_HTTP_Get_Content_Type(const ACAP_HTTP_Request request) { return NULL; }
+size_t ACAP_HTTP_Get_Content_Length(const ACAP_HTTP_Request request) { return 0; }
+const char* ACAP_HTTP_Get_Body(const ACAP_HTTP_Request request) { return NULL; }
+size_t ACAP_HTTP_Get_Body_Length(const ACAP_HTTP_Request request) { return 0; }
+char* ACAP_HTTP_Request_Param(const ACAP_HTTP_Request request, const char* param) { return NULL; }
+cJSON* ACAP_HTTP_Request_JSON(const ACAP_HTTP_Request request, const char* param) { return NULL; }
+int ACAP_HTTP_Header_XML(ACAP_HTTP_Response response) { return 1; }
+int ACAP_HTTP_Header_JSON(ACAP_HTTP_Response response) { return 1; }
+int ACAP_HTTP_Header_TEXT(ACAP_HTTP_Response response) { return 1; }
+int ACAP_HTTP_Header_FILE(ACAP_HTTP_Response response, const char* filename,
+                          const char* contenttype, unsigned filelength) { return 1; }
+int ACAP_HTTP_Respond_String(ACAP_HTTP_Response response, const char* fmt, ...) { return 1; }
+int ACAP_HTTP_Respond_JSON(ACAP_HTTP_Response response, cJSON* object) { return 1; }
+int ACAP_HTTP_Respond_Data(ACAP_HTTP_Response response, size_t count, const void* data) { return 1; }
+int ACAP_HTTP_Respond_Error(ACAP_HTTP_Response response, int code, const char* message) { return 1; }
+int ACAP_HTTP_Respond_Text(ACAP_HTTP_Response response, const char* message) { return 1; }
+
+/*-----------------------------------------------------
+ * Events. Fired states are logged as "event" messages.
+ *-----------------------------------------------------*/
+
+int ACAP_EVENTS_Add_Event(const char* Id, const char* NiceName, int state) { return 1; }
+int ACAP_EVENTS_Add_Event_JSON(cJSON* event) { return 1; }
+int ACAP_EVENTS_Remove_Event(const char* Id) { return 1; }
+
+int ACAP_EVENTS_Fire_State(const char* Id, int value) {
+    if (value && ACAP_STATUS_Bool("events", Id))
+        return 1;
+    if (!value && !ACAP_STATUS_Bool("events", Id))
+        return 1;
+    ACAP_STATUS_SetBool("events", Id, value);
+    char topic[128];
+    snprintf(topic, sizeof(topic), "acap-event/%s", Id);
+    Replay_MQTT_Message(topic, value ? "{\"state\":true}" : "{\"state\":false}");
+    g_atomic_int_inc(&events_fired);
+    return 1;
+}
+
+int ACAP_EVENTS_Fire(const char* Id) {
+    char topic[128];
+    snprintf(topic, sizeof(topic), "acap-event/%s", Id);
+    Replay_MQTT_Message(topic, "{}");
+    g_atomic_int_inc(&events_fired);
+    return 1;
+}
+
+int ACAP_EVENTS_Fire_JSON(const char* Id, cJSON* data) {
+    char topic[128];
+    snprintf(topic, sizeof(topic), "acap-event/%s", Id);
+    char *json = data ? cJSON_PrintUnformatted(data) : NULL;
+    Replay_MQTT_Message(topic, json ? json : "{}");
+    free(json);
+    g_atomic_int_inc(&events_fired);
+    return 1;
+}
+
+int ACAP_EVENTS_SetCallback(ACAP_EVENTS_Callback callback) {
+    events_callback = callback;
+    return 1;
+}
+
+int ACAP_EVENTS_Subscribe(cJSON* eventDeclaration, void* user_data) { return 1; }
+int ACAP_EVENTS_Unsubscribe(int id) { return 1; }
+
+/*-----------------------------------------------------
+ * Files, relative to the working directory
+ *-----------------------------------------------------*/
+
+const char* ACAP_FILE_AppPath(void) { return "./"; }
+
+FILE* ACAP_FILE_Open(const char* filepath, const char* mode) {
+    return filepath ? fopen(filepath, mode) : NULL;
+}
+
+int ACAP_FILE_Delete(const char* filepath) {
+    return filepath && remove(filepath) == 0;
+}
+
+cJSON* ACAP_FILE_Read(const char* filepath) {
+    FILE* file = ACAP_FILE_Open(filepath, "r");
+    if (!file) return NULL;
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    char* data = size > 0 ? malloc(size + 1) : NULL;
+    cJSON* object = NULL;
+    if (data && fread(data, 1, size, file) == (size_t)size) {
+        data[size] = '\0';
+        object = cJSON_Parse(data);
+    }
+    free(data);
+    fclose(file);
+    return object;
+}
+
+int ACAP_FILE_Write(const char* filepath, cJSON* object) {
+    char* json = object ? cJSON_Print(object) : NULL;
+    int ok = json && ACAP_FILE_WriteData(filepath, json);
+    free(json);
+    return ok;
+}
+
+int ACAP_FILE_WriteData(const char* filepath, const char* data) {
+    FILE* file = ACAP_FILE_Open(filepath, "w");
+    if (!file || !data) {
+        if (file) fclose(file);
+        return 0;
+    }
+    int ok = fputs(data, file) >= 0;
+    fclose(file);
+    return ok;
+}
+
+int ACAP_FILE_Exists(const char* filepath) {
+    FILE* file = ACAP_FILE_Open(filepath, "r");
+    if (!file) return 0;
+    fclose(file);
+    return 1;
+}
+
+/*-----------------------------------------------------
+ * Device. Time is the recording's time.
+ *-----------------------------------------------------*/
+
+double ACAP_DEVICE_Longitude(void) { return 0; }
+double ACAP_DEVICE_Latitude(void) { return 0; }
+int ACAP_DEVICE_Set_Location(double lat, double lon) { return 1; }
+
+const char* ACAP_DEVICE_Prop(const char* name) {
+    cJSON* item = device ? cJSON_GetObjectItem(device, name) : NULL;
+    return (item && cJSON_IsString(item)) ? item->valuestring : NULL;
+}
+
+int ACAP_DEVICE_Prop_Int(const char* name) {
+    cJSON* item = device ? cJSON_GetObjectItem(device, name) : NULL;
+    return (item && cJSON_IsNumber(item)) ? item->valueint : 0;
+}
+
+cJSON* ACAP_DEVICE_JSON(const char* name) {
+    return device ? cJSON_GetObjectItem(device, name) : NULL;
+}
+
+double ACAP_DEVICE_Timestamp(void) {
+    pthread_mutex_lock(&time_mutex);
+    double now = replay_time_ms;
+    pthread_mutex_unlock(&time_mutex);
+    return now;
+}
+
+static struct tm replay_local_time(void) {
+    time_t t = (time_t)(ACAP_DEVICE_Timestamp() / 1000.0);
+    struct tm tm;
+    localtime_r(&t, &tm);
+    return tm;
+}
+
+int ACAP_DEVICE_Seconds_Since_Midnight(void) {
+    struct tm tm = replay_local_time();
+    return tm.tm_hour * 3600 + tm.tm_min * 60 + tm.tm_sec;
+}
+
+static char time_buffer[64];
+
+const char* ACAP_DEVICE_Local_Time(void) {
+    struct tm tm = replay_local_time();
+    strftime(time_buffer, sizeof(time_buffer), "%Y-%m-%d %H:%M:%S", &tm);
+    return time_buffer;
+}
+
+const char* ACAP_DEVICE_ISOTime(void) {
+    struct tm tm = replay_local_time();
+    strftime(time_buffer, sizeof(time_buffer), "%Y-%m-%dT%H:%M:%S%z", &tm);
+    return time_buffer;
+}
+
+const char* ACAP_DEVICE_Date(void) {
+    struct tm tm = replay_local_time();
+    strftime(time_buffer, sizeof(time_buffer), "%Y-%m-%d", &tm);
+    return time_buffer;
+}
+
+const char* ACAP_DEVICE_Time(void) {
+    struct tm tm = replay_local_time();
+    strftime(time_buffer, sizeof(time_buffer), "%H:%M:%S", &tm);
+    return time_buffer;
+}
+
+double ACAP_DEVICE_Uptime(void) {
+    return (ACAP_DEVICE_Timestamp() - replay_start_ms) / 1000.0;
+}
+
+double ACAP_DEVICE_CPU_Average(void) { return 0; }
+double ACAP_DEVICE_Network_Average(void) { return 0; }
+
+/*-----------------------------------------------------
+ * Status, in memory
+ *-----------------------------------------------------*/
+
+// Called with status_mutex held
+static cJSON* status_group(const char* name) {
+    if (!name || !status_container) return NULL;
+    cJSON* group = cJSON_GetObjectItem(status_container, name);
+    if (!group) {
+        group = cJSON_CreateObject();
+        cJSON_AddItemToObject(status_container, name, group);
+    }
+    return group;
+}
+
+cJSON* ACAP_STATUS_Group(const char* name) {
+    pthread_mutex_lock(&status_mutex);
+    cJSON* group = status_group(name);
+    pthread_mutex_unlock(&status_mutex);
+    return group;
+}
+
+static void status_set_item(const char* group, const char* name, cJSON* value) {
+    pthread_mutex_lock(&status_mutex);
+    cJSON* groupObj = status_group(group);
+    if (groupObj && name && value) {
+        cJSON_DeleteItemFromObject(groupObj, name);
+        cJSON_AddItemToObject(groupObj, name, value);
+    } else {
+        cJSON_Delete(value);
+    }
+    pthread_mutex_unlock(&status_mutex);
+}
+
+void ACAP_STATUS_SetBool(const char* group, const char* name, int state) {
+    status_set_item(group, name, cJSON_CreateBool(state));
+}
+
+void ACAP_STATUS_SetNumber(const char* group, const char* name, double value) {
+    status_set_item(group, name, cJSON_CreateNumber(value));
+}
+
+void ACAP_STATUS_SetString(const char* group, const char* name, const char* string) {
+    if (string) status_set_item(group, name, cJSON_CreateString(string));
+}
+
+void ACAP_STATUS_SetObject(const char* group, const char* name, cJSON* data) {
+    if (data) status_set_item(group, name, cJSON_Duplicate(data, 1));
+}
+
+void ACAP_STATUS_SetNull(const char* group, const char* name) {
+    status_set_item(group, name, cJSON_CreateNull());
+}
+
+void ACAP_STATUS_Append(const char* group, const char* name, cJSON* item, int max) {
+    pthread_mutex_lock(&status_mutex);
+    cJSON* groupObj = name && item ? status_group(group) : NULL;
+    cJSON* list = groupObj ? cJSON_GetObjectItem(groupObj, name) : NULL;
+    if (groupObj && !cJSON_IsArray(list)) {
+        cJSON_DeleteItemFromObject(groupObj, name);
+        list = cJSON_CreateArray();
+        cJSON_AddItemToObject(groupObj, name, list);
+    }
+    if (list) {
+        cJSON_AddItemToArray(list, item);
+        while (max > 0 && cJSON_GetArraySize(list) > max)
+            cJSON_DeleteItemFromArray(list, 0);
+    } else {
+        cJSON_Delete(item);
+    }
+    pthread_mutex_unlock(&status_mutex);
+}
+
+int ACAP_STATUS_Bool(const char* group, const char* name) {
+    pthread_mutex_lock(&status_mutex);
+    cJSON* item = cJSON_GetObjectItem(status_group(group), name);
+    int value = (item && item->type == cJSON_True) ? 1 : 0;
+    pthread_mutex_unlock(&status_mutex);
+    return value;
+}
+
+int ACAP_STATUS_Int(const char* group, const char* name) {
+    pthread_mutex_lock(&status_mutex);
+    cJSON* item = cJSON_GetObjectItem(status_group(group), name);
+    int value = (item && cJSON_IsNumber(item)) ? item->valueint : 0;
+    pthread_mutex_unlock(&status_mutex);
+    return value;
+}
+
+double ACAP_STATUS_Double(const char* group, const char* name) {
+    pthread_mutex_lock(&status_mutex);
+    cJSON* item = cJSON_GetObjectItem(status_group(group), name);
+    double value = (item && cJSON_IsNumber(item)) ? item->valuedouble : 0.0;
+    pthread_mutex_unlock(&status_mutex);
+    return value;
+}
+
+char* ACAP_STATUS_String(const char* group, const char* name) {
+    cJSON* item = cJSON_GetObjectItem(ACAP_STATUS_Group(group), name);
+    return (item && cJSON_IsString(item)) ? item->valuestring : NULL;
+}
+
+cJSON* ACAP_STATUS_Object(const char* group, const char* name) {
+    return cJSON_GetObjectItem(ACAP_STATUS_Group(group), name);
+}
+
+/*-----------------------------------------------------
+ * VAPIX, unavailable
+ *-----------------------------------------------------*/
+
+char* ACAP_VAPIX_Get(const char* request) { return NULL; }
+char* ACAP_VAPIX_Post(const char* request, const char* body) { return NULL; }
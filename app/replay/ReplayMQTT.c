@@ -0,0 +1,133 @@
+/*------------------------------------------------------------------
+ *  ReplayMQTT.c
+ *  Stand-in broker for replay. Payloads are serialized exactly as by
+ *  MQTT.c and folded into a digest (FNV-1a 64 over topic and payload,
+ *  in publish order) so two runs can be compared.
+ *  Fred Juhlin (2025)
+ *------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "MQTT.h"
+#include "ACAP.h"
+#include "Replay.h"
+
+#define REPLAY_MAX_TOPICS 16
+
+typedef struct {
+    char name[32];
+    unsigned count;
+    unsigned long long bytes;
+} topic_count_t;
+
+static pthread_mutex_t digest_mutex = PTHREAD_MUTEX_INITIALIZER;
+static uint64_t digest = 0xcbf29ce484222325ULL;
+static unsigned messages = 0;
+static topic_count_t topics[REPLAY_MAX_TOPICS];
+static int num_topics = 0;
+static FILE *output = NULL;
+static cJSON *settings = NULL;
+
+static uint64_t fnv1a(uint64_t hash, const char *data, size_t size) {
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= (unsigned char)data[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+void Replay_MQTT_Output(FILE *file) {
+    output = file;
+}
+
+void Replay_MQTT_Message(const char *topic, const char *payload) {
+    size_t topic_len = strlen(topic);
+    size_t payload_len = strlen(payload);
+    // Count by topic name, without the serial suffix
+    const char *slash = strchr(topic, '/');
+    size_t name_len = slash ? (size_t)(slash - topic) : topic_len;
+    if (strncmp(topic, "acap-event/", 11) == 0) name_len = topic_len;
+
+    pthread_mutex_lock(&digest_mutex);
+    digest = fnv1a(digest, topic, topic_len + 1);
+    digest = fnv1a(digest, payload, payload_len + 1);
+    messages++;
+    int i;
+    for (i = 0; i < num_topics; ++i)
+        if (strlen(topics[i].name) == name_len && strncmp(topics[i].name, topic, name_len) == 0)
+            break;
+    if (i == num_topics && num_topics < REPLAY_MAX_TOPICS) {
+        snprintf(topics[i].name, sizeof(topics[i].name), "%.*s", (int)name_len, topic);
+        num_topics++;
+    }
+    if (i < num_topics) {
+        topics[i].count++;
+        topics[i].bytes += payload_len;
+    }
+    if (output)
+        fprintf(output, "{\"topic\":\"%s\",\"payload\":%s}\n", topic, payload);
+    pthread_mutex_unlock(&digest_mutex);
+}
+
+void Replay_MQTT_Report(FILE *out) {
+    pthread_mutex_lock(&digest_mutex);
+    fprintf(out, "Published %u messages, digest %016llx\n", messages, (unsigned long long)digest);
+    for (int i = 0; i < num_topics; ++i)
+        fprintf(out, "  %-24s %8u messages %10llu bytes\n", topics[i].name, topics[i].count, topics[i].bytes);
+    pthread_mutex_unlock(&digest_mutex);
+}
+
+int MQTT_Init(MQTT_Callback_Connection stateCallback, MQTT_Callback_Message messageCallback) {
+    settings = cJSON_CreateObject();
+    return 1;
+}
+
+void MQTT_Cleanup() {
+    cJSON_Delete(settings);
+    settings = NULL;
+}
+
+cJSON* MQTT_Settings() {
+    return settings;
+}
+
+int MQTT_Publish(const char *topic, const char *payload, int qos, int retained) {
+    if (!topic || !payload) return 0;
+    Replay_MQTT_Message(topic, payload);
+    return 1;
+}
+
+int MQTT_Publish_Writer(const char *topic, json_writer_t *payload, int qos, int retained) {
+    if (!payload || payload->failed) return 0;
+    Replay_Stage_Enter(STAGE_PUBLISH);
+    char suffix[128];
+    size_t length = 0;
+    const char* serial = ACAP_DEVICE_Prop("serial");
+    if (serial) {
+        memcpy(suffix, ",\"serial\":", 10);
+        length = JsonWriter_Quote(suffix + 10, sizeof(suffix) - 10, serial);
+        if (length) length += 10;
+    }
+    JsonWriter_Object_Extend(payload, suffix, length);
+    int result = !payload->failed;
+    if (result)
+        Replay_MQTT_Message(topic, payload->data);
+    Replay_Stage_Exit(STAGE_PUBLISH);
+    return result;
+}
+
+int MQTT_Publish_JSON(const char *topic, cJSON *payload, int qos, int retained) {
+    if (!payload) return 0;
+    json_writer_t *writer = JsonWriter_Thread();
+    JsonWriter_JSON(writer, payload);
+    return MQTT_Publish_Writer(topic, writer, qos, retained);
+}
+
+int MQTT_Publish_Binary(const char *topic, int payloadlen, void *payload, int qos, int retained) {
+    return 1;
+}
+
+int MQTT_Subscribe(const char *topic) { return 1; }
+int MQTT_Unsubscribe(const char *topic) { return 1; }
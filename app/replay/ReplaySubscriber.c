@@ -0,0 +1,163 @@
+/*------------------------------------------------------------------
+ *  ReplaySubscriber.c
+ *  Stand-in for the video-object-detection subscriber library.
+ *  Classes and detector information come from the recording header;
+ *  scene payloads are delivered by the replay loop.
+ *  Fred Juhlin (2025)
+ *------------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include <string.h>
+#include "video_object_detection_subscriber.h"
+#include "Replay.h"
+
+struct video_object_detection_subscriber_class_st {
+    int id;
+    char *name;
+};
+
+struct video_object_detection_subscriber_st {
+    void *user_data;
+    int channel;
+    bool subscribed;
+    video_object_detection_subscriber_get_detection_callback_t callback;
+};
+
+static cJSON *replay_classes = NULL;
+static uint8_t *replay_detector = NULL;
+static size_t replay_detector_size = 0;
+static video_object_detection_subscriber_t *active = NULL;
+
+void Replay_Subscriber_Setup(cJSON *classes, const uint8_t *detector, size_t detector_size) {
+    Replay_Subscriber_Cleanup();
+    replay_classes = cJSON_Duplicate(classes, 1);
+    replay_detector = malloc(detector_size ? detector_size : 1);
+    if (replay_detector && detector_size)
+        memcpy(replay_detector, detector, detector_size);
+    replay_detector_size = detector_size;
+}
+
+void Replay_Subscriber_Cleanup(void) {
+    cJSON_Delete(replay_classes);
+    free(replay_detector);
+    replay_classes = NULL;
+    replay_detector = NULL;
+    replay_detector_size = 0;
+}
+
+int Replay_Subscriber_Deliver(const uint8_t *data, size_t size) {
+    if (!active || !active->subscribed || !active->callback) return 0;
+    active->callback(data, size, active->user_data);
+    return 1;
+}
+
+int video_object_detection_subscriber_create(video_object_detection_subscriber_t **subscriber,
+                                             void *user_data, int channel) {
+    *subscriber = calloc(1, sizeof(**subscriber));
+    if (!*subscriber) return VIDEO_OBJECT_DETECTION_SUBSCRIBER_ERROR_GENERAL;
+    (*subscriber)->user_data = user_data;
+    (*subscriber)->channel = channel;
+    active = *subscriber;
+    return VIDEO_OBJECT_DETECTION_SUBSCRIBER_SUCCESS;
+}
+
+int video_object_detection_subscriber_delete(video_object_detection_subscriber_t **subscriber) {
+    if (!subscriber || !*subscriber) return VIDEO_OBJECT_DETECTION_SUBSCRIBER_ERROR_GENERAL;
+    if (active == *subscriber) active = NULL;
+    free(*subscriber);
+    *subscriber = NULL;
+    return VIDEO_OBJECT_DETECTION_SUBSCRIBER_SUCCESS;
+}
+
+int video_object_detection_subscriber_subscribe(video_object_detection_subscriber_t *const subscriber) {
+    subscriber->subscribed = true;
+    return VIDEO_OBJECT_DETECTION_SUBSCRIBER_SUCCESS;
+}
+
+int video_object_detection_subscriber_unsubscribe(video_object_detection_subscriber_t *const subscriber) {
+    subscriber->subscribed = false;
+    return VIDEO_OBJECT_DETECTION_SUBSCRIBER_SUCCESS;
+}
+
+int video_object_detection_subscriber_set_get_detection_callback(video_object_detection_subscriber_t *subscriber,
+        video_object_detection_subscriber_get_detection_callback_t callback) {
+    subscriber->callback = callback;
+    return VIDEO_OBJECT_DETECTION_SUBSCRIBER_SUCCESS;
+}
+
+int video_object_detection_subscriber_set_teardown_callback(video_object_detection_subscriber_t *subscriber,
+        video_object_detection_subscriber_teardown_callback_t callback) {
+    return VIDEO_OBJECT_DETECTION_SUBSCRIBER_SUCCESS;
+}
+
+int video_object_detection_subscriber_set_receive_empty_hits(video_object_detection_subscriber_t *subscriber,
+                                                             bool receive_empty_hits) {
+    return VIDEO_OBJECT_DETECTION_SUBSCRIBER_SUCCESS;
+}
+
+int video_object_detection_subscriber_get_version(int *vod_version_major, int *vod_version_minor) {
+    *vod_version_major = 1;
+    *vod_version_minor = 0;
+    return VIDEO_OBJECT_DETECTION_SUBSCRIBER_SUCCESS;
+}
+
+int video_object_detection_subscriber_get_nbr_channels(int *nbr_channels) {
+    *nbr_channels = 1;
+    return VIDEO_OBJECT_DETECTION_SUBSCRIBER_SUCCESS;
+}
+
+int video_object_detection_subscriber_get_nbr_channels_simultaneously(int *nbr_channels_simultaneously) {
+    *nbr_channels_simultaneously = 1;
+    return VIDEO_OBJECT_DETECTION_SUBSCRIBER_SUCCESS;
+}
+
+const char *video_object_detection_subscriber_det_class_name(const video_object_detection_subscriber_class_t *det_class) {
+    return det_class ? det_class->name : NULL;
+}
+
+int video_object_detection_subscriber_det_class_id(const video_object_detection_subscriber_class_t *det_class) {
+    return det_class ? det_class->id : -1;
+}
+
+int video_object_detection_subscriber_det_classes_get(video_object_detection_subscriber_class_t **det_classes[]) {
+    int count = cJSON_GetArraySize(replay_classes);
+    *det_classes = NULL;
+    if (count <= 0) return 0;
+    *det_classes = calloc(count, sizeof(video_object_detection_subscriber_class_t *));
+    if (!*det_classes) return VIDEO_OBJECT_DETECTION_SUBSCRIBER_ERROR_GENERAL;
+    int i = 0;
+    for (cJSON *item = replay_classes->child; item; item = item->next, ++i) {
+        cJSON *id = cJSON_GetObjectItem(item, "id");
+        cJSON *name = cJSON_GetObjectItem(item, "name");
+        video_object_detection_subscriber_class_t *cls = calloc(1, sizeof(*cls));
+        if (!cls) continue;
+        cls->id = cJSON_IsNumber(id) ? id->valueint : -1;
+        cls->name = strdup(cJSON_IsString(name) ? name->valuestring : "");
+        (*det_classes)[i] = cls;
+    }
+    return count;
+}
+
+void video_object_detection_subscriber_det_classes_free(video_object_detection_subscriber_class_t *det_classes[],
+                                                        int num_classes) {
+    if (!det_classes) return;
+    for (int i = 0; i < num_classes; ++i) {
+        if (!det_classes[i]) continue;
+        free(det_classes[i]->name);
+        free(det_classes[i]);
+    }
+    free(det_classes);
+}
+
+int video_object_detection_subscriber_get_detector_information(uint8_t **buffer, size_t *size) {
+    if (!replay_detector) return VIDEO_OBJECT_DETECTION_SUBSCRIBER_ERROR_NO_VALID_VOD;
+    *buffer = malloc(replay_detector_size ? replay_detector_size : 1);
+    if (!*buffer) return VIDEO_OBJECT_DETECTION_SUBSCRIBER_ERROR_GENERAL;
+    memcpy(*buffer, replay_detector, replay_detector_size);
+    *size = replay_detector_size;
+    return VIDEO_OBJECT_DETECTION_SUBSCRIBER_SUCCESS;
+}
+
+bool video_object_detection_subscriber_running(video_object_detection_subscriber_t *subscriber) {
+    return subscriber && subscriber->subscribed;
+}
@@ -0,0 +1,492 @@
+/*------------------------------------------------------------------
+ *  SceneGen.c
+ *  Synthetic crowd generator, see SceneGen.h.
+ *
+ *  Positions are kept as box centers in 0..1 image coordinates, y down,
+ *  and converted to the detector's -1..1 (y up) coordinates when packed.
+ *  Protobuf messages are preallocated and reused for every frame.
+ *  Fred Juhlin (2025)
+ *------------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <math.h>
+#include "video_object_detection.pb-c.h"
+#include "SceneGen.h"
+
+#define SCENEGEN_MAX_ATTRS   4
+#define SCENEGEN_MARGIN      0.02f   // Objects this far outside the view are gone
+#define SCENEGEN_UNCONFIDENT 2       // First frames of a track are unconfident
+#define SCENEGEN_ATTR_DELAY  3       // Attributes appear after this many frames
+
+const char *const SceneGen_Class_Names[SCENEGEN_CLASSES] = {
+    "human", "car", "truck", "bus", "motorcycle_bicycle"
+};
+
+const char *const SceneGen_Motion_Names[SCENEGEN_MOTIONS] = {
+    "walk", "loiter", "cross", "occlude"
+};
+
+/*-----------------------------------------------------
+ * Detector model
+ *-----------------------------------------------------*/
+
+enum { ATTR_VEHICLE_COLOR, ATTR_UPPER_COLOR, ATTR_LOWER_COLOR, ATTR_HAT, ATTR_BAG, ATTR_TYPES };
+
+typedef struct {
+    uint32_t id;
+    const char *name;
+    const char *const *classes;
+    int num_classes;
+} attr_type_t;
+
+static const char *const colors[] = { "red", "blue", "black", "white", "gray", "green", "yellow", "beige" };
+static const char *const hats[] = { "no_hat", "hard_hat", "hat_other" };
+static const char *const bags[] = { "backpack", "suitcase", "bag_other" };
+
+static const attr_type_t attr_types[ATTR_TYPES] = {
+    { 1, "vehicle_color",        colors, 8 },
+    { 2, "clothing_upper_color", colors, 8 },
+    { 3, "clothing_lower_color", colors, 8 },
+    { 4, "hat_type",             hats,   3 },
+    { 5, "bag_type",             bags,   3 }
+};
+
+typedef struct {
+    float w, h;                 // Box size at the bottom of the view
+    float speed_min, speed_max; // View widths per second
+    int   attrs[SCENEGEN_MAX_ATTRS];
+    int   num_attrs;
+} class_model_t;
+
+static const class_model_t class_models[SCENEGEN_CLASSES] = {
+    { 0.025f, 0.09f, 0.03f, 0.08f, { ATTR_UPPER_COLOR, ATTR_LOWER_COLOR, ATTR_HAT, ATTR_BAG }, 4 },
+    { 0.09f,  0.06f, 0.10f, 0.30f, { ATTR_VEHICLE_COLOR }, 1 },
+    { 0.15f,  0.09f, 0.08f, 0.20f, { ATTR_VEHICLE_COLOR }, 1 },
+    { 0.20f,  0.10f, 0.06f, 0.15f, { ATTR_VEHICLE_COLOR }, 1 },
+    { 0.03f,  0.06f, 0.08f, 0.18f, { ATTR_VEHICLE_COLOR }, 1 }
+};
+
+/*-----------------------------------------------------
+ * State
+ *-----------------------------------------------------*/
+
+typedef struct {
+    uint32_t id;
+    uint8_t  cls;
+    uint8_t  motion;
+    float    x, y;          // Box center
+    float    vx, vy;
+    float    ax, ay;        // Loiter anchor
+    float    age, life;     // Seconds
+    uint32_t frames;        // Frames the object was reported in
+    uint32_t score;
+    uint32_t attr_class[SCENEGEN_MAX_ATTRS];
+    uint32_t attr_score[SCENEGEN_MAX_ATTRS];
+} gen_object_t;
+
+struct scenegen {
+    scenegen_config_t config;
+    uint64_t rng;
+    uint32_t next_id;
+    int class_total;
+    int motion_total;
+    bool occluder;
+    scenegen_stats_t stats;
+    gen_object_t objects[SCENEGEN_MAX_OBJECTS];
+
+    VOD__Detection detections[SCENEGEN_MAX_OBJECTS];
+    VOD__Detection *detection_list[SCENEGEN_MAX_OBJECTS];
+    VOD__Attribute attributes[SCENEGEN_MAX_OBJECTS * SCENEGEN_MAX_ATTRS];
+    VOD__Attribute *attribute_list[SCENEGEN_MAX_OBJECTS * SCENEGEN_MAX_ATTRS];
+    VOD__Event events[SCENEGEN_MAX_OBJECTS];
+    VOD__Event *event_list[SCENEGEN_MAX_OBJECTS];
+    uint8_t *buffer;
+    size_t capacity;
+};
+
+// splitmix64
+static uint64_t next_random(scenegen_t *gen) {
+    uint64_t z = (gen->rng += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static float uniform(scenegen_t *gen, float lo, float hi) {
+    return lo + (hi - lo) * (float)((next_random(gen) >> 40) / (double)(1ULL << 24));
+}
+
+static uint32_t pick(scenegen_t *gen, uint32_t count) {
+    return (uint32_t)(next_random(gen) % count);
+}
+
+static int pick_weighted(scenegen_t *gen, const int *weights, int count, int total) {
+    int r = (int)pick(gen, (uint32_t)total);
+    for (int i = 0; i < count; ++i) {
+        if (r < weights[i]) return i;
+        r -= weights[i];
+    }
+    return 0;
+}
+
+static bool in_occluder(const scenegen_t *gen, float x, float y) {
+    const float *o = gen->config.occluder;
+    return gen->occluder && x >= o[0] && x <= o[2] && y >= o[1] && y <= o[3];
+}
+
+/*-----------------------------------------------------
+ * Configuration
+ *-----------------------------------------------------*/
+
+void SceneGen_Defaults(scenegen_config_t *config) {
+    memset(config, 0, sizeof(*config));
+    config->objects = 50;
+    config->fps = 10;
+    config->lifetime = 30;
+    config->churn = 0.05;
+    config->seed = 1;
+    config->class_weight[SCENEGEN_HUMAN] = 60;
+    config->class_weight[SCENEGEN_CAR] = 25;
+    config->class_weight[SCENEGEN_TRUCK] = 5;
+    config->class_weight[SCENEGEN_BUS] = 3;
+    config->class_weight[SCENEGEN_BIKE] = 7;
+    config->motion_weight[SCENEGEN_WALK] = 40;
+    config->motion_weight[SCENEGEN_LOITER] = 20;
+    config->motion_weight[SCENEGEN_CROSS] = 30;
+    config->motion_weight[SCENEGEN_OCCLUDE] = 10;
+    config->occluder[0] = 0.40f;
+    config->occluder[1] = 0.35f;
+    config->occluder[2] = 0.60f;
+    config->occluder[3] = 0.65f;
+    config->start_timestamp = 1000000000ULL;
+}
+
+int SceneGen_Parse_Mix(const char *spec, const char *const names[], int count, int *weights) {
+    if (!spec) return 0;
+    for (int i = 0; i < count; ++i)
+        weights[i] = 0;
+    const char *p = spec;
+    while (*p) {
+        const char *sep = strpbrk(p, ":=");
+        if (!sep) return 0;
+        size_t len = (size_t)(sep - p);
+        int i;
+        for (i = 0; i < count; ++i)
+            if (strlen(names[i]) == len && strncmp(names[i], p, len) == 0)
+                break;
+        if (i == count) return 0;
+        char *end;
+        long weight = strtol(sep + 1, &end, 10);
+        if (end == sep + 1 || weight < 0) return 0;
+        weights[i] = (int)weight;
+        p = *end == ',' ? end + 1 : end;
+        if (*end && *end != ',') return 0;
+    }
+    return 1;
+}
+
+/*-----------------------------------------------------
+ * Births and motion
+ *-----------------------------------------------------*/
+
+// A point on a random edge and a unit direction into the view
+static void edge_start(scenegen_t *gen, float *x, float *y, float *dx, float *dy) {
+    float along = uniform(gen, 0.05f, 0.95f);
+    float skew = uniform(gen, -0.3f, 0.3f);
+    switch (pick(gen, 4)) {
+        case 0:  *x = -SCENEGEN_MARGIN / 2;    *y = along; *dx = 1;     *dy = skew; break;
+        case 1:  *x = 1 + SCENEGEN_MARGIN / 2; *y = along; *dx = -1;    *dy = skew; break;
+        case 2:  *x = along; *y = -SCENEGEN_MARGIN / 2;    *dx = skew;  *dy = 1;    break;
+        default: *x = along; *y = 1 + SCENEGEN_MARGIN / 2; *dx = skew;  *dy = -1;   break;
+    }
+    float norm = sqrtf(*dx * *dx + *dy * *dy);
+    *dx /= norm;
+    *dy /= norm;
+}
+
+static void spawn(scenegen_t *gen, gen_object_t *obj, bool initial) {
+    const scenegen_config_t *config = &gen->config;
+    memset(obj, 0, sizeof(*obj));
+    obj->id = gen->next_id++;
+    obj->cls = (uint8_t)pick_weighted(gen, config->class_weight, SCENEGEN_CLASSES, gen->class_total);
+    obj->motion = (uint8_t)pick_weighted(gen, config->motion_weight, SCENEGEN_MOTIONS, gen->motion_total);
+    if (obj->motion == SCENEGEN_OCCLUDE && !gen->occluder)
+        obj->motion = SCENEGEN_CROSS;
+
+    const class_model_t *model = &class_models[obj->cls];
+    float speed = uniform(gen, model->speed_min, model->speed_max);
+    float dx, dy;
+    edge_start(gen, &obj->x, &obj->y, &dx, &dy);
+
+    if (obj->motion == SCENEGEN_OCCLUDE) {
+        // Aim at a point behind the occluder
+        const float *o = config->occluder;
+        float tx = uniform(gen, o[0], o[2]), ty = uniform(gen, o[1], o[3]);
+        if (initial) {
+            // Somewhere on the way in, outside the occluder
+            float t = uniform(gen, 0.0f, 0.8f);
+            obj->x += (tx - obj->x) * t;
+            obj->y += (ty - obj->y) * t;
+        }
+        dx = tx - obj->x;
+        dy = ty - obj->y;
+        float norm = sqrtf(dx * dx + dy * dy);
+        if (norm > 0) { dx /= norm; dy /= norm; }
+    } else if (initial || obj->motion == SCENEGEN_LOITER) {
+        obj->x = uniform(gen, 0.05f, 0.95f);
+        obj->y = uniform(gen, 0.05f, 0.95f);
+    }
+    if (obj->motion == SCENEGEN_LOITER) {
+        obj->ax = obj->x;
+        obj->ay = obj->y;
+        speed *= 0.3f;
+    }
+    obj->vx = dx * speed;
+    obj->vy = dy * speed;
+
+    obj->life = (float)(-log(1.0 - uniform(gen, 0.0f, 0.999f)) * config->lifetime);
+    if (obj->life < 1.0f) obj->life = 1.0f;
+    obj->score = (uint32_t)uniform(gen, 55, 95);
+    for (int a = 0; a < model->num_attrs; ++a) {
+        obj->attr_class[a] = pick(gen, (uint32_t)attr_types[model->attrs[a]].num_classes);
+        obj->attr_score[a] = (uint32_t)uniform(gen, 40, 95);
+    }
+    gen->stats.births++;
+}
+
+// Returns false when the object has died
+static bool move(scenegen_t *gen, gen_object_t *obj, float dt) {
+    obj->age += dt;
+    if (obj->age >= obj->life) return false;
+
+    switch (obj->motion) {
+        case SCENEGEN_WALK: {
+            float turn = uniform(gen, -1.0f, 1.0f) * dt;
+            float c = cosf(turn), s = sinf(turn);
+            float vx = obj->vx * c - obj->vy * s;
+            obj->vy = obj->vx * s + obj->vy * c;
+            obj->vx = vx;
+            break;
+        }
+        case SCENEGEN_LOITER:
+            obj->vx += ((obj->ax - obj->x) * 0.8f + uniform(gen, -0.05f, 0.05f)) * dt;
+            obj->vy += ((obj->ay - obj->y) * 0.8f + uniform(gen, -0.05f, 0.05f)) * dt;
+            obj->vx *= 1.0f - 0.5f * dt;
+            obj->vy *= 1.0f - 0.5f * dt;
+            break;
+        default:
+            break;
+    }
+    obj->x += obj->vx * dt;
+    obj->y += obj->vy * dt;
+    return obj->x >= -SCENEGEN_MARGIN && obj->x <= 1 + SCENEGEN_MARGIN &&
+           obj->y >= -SCENEGEN_MARGIN && obj->y <= 1 + SCENEGEN_MARGIN;
+}
+
+static uint32_t jitter(scenegen_t *gen, uint32_t value, uint32_t lo, uint32_t hi) {
+    int v = (int)value + (int)pick(gen, 5) - 2;
+    return v < (int)lo ? lo : v > (int)hi ? hi : (uint32_t)v;
+}
+
+static float clip(float v) {
+    return v < -1.0f ? -1.0f : v > 1.0f ? 1.0f : v;
+}
+
+/*-----------------------------------------------------
+ * Frames
+ *-----------------------------------------------------*/
+
+scenegen_t* SceneGen_Create(const scenegen_config_t *config) {
+    scenegen_t *gen = calloc(1, sizeof(*gen));
+    if (!gen) return NULL;
+    gen->config = *config;
+    if (gen->config.objects < 1) gen->config.objects = 1;
+    if (gen->config.objects > SCENEGEN_MAX_OBJECTS) gen->config.objects = SCENEGEN_MAX_OBJECTS;
+    if (gen->config.fps < 1) gen->config.fps = 1;
+    if (gen->config.lifetime < 1) gen->config.lifetime = 1;
+    for (int i = 0; i < SCENEGEN_CLASSES; ++i)
+        gen->class_total += gen->config.class_weight[i];
+    for (int i = 0; i < SCENEGEN_MOTIONS; ++i)
+        gen->motion_total += gen->config.motion_weight[i];
+    if (gen->class_total <= 0 || gen->motion_total <= 0) {
+        free(gen);
+        return NULL;
+    }
+    const float *o = gen->config.occluder;
+    gen->occluder = o[2] > o[0] && o[3] > o[1];
+    gen->rng = gen->config.seed;
+    gen->next_id = 1;
+
+    for (int i = 0; i < SCENEGEN_MAX_OBJECTS; ++i) {
+        vod__detection__init(&gen->detections[i]);
+        vod__event__init(&gen->events[i]);
+        gen->events[i].action = VOD__EVENT_ACTION__EVENT_DELETE;
+        gen->event_list[i] = &gen->events[i];
+    }
+    for (int i = 0; i < SCENEGEN_MAX_OBJECTS * SCENEGEN_MAX_ATTRS; ++i) {
+        vod__attribute__init(&gen->attributes[i]);
+        gen->attributes[i].has_class_case = VOD__ATTRIBUTE__HAS_CLASS_ATTR_CLASS;
+        gen->attributes[i].has_score_case = VOD__ATTRIBUTE__HAS_SCORE_SCORE;
+        gen->attribute_list[i] = &gen->attributes[i];
+    }
+    for (int i = 0; i < gen->config.objects; ++i)
+        spawn(gen, &gen->objects[i], true);
+    gen->stats.births = 0;  // The initial population is not counted
+    return gen;
+}
+
+void SceneGen_Free(scenegen_t *gen) {
+    if (!gen) return;
+    free(gen->buffer);
+    free(gen);
+}
+
+size_t SceneGen_Next(scenegen_t *gen, const uint8_t **payload) {
+    const float dt = 1.0f / gen->config.fps;
+    size_t num_detections = 0, num_attributes = 0, num_events = 0;
+
+    for (int i = 0; i < gen->config.objects; ++i) {
+        gen_object_t *obj = &gen->objects[i];
+        if (gen->stats.frames > 0 && !move(gen, obj, dt)) {
+            gen->events[num_events++].object_id = (int32_t)obj->id;
+            gen->stats.deaths++;
+            spawn(gen, obj, false);
+        }
+        if (in_occluder(gen, obj->x, obj->y)) {
+            gen->stats.hidden++;
+            continue;
+        }
+
+        const class_model_t *model = &class_models[obj->cls];
+        float scale = 0.6f + 0.8f * obj->y;   // Larger closer to the camera
+        float hw = model->w * scale / 2, hh = model->h * scale / 2;
+        VOD__Detection *det = &gen->detections[num_detections];
+        // Boxes are clipped to the view, as by the detector
+        det->left = clip((obj->x - hw) * 2 - 1);
+        det->right = clip((obj->x + hw) * 2 - 1);
+        det->top = clip(1 - (obj->y - hh) * 2);
+        det->bottom = clip(1 - (obj->y + hh) * 2);
+        det->id = obj->id;
+        det->det_class = obj->cls;
+        obj->score = jitter(gen, obj->score, 30, 99);
+        det->score = obj->score;
+        det->detection_status = obj->frames < SCENEGEN_UNCONFIDENT ?
+            VOD__DETECTION__DETECTION_STATUS__TRACKED_UNCONFIDENT :
+            VOD__DETECTION__DETECTION_STATUS__TRACKED_CONFIDENT;
+
+        det->n_attributes = 0;
+        det->attributes = &gen->attribute_list[num_attributes];
+        if (obj->frames >= SCENEGEN_ATTR_DELAY) {
+            for (int a = 0; a < model->num_attrs; ++a) {
+                const attr_type_t *type = &attr_types[model->attrs[a]];
+                if (uniform(gen, 0, 1) < gen->config.churn * dt) {
+                    obj->attr_class[a] = pick(gen, (uint32_t)type->num_classes);
+                    obj->attr_score[a] = (uint32_t)uniform(gen, 40, 95);
+                } else {
+                    obj->attr_score[a] = jitter(gen, obj->attr_score[a], 10, 99);
+                }
+                VOD__Attribute *attr = &gen->attributes[num_attributes++];
+                attr->type = type->id;
+                attr->attr_class = obj->attr_class[a];
+                attr->score = obj->attr_score[a];
+                det->n_attributes++;
+            }
+        }
+        obj->frames++;
+        gen->detection_list[num_detections++] = det;
+    }
+
+    VOD__Scene scene = VOD__SCENE__INIT;
+    scene.timestamp = gen->config.start_timestamp + gen->stats.frames * 1000000ULL / gen->config.fps;
+    scene.n_detections = num_detections;
+    scene.detections = gen->detection_list;
+    scene.n_events = num_events;
+    scene.events = gen->event_list;
+
+    size_t size = vod__scene__get_packed_size(&scene);
+    if (size > gen->capacity) {
+        uint8_t *grown = realloc(gen->buffer, size);
+        if (!grown) return 0;
+        gen->buffer = grown;
+        gen->capacity = size;
+    }
+    vod__scene__pack(&scene, gen->buffer);
+    gen->stats.frames++;
+    gen->stats.detections += num_detections;
+    gen->stats.attributes += num_attributes;
+    *payload = gen->buffer;
+    return size;
+}
+
+int64_t SceneGen_Time(const scenegen_t *gen) {
+    if (!gen->stats.frames) return 0;
+    return (int64_t)((gen->stats.frames - 1) * 1000000ULL / gen->config.fps);
+}
+
+void SceneGen_Stats(const scenegen_t *gen, scenegen_stats_t *stats) {
+    *stats = gen->stats;
+}
+
+/*-----------------------------------------------------
+ * Detector description
+ *-----------------------------------------------------*/
+
+int SceneGen_Detector(uint8_t **buffer, size_t *size) {
+    VOD__ObjectClass classes[SCENEGEN_CLASSES];
+    VOD__ObjectClass *class_list[SCENEGEN_CLASSES];
+    uint32_t class_attrs[SCENEGEN_CLASSES][SCENEGEN_MAX_ATTRS];
+    VOD__AttributeType types[ATTR_TYPES];
+    VOD__AttributeType *type_list[ATTR_TYPES];
+    VOD__AttributeClass values[ATTR_TYPES][8];
+    VOD__AttributeClass *value_list[ATTR_TYPES][8];
+
+    for (int c = 0; c < SCENEGEN_CLASSES; ++c) {
+        vod__object_class__init(&classes[c]);
+        classes[c].id = (uint32_t)c;
+        classes[c].name = (char *)SceneGen_Class_Names[c];
+        for (int a = 0; a < class_models[c].num_attrs; ++a)
+            class_attrs[c][a] = attr_types[class_models[c].attrs[a]].id;
+        classes[c].n_attribute_type_ids = (size_t)class_models[c].num_attrs;
+        classes[c].attribute_type_ids = class_attrs[c];
+        class_list[c] = &classes[c];
+    }
+    for (int t = 0; t < ATTR_TYPES; ++t) {
+        vod__attribute_type__init(&types[t]);
+        types[t].id = attr_types[t].id;
+        types[t].name = (char *)attr_types[t].name;
+        for (int v = 0; v < attr_types[t].num_classes; ++v) {
+            vod__attribute_class__init(&values[t][v]);
+            values[t][v].id = (uint32_t)v;
+            values[t][v].name = (char *)attr_types[t].classes[v];
+            value_list[t][v] = &values[t][v];
+        }
+        types[t].n_classes = (size_t)attr_types[t].num_classes;
+        types[t].classes = value_list[t];
+        type_list[t] = &types[t];
+    }
+
+    VOD__DetectorInformation info = VOD__DETECTOR_INFORMATION__INIT;
+    info.n_classes = SCENEGEN_CLASSES;
+    info.classes = class_list;
+    info.n_attribute_types = ATTR_TYPES;
+    info.attribute_types = type_list;
+
+    *size = vod__detector_information__get_packed_size(&info);
+    *buffer = malloc(*size ? *size : 1);
+    if (!*buffer) return 0;
+    vod__detector_information__pack(&info, *buffer);
+    return 1;
+}
+
+cJSON* SceneGen_Classes(void) {
+    cJSON *classes = cJSON_CreateArray();
+    for (int c = 0; c < SCENEGEN_CLASSES; ++c) {
+        cJSON *cls = cJSON_CreateObject();
+        cJSON_AddNumberToObject(cls, "id", c);
+        cJSON_AddStringToObject(cls, "name", SceneGen_Class_Names[c]);
+        cJSON_AddItemToArray(classes, cls);
+    }
+    return classes;
+}
@@ -0,0 +1,105 @@
+/*------------------------------------------------------------------
+ *  SceneGen.h
+ *  Synthetic crowd generator. Emits packed VOD.Scene frames with a
+ *  configurable population for scaling benchmarks beyond what a live
+ *  camera produces.
+ *
+ *  The population is kept at the configured size: objects die when
+ *  their lifetime runs out or they leave the view (a DELETE event is
+ *  emitted) and a new track id is born in their place. Objects inside
+ *  the occluder region are not reported while hidden but keep their id.
+ *  The same seed and configuration always give the same frames.
+ *  Fred Juhlin (2025)
+ *------------------------------------------------------------------*/
+
+#ifndef SCENEGEN_H
+#define SCENEGEN_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "cJSON.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SCENEGEN_MAX_OBJECTS 500
+
+// Detector class ids, as reported in the generated detector information
+typedef enum {
+    SCENEGEN_HUMAN,
+    SCENEGEN_CAR,
+    SCENEGEN_TRUCK,
+    SCENEGEN_BUS,
+    SCENEGEN_BIKE,
+    SCENEGEN_CLASSES
+} scenegen_class_t;
+
+typedef enum {
+    SCENEGEN_WALK,      // Wanders with slowly changing heading
+    SCENEGEN_LOITER,    // Random walk around a fixed point
+    SCENEGEN_CROSS,     // Straight line from one edge to the opposite
+    SCENEGEN_OCCLUDE,   // Crosses behind the occluder region
+    SCENEGEN_MOTIONS
+} scenegen_motion_t;
+
+extern const char *const SceneGen_Class_Names[SCENEGEN_CLASSES];
+extern const char *const SceneGen_Motion_Names[SCENEGEN_MOTIONS];
+
+typedef struct {
+    int      objects;                           // Live objects, 1..SCENEGEN_MAX_OBJECTS
+    int      fps;                               // Frames per second
+    double   lifetime;                          // Mean track lifetime in seconds
+    double   churn;                             // Attribute changes per object attribute and second
+    uint32_t seed;
+    int      class_weight[SCENEGEN_CLASSES];
+    int      motion_weight[SCENEGEN_MOTIONS];
+    float    occluder[4];                       // x1,y1,x2,y2 in 0..1, y down. Empty disables
+    uint64_t start_timestamp;                   // Scene.timestamp of the first frame, microseconds
+} scenegen_config_t;
+
+typedef struct {
+    uint64_t frames;
+    uint64_t detections;
+    uint64_t attributes;
+    uint64_t hidden;        // Detections suppressed by the occluder
+    uint64_t births;
+    uint64_t deaths;
+} scenegen_stats_t;
+
+typedef struct scenegen scenegen_t;
+
+void        SceneGen_Defaults(scenegen_config_t *config);
+
+/**
+ * Parse a weight list such as "human:60,car:30,bus:10" into weights.
+ * Names not in the list get weight 0.
+ * @return 1 on success, 0 on unknown name or malformed entry.
+ */
+int         SceneGen_Parse_Mix(const char *spec, const char *const names[], int count, int *weights);
+
+scenegen_t* SceneGen_Create(const scenegen_config_t *config);
+void        SceneGen_Free(scenegen_t *gen);
+
+/**
+ * Advance one frame and pack it.
+ * @param payload  Set to the packed VOD.Scene, valid until the next call.
+ * @return Payload size, 0 on allocation failure.
+ */
+size_t      SceneGen_Next(scenegen_t *gen, const uint8_t **payload);
+
+// Time of the last generated frame relative to the first, microseconds
+int64_t     SceneGen_Time(const scenegen_t *gen);
+void        SceneGen_Stats(const scenegen_t *gen, scenegen_stats_t *stats);
+
+// Packed VOD.DetectorInformation for the generated classes. Caller frees.
+int         SceneGen_Detector(uint8_t **buffer, size_t *size);
+
+// Class list as [{id,name}], as written in a recording's INFO record
+cJSON*      SceneGen_Classes(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SCENEGEN_H
@@ -0,0 +1,170 @@
+/*------------------------------------------------------------------
+ *  SceneGenMain.c
+ *  Writes a synthetic crowd (see SceneGen.h) as a scene recording that
+ *  dataq-replay can run through the pipeline.
+ *
+ *  dataq-scenegen [-n objects] [-d seconds] [-f fps] [-l lifetime]
+ *                 [-a churn] [-c classes] [-m motions] [-z x1,y1,x2,y2]
+ *                 [-s seed] [-o file.dqr]
+ *  Fred Juhlin (2025)
+ *------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include "cJSON.h"
+#include "Recorder.h"
+#include "SceneGen.h"
+
+static void usage(const char *name) {
+    fprintf(stderr,
+        "Usage: %s [options]\n"
+        "  -n objects   Live objects, 1..%d (default 50)\n"
+        "  -d seconds   Duration (default 60)\n"
+        "  -f fps       Frames per second (default 10)\n"
+        "  -l seconds   Mean track lifetime (default 30)\n"
+        "  -a rate      Attribute changes per attribute and second (default 0.05)\n"
+        "  -c mix       Class mix, e.g. human:60,car:25,truck:5,bus:3,motorcycle_bicycle:7\n"
+        "  -m mix       Motion mix, e.g. walk:40,loiter:20,cross:30,occlude:10\n"
+        "  -z x1,y1,x2,y2  Occluder region in 0..1, y down. 0,0,0,0 disables\n"
+        "  -s seed      Random seed (default 1)\n"
+        "  -o file      Output recording (default synthetic.dqr)\n",
+        name, SCENEGEN_MAX_OBJECTS);
+}
+
+static int write_record(FILE *file, uint32_t type, int64_t time_us, const void *payload, size_t size) {
+    recorder_record_t header = { type, (uint32_t)size, time_us };
+    return fwrite(&header, sizeof(header), 1, file) == 1 &&
+           (size == 0 || fwrite(payload, size, 1, file) == 1);
+}
+
+static char *build_info(const scenegen_config_t *config, int seconds) {
+    time_t now = time(NULL);
+    struct tm local;
+    localtime_r(&now, &local);
+    char started[32];
+    strftime(started, sizeof(started), "%Y-%m-%dT%H:%M:%S%z", &local);
+
+    cJSON *info = cJSON_CreateObject();
+    cJSON_AddNumberToObject(info, "channel", 0);
+    cJSON_AddFalseToObject(info, "predictions");
+    cJSON_AddItemToObject(info, "classes", SceneGen_Classes());
+    cJSON_AddNumberToObject(info, "version", 1);
+    cJSON_AddStringToObject(info, "serial", "SYNTHETIC");
+    cJSON_AddStringToObject(info, "started", started);
+    cJSON_AddNumberToObject(info, "timestamp", (double)now * 1000.0);
+
+    cJSON *generator = cJSON_AddObjectToObject(info, "generator");
+    cJSON_AddNumberToObject(generator, "objects", config->objects);
+    cJSON_AddNumberToObject(generator, "seconds", seconds);
+    cJSON_AddNumberToObject(generator, "fps", config->fps);
+    cJSON_AddNumberToObject(generator, "lifetime", config->lifetime);
+    cJSON_AddNumberToObject(generator, "churn", config->churn);
+    cJSON_AddNumberToObject(generator, "seed", config->seed);
+    cJSON *classes = cJSON_AddObjectToObject(generator, "classes");
+    for (int i = 0; i < SCENEGEN_CLASSES; ++i)
+        cJSON_AddNumberToObject(classes, SceneGen_Class_Names[i], config->class_weight[i]);
+    cJSON *motions = cJSON_AddObjectToObject(generator, "motions");
+    for (int i = 0; i < SCENEGEN_MOTIONS; ++i)
+        cJSON_AddNumberToObject(motions, SceneGen_Motion_Names[i], config->motion_weight[i]);
+    cJSON *occluder = cJSON_AddArrayToObject(generator, "occluder");
+    for (int i = 0; i < 4; ++i)
+        cJSON_AddItemToArray(occluder, cJSON_CreateNumber(config->occluder[i]));
+
+    char *json = cJSON_PrintUnformatted(info);
+    cJSON_Delete(info);
+    return json;
+}
+
+int main(int argc, char **argv) {
+    scenegen_config_t config;
+    SceneGen_Defaults(&config);
+    int seconds = 60, opt;
+    const char *output_file = "synthetic.dqr";
+
+    while ((opt = getopt(argc, argv, "n:d:f:l:a:c:m:z:s:o:h")) != -1) {
+        switch (opt) {
+            case 'n': config.objects = atoi(optarg); break;
+            case 'd': seconds = atoi(optarg); break;
+            case 'f': config.fps = atoi(optarg); break;
+            case 'l': config.lifetime = atof(optarg); break;
+            case 'a': config.churn = atof(optarg); break;
+            case 's': config.seed = (uint32_t)strtoul(optarg, NULL, 10); break;
+            case 'o': output_file = optarg; break;
+            case 'c':
+                if (!SceneGen_Parse_Mix(optarg, SceneGen_Class_Names, SCENEGEN_CLASSES, config.class_weight)) {
+                    fprintf(stderr, "Invalid class mix: %s\n", optarg);
+                    return 2;
+                }
+                break;
+            case 'm':
+                if (!SceneGen_Parse_Mix(optarg, SceneGen_Motion_Names, SCENEGEN_MOTIONS, config.motion_weight)) {
+                    fprintf(stderr, "Invalid motion mix: %s\n", optarg);
+                    return 2;
+                }
+                break;
+            case 'z':
+                if (sscanf(optarg, "%f,%f,%f,%f", &config.occluder[0], &config.occluder[1],
+                           &config.occluder[2], &config.occluder[3]) != 4) {
+                    fprintf(stderr, "Invalid occluder: %s\n", optarg);
+                    return 2;
+                }
+                break;
+            default:
+                usage(argv[0]);
+                return 2;
+        }
+    }
+    if (config.objects < 1 || config.objects > SCENEGEN_MAX_OBJECTS || seconds <= 0 || config.fps <= 0) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    scenegen_t *gen = SceneGen_Create(&config);
+    if (!gen) {
+        fprintf(stderr, "Class and motion mix need at least one non-zero weight\n");
+        return 2;
+    }
+    FILE *file = fopen(output_file, "wb");
+    if (!file) {
+        fprintf(stderr, "Unable to create %s\n", output_file);
+        SceneGen_Free(gen);
+        return 1;
+    }
+
+    uint8_t *detector = NULL;
+    size_t detector_size = 0;
+    char *info = build_info(&config, seconds);
+    int ok = info && SceneGen_Detector(&detector, &detector_size) &&
+             fwrite(RECORDER_MAGIC, RECORDER_MAGIC_SIZE, 1, file) == 1 &&
+             write_record(file, RECORDER_INFO, 0, info, strlen(info)) &&
+             write_record(file, RECORDER_DETECTOR, 0, detector, detector_size);
+
+    long frames = (long)seconds * config.fps;
+    for (long i = 0; ok && i < frames; ++i) {
+        const uint8_t *payload;
+        size_t size = SceneGen_Next(gen, &payload);
+        ok = size > 0 && write_record(file, RECORDER_SCENE, SceneGen_Time(gen), payload, size);
+    }
+    long bytes = ftell(file);
+    if (fclose(file) != 0) ok = 0;
+    free(info);
+    free(detector);
+
+    scenegen_stats_t stats;
+    SceneGen_Stats(gen, &stats);
+    SceneGen_Free(gen);
+    if (!ok) {
+        fprintf(stderr, "Failed writing %s\n", output_file);
+        return 1;
+    }
+    fprintf(stderr, "%s: %llu frames, %llu detections (%.1f per frame), %llu attributes, "
+                    "%llu hidden, %llu births, %llu deaths, %ld bytes\n",
+            output_file, (unsigned long long)stats.frames, (unsigned long long)stats.detections,
+            stats.frames ? (double)stats.detections / stats.frames : 0.0,
+            (unsigned long long)stats.attributes, (unsigned long long)stats.hidden,
+            (unsigned long long)stats.births, (unsigned long long)stats.deaths, bytes);
+    return 0;
+}